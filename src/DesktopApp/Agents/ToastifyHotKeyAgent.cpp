@@ -14,15 +14,13 @@ namespace desktop { namespace ui { namespace agent {
 	ToastifyHotKeyAgent::ToastifyHotKeyAgent(CefBrowser& browser)
 	: m_browser(browser)
 	{
-		m_subscriber.subscribe([this](const desktop::core::utils::patterns::Event& rawEvt)
+		m_subscriber.subscribe<events::ToastifyEvent>("ToastifyHotKeyAgent", [this](const events::ToastifyEvent& evt)
 		{
-			auto evt = static_cast<const events::ToastifyEvent&>(rawEvt);
-
 			std::stringstream ss;
 			ss << "$(document).trigger('toastify', '" << evt.m_code << "');";
 
 			m_browser.GetMainFrame()->ExecuteJavaScript(ss.str(), "", 0);
-		}, events::TOASTIFY_EVENT);
+		}, desktop::core::utils::patterns::DeliveryPolicy::ui());
 
 	}
 
@@ -10,7 +10,7 @@ namespace desktop { namespace ui { namespace events {
 	
 	namespace sup = core::utils::patterns;
 	
-	const sup::EventType DOWNLOAD_STATUS_EVENT = "DOWNLOAD_STATUS_EVENT";
+	constexpr sup::EventType DOWNLOAD_STATUS_EVENT = sup::makeEventType("DOWNLOAD_STATUS_EVENT");
 	struct DownloadStatusEvent : public sup::Event
 	{
 		DownloadStatusEvent()
@@ -29,7 +29,7 @@ namespace desktop { namespace ui { namespace events {
 		std::string m_path;
 	};
 
-	const sup::EventType BROWSER_LOAD_END_EVENT = "BROWSER_LOAD_END_EVENT";
+	constexpr sup::EventType BROWSER_LOAD_END_EVENT = sup::makeEventType("BROWSER_LOAD_END_EVENT");
 	struct BrowserLoadEndEvent : public sup::Event
 	{
 		BrowserLoadEndEvent()
@@ -38,7 +38,7 @@ namespace desktop { namespace ui { namespace events {
 		}
 	};
 
-	const sup::EventType BROWSER_CREATED_EVENT = "BROWSER_CREATED_EVENT";
+	constexpr sup::EventType BROWSER_CREATED_EVENT = sup::makeEventType("BROWSER_CREATED_EVENT");
 	struct BrowserCreatedEvent : public sup::Event
 	{
 		BrowserCreatedEvent(CefBrowser& browser)
@@ -50,7 +50,7 @@ namespace desktop { namespace ui { namespace events {
 		CefBrowser& m_browser;
 	};
 
-	const sup::EventType TOASTIFY_EVENT = "TOASTIFY_EVENT";
+	constexpr sup::EventType TOASTIFY_EVENT = sup::makeEventType("TOASTIFY_EVENT");
 	struct ToastifyEvent : public sup::Event
 	{
 		ToastifyEvent(long code)
@@ -22,29 +22,34 @@
 namespace desktop { namespace ui { namespace service {
 
 	DownloadDesktopService::DownloadDesktopService(CefBrowser& browser, std::unique_ptr<core::service::EncodeStringService> encodeService,
-											std::unique_ptr<core::service::ApplicationDataService> applicationService)
+											std::unique_ptr<core::service::ApplicationDataService> applicationService,
+											std::unique_ptr<core::service::IDownloadFileService> fileService)
 	: m_browser(browser)
 	, m_encodeService(std::move(encodeService))
 	, m_applicationService(std::move(applicationService))
+	, m_fileService(std::move(fileService))
 	{
-		m_subscriber.subscribe([this](const desktop::core::utils::patterns::Event& rawEvt)
+		// Delivered on the worker thread of the download status channel of ClientHandler, so it
+		// only touches what download() reads under m_mutex
+		m_subscriber.subscribe<events::DownloadStatusEvent>("DownloadDesktopService", [this](const events::DownloadStatusEvent& evt)
 		{
-			auto evt = static_cast<const events::DownloadStatusEvent&>(rawEvt);
-
 			if (evt.bIsComplete)
 			{
-				m_path = evt.m_path;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+
+					m_path = evt.m_path;
+					m_completed = true;
+				}
 
 				m_cv.notify_one();
 			}
 
-		}, events::DOWNLOAD_STATUS_EVENT);
+		});
 
-		m_subscriber.subscribe([this](const core::utils::patterns::Event& rawEvt)
+		m_subscriber.subscribe<core::events::DownloadUpgradeEvent>("DownloadDesktopService", [this](const core::events::DownloadUpgradeEvent& /*evt*/)
 		{
-			/*auto evt = static_cast<const core::events::DownloadUpgradeEvent&>(rawEvt);
-
-			auto version = m_encodeService->utf8toUtf16(evt.m_version);
+			/*auto version = m_encodeService->utf8toUtf16(evt.m_version);
 			
 			toast::ToastFactory factory;
 			
@@ -61,27 +66,55 @@ namespace desktop { namespace ui { namespace service {
 			agent::NotificationAgent::ShowNotificationEvent notificationEvt(m_toast, m_handler);
 			core::utils::patterns::Broker::get().publish(notificationEvt);*/
 
-		}, core::events::DOWNLOAD_UPGRADE_EVENT);
+		});
 
-		m_subscriber.subscribe([this](const desktop::core::utils::patterns::Event& rawEvt)
+		m_subscriber.subscribe<desktop::core::events::UpgradeDesktopCompletedEvent>("DownloadDesktopService", [this](const desktop::core::events::UpgradeDesktopCompletedEvent& /*evt*/)
 		{
 			//m_browser->GetMainFrame()->LoadURL(boost::filesystem::canonical(m_applicationService->getViewerFolder() + "/index.html").string());
-		}, desktop::core::events::UPGRADE_DESKTOP_COMPLETED_EVENT);
+		});
 	}
 
 	DownloadDesktopService::~DownloadDesktopService() = default;
 
-	std::string DownloadDesktopService::download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &/*folder*/) const
+	std::string DownloadDesktopService::download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &/*folder*/,
+											const core::utils::runtime::CancellationToken& token) const
 	{
 		auto pos = url.find(host) + host.size();
 
 		std::string script = "window.location = 'https://" + host + url.substr(pos) + "';";
 
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_completed = false;
+		}
+
 		m_browser.GetMainFrame()->ExecuteJavaScript(script, m_browser.GetMainFrame()->GetURL(), 0);
 
+		// The browser keeps downloading after a cancel; we only stop waiting for it
+		auto registration = token.onCancel([this]()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.notify_one();
+		});
+
 		std::unique_lock<std::mutex> lock(m_mutex);
-		m_cv.wait(lock);
 
-		return m_path;
+		m_cv.wait(lock, [this, &token]()
+		{
+			return m_completed || token.cancelled();
+		});
+
+		return m_completed ? m_path : "";
+	}
+
+	bool DownloadDesktopService::canStream() const
+	{
+		return m_fileService->canStream();
+	}
+
+	bool DownloadDesktopService::stream(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, SinkType sink,
+										const core::utils::runtime::CancellationToken& token) const
+	{
+		return m_fileService->stream(host, url, requestHeaders, sink, token);
 	}
 }}}
\ No newline at end of file
@@ -24,28 +24,33 @@
 namespace desktop { namespace ui { namespace service {
 
 	DownloadViewerService::DownloadViewerService(CefBrowser& browser, std::unique_ptr<core::service::EncodeStringService> encodeService,
-											std::unique_ptr<core::service::ApplicationDataService> applicationService)
+											std::unique_ptr<core::service::ApplicationDataService> applicationService,
+											std::unique_ptr<core::service::IDownloadFileService> fileService)
 	: m_browser(browser)
 	, m_encodeService(std::move(encodeService))
 	, m_applicationService(std::move(applicationService))
+	, m_fileService(std::move(fileService))
 	{
-		m_subscriber.subscribe([this](const desktop::core::utils::patterns::Event& rawEvt)
+		// Delivered on the worker thread of the download status channel of ClientHandler, so it
+		// only touches what download() reads under m_mutex
+		m_subscriber.subscribe<events::DownloadStatusEvent>("DownloadViewerService", [this](const events::DownloadStatusEvent& evt)
 		{
-			auto evt = static_cast<const events::DownloadStatusEvent&>(rawEvt);
-
 			if (evt.bIsComplete)
 			{
-				m_path = evt.m_path;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+
+					m_path = evt.m_path;
+					m_completed = true;
+				}
 
 				m_cv.notify_one();
 			}
 
-		}, events::DOWNLOAD_STATUS_EVENT);
+		});
 
-		m_subscriber.subscribe([this](const desktop::core::utils::patterns::Event& rawEvt)
+		m_subscriber.subscribe<desktop::core::events::UpgradeViewerCompletedEvent>("DownloadViewerService", [this](const desktop::core::events::UpgradeViewerCompletedEvent& evt)
 		{
-			auto evt = static_cast<const desktop::core::events::UpgradeViewerCompletedEvent&>(rawEvt);
-			
 			if (!evt.m_fresh)
 			{
 				std::stringstream ss;
@@ -57,22 +62,50 @@ namespace desktop { namespace ui { namespace service {
 			{ 
 				m_browser.GetMainFrame()->LoadURL(boost::filesystem::canonical(m_applicationService->getViewerFolder() + "/index.html").string());
 			}
-		}, desktop::core::events::UPGRADE_VIEWER_COMPLETED_EVENT);
+		}, desktop::core::utils::patterns::DeliveryPolicy::ui());
 	}
 
 	DownloadViewerService::~DownloadViewerService() = default;
 
-	std::string DownloadViewerService::download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &/*folder*/) const
+	std::string DownloadViewerService::download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &/*folder*/,
+											const core::utils::runtime::CancellationToken& token) const
 	{
 		auto pos = url.find(host) + host.size();
 
 		std::string script = "window.location = 'https://" + host + url.substr(pos) + "';";
 
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_completed = false;
+		}
+
 		m_browser.GetMainFrame()->ExecuteJavaScript(script, m_browser.GetMainFrame()->GetURL(), 0);
 
+		// The browser keeps downloading after a cancel; we only stop waiting for it
+		auto registration = token.onCancel([this]()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.notify_one();
+		});
+
 		std::unique_lock<std::mutex> lock(m_mutex);
-		m_cv.wait(lock);
 
-		return m_path;
+		m_cv.wait(lock, [this, &token]()
+		{
+			return m_completed || token.cancelled();
+		});
+
+		return m_completed ? m_path : "";
+	}
+
+	bool DownloadViewerService::canStream() const
+	{
+		return m_fileService->canStream();
+	}
+
+	bool DownloadViewerService::stream(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, SinkType sink,
+									const core::utils::runtime::CancellationToken& token) const
+	{
+		return m_fileService->stream(host, url, requestHeaders, sink, token);
 	}
 }}}
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "DesktopCore\System\Services\EncodeStringService.h"
 #include "DesktopCore\System\Services\ApplicationDataService.h"
 #include "DesktopCore\Network\Services\IDownloadFileService.h"
+#include "DesktopCore\Network\Services\DownloadFileService.h"
 
 #include <mutex>
 #include <memory>
@@ -39,9 +40,16 @@ namespace desktop {
 	public:
 		DownloadViewerService(CefBrowser& browser,
 							std::unique_ptr<core::service::EncodeStringService> encodeService = std::make_unique<core::service::EncodeStringService>(),
-							std::unique_ptr<core::service::ApplicationDataService> applicationService = std::make_unique<core::service::ApplicationDataService>());
+							std::unique_ptr<core::service::ApplicationDataService> applicationService = std::make_unique<core::service::ApplicationDataService>(),
+							std::unique_ptr<core::service::IDownloadFileService> fileService = std::make_unique<core::service::DownloadFileService>());
 		~DownloadViewerService();
-		std::string download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder) const override;
+		std::string download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder,
+							const core::utils::runtime::CancellationToken& token = core::utils::runtime::CancellationToken()) const override;
+
+		// Streaming bypasses the browser, which can only save the file
+		bool canStream() const override;
+		bool stream(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, SinkType sink,
+					const core::utils::runtime::CancellationToken& token = core::utils::runtime::CancellationToken()) const override;
 	private:
 		CefBrowser&	m_browser;
 		cup::Subscriber			m_subscriber;
@@ -50,9 +58,11 @@ namespace desktop {
 
 		std::unique_ptr<core::service::EncodeStringService> m_encodeService;
 		std::unique_ptr<core::service::ApplicationDataService> m_applicationService;
+		std::unique_ptr<core::service::IDownloadFileService> m_fileService;
 
 		mutable std::condition_variable m_cv;
 		mutable std::mutex				m_mutex;
+		mutable bool					m_completed = false;
 
 		std::shared_ptr<toast::ToastEventHandler> m_handler;
 		std::shared_ptr<ToastPP::CToast> m_toast;
@@ -0,0 +1,395 @@
+#include "MediaResourceProvider.h"
+
+#include "DesktopCore\Blink\Services\MediaIndex.h"
+#include "DesktopCore\Utils\Logging\Logger.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4100)
+#pragma warning(disable : 4481)
+#include <cef/cef_resource_handler.h>
+#include <cef/wrapper/cef_helpers.h>
+#pragma warning(pop)
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+namespace desktop { namespace ui { namespace service {
+
+	namespace
+	{
+		const char* MIME_TYPE = "video/mp4";
+
+		bool toNumber(const std::string& text, std::uint64_t& value)
+		{
+			if (text.empty() || text.size() > 19 || !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; }))
+			{
+				return false;
+			}
+
+			value = std::stoull(text);
+
+			return true;
+		}
+
+		// bytes=first-last, bytes=first- or bytes=-suffix. Lists of ranges and malformed ones get the whole clip.
+		int parseRange(const std::string& header, std::uint64_t size, std::uint64_t& first, std::uint64_t& last)
+		{
+			first = 0;
+			last = size - 1;
+
+			auto value = boost::algorithm::trim_copy(header);
+			auto dash = value.find('-');
+
+			if (size == 0 || !boost::algorithm::istarts_with(value, "bytes=") || value.find(',') != std::string::npos || dash == std::string::npos)
+			{
+				return 200;
+			}
+
+			auto from = boost::algorithm::trim_copy(value.substr(6, dash - 6));
+			auto to = boost::algorithm::trim_copy(value.substr(dash + 1));
+
+			std::uint64_t start = 0, end = 0;
+
+			if (from.empty())
+			{
+				if (!toNumber(to, end))
+				{
+					return 200;
+				}
+				else if (end == 0)
+				{
+					return 416;
+				}
+
+				first = end < size ? size - end : 0;
+			}
+			else
+			{
+				if (!toNumber(from, start) || (!to.empty() && (!toNumber(to, end) || end < start)))
+				{
+					return 200;
+				}
+				else if (start >= size)
+				{
+					return 416;
+				}
+
+				first = start;
+
+				if (!to.empty())
+				{
+					last = std::min(end, size - 1);
+				}
+			}
+
+			return 206;
+		}
+
+		class MediaFileHandler : public CefResourceHandler
+		{
+		public:
+			explicit MediaFileHandler(const std::string& path)
+			: m_path(path)
+			{
+
+			}
+
+			bool ProcessRequest(CefRefPtr<CefRequest> request, CefRefPtr<CefCallback> callback) override
+			{
+				CEF_REQUIRE_IO_THREAD();
+
+				boost::system::error_code error;
+				m_size = boost::filesystem::file_size(m_path, error);
+
+				m_file.open(m_path, std::ios::binary);
+
+				if (error || !m_file.is_open())
+				{
+					BLING_LOG_WARNING("MediaResourceProvider", "Could not open " << m_path);
+					return false;
+				}
+
+				CefRequest::HeaderMap headers;
+				request->GetHeaderMap(headers);
+
+				m_status = 200;
+				m_first = 0;
+				m_last = m_size - 1;
+
+				for (auto& header : headers)
+				{
+					if (boost::algorithm::iequals(header.first.ToString(), "Range"))
+					{
+						m_status = parseRange(header.second.ToString(), m_size, m_first, m_last);
+					}
+				}
+
+				m_remaining = m_status == 416 || m_size == 0 ? 0 : m_last - m_first + 1;
+				m_file.seekg(static_cast<std::streamoff>(m_first));
+
+				callback->Continue();
+
+				return true;
+			}
+
+			void GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length, CefString& redirectUrl) override
+			{
+				CEF_REQUIRE_IO_THREAD();
+
+				CefResponse::HeaderMap headers;
+				headers.insert(std::make_pair("Accept-Ranges", "bytes"));
+
+				if (m_status == 206)
+				{
+					std::stringstream ss;
+					ss << "bytes " << m_first << "-" << m_last << "/" << m_size;
+
+					headers.insert(std::make_pair("Content-Range", ss.str()));
+				}
+				else if (m_status == 416)
+				{
+					std::stringstream ss;
+					ss << "bytes */" << m_size;
+
+					headers.insert(std::make_pair("Content-Range", ss.str()));
+				}
+
+				response->SetStatus(m_status);
+				response->SetStatusText(m_status == 200 ? "OK" : m_status == 206 ? "Partial Content" : "Range Not Satisfiable");
+				response->SetMimeType(MIME_TYPE);
+				response->SetHeaderMap(headers);
+
+				response_length = static_cast<int64>(m_remaining);
+			}
+
+			bool ReadResponse(void* data_out, int bytes_to_read, int& bytes_read, CefRefPtr<CefCallback> callback) override
+			{
+				CEF_REQUIRE_IO_THREAD();
+
+				bytes_read = 0;
+
+				if (m_remaining == 0 || bytes_to_read <= 0)
+				{
+					return false;
+				}
+
+				auto count = std::min<std::uint64_t>(static_cast<std::uint64_t>(bytes_to_read), m_remaining);
+
+				m_file.read(static_cast<char*>(data_out), static_cast<std::streamsize>(count));
+
+				bytes_read = static_cast<int>(m_file.gcount());
+				m_remaining -= static_cast<std::uint64_t>(bytes_read);
+
+				return bytes_read > 0;
+			}
+
+			void Cancel() override
+			{
+				CEF_REQUIRE_IO_THREAD();
+
+				m_file.close();
+			}
+		private:
+			std::string		m_path;
+			std::ifstream	m_file;
+			std::uint64_t	m_size = 0;
+			std::uint64_t	m_first = 0;
+			std::uint64_t	m_last = 0;
+			std::uint64_t	m_remaining = 0;
+			int				m_status = 200;
+
+			IMPLEMENT_REFCOUNTING(MediaFileHandler);
+		};
+
+		// Passes the body through unchanged while writing it to a partial file, renamed into place
+		// and indexed once size bytes went by. Requests that end early leave nothing behind.
+		class MediaCacheFilter : public CefResponseFilter
+		{
+		public:
+			MediaCacheFilter(const std::string& url, const std::string& target, std::uint64_t size)
+			: m_url(url)
+			, m_target(target)
+			, m_size(size)
+			{
+				static std::atomic<unsigned int> S_sequence(0);
+
+				// Several requests may fetch the same clip at once
+				std::stringstream ss;
+				ss << target << "." << ++S_sequence << ".partial";
+
+				m_partial = ss.str();
+			}
+
+			~MediaCacheFilter()
+			{
+				discard();
+			}
+
+			bool InitFilter() override
+			{
+				boost::system::error_code error;
+				boost::filesystem::create_directories(boost::filesystem::path(m_target).parent_path(), error);
+
+				m_file.open(m_partial, std::ios::binary | std::ios::trunc);
+
+				// Caching is best effort, the viewer gets the clip either way
+				return true;
+			}
+
+			FilterStatus Filter(void* data_in, size_t data_in_size, size_t& data_in_read, void* data_out, size_t data_out_size, size_t& data_out_written) override
+			{
+				data_in_read = std::min(data_in_size, data_out_size);
+
+				if (data_in_read > 0)
+				{
+					std::memcpy(data_out, data_in, data_in_read);
+				}
+
+				data_out_written = data_in_read;
+
+				if (m_file.is_open() && data_in_read > 0)
+				{
+					m_file.write(static_cast<const char*>(data_in), static_cast<std::streamsize>(data_in_read));
+					m_written += data_in_read;
+
+					if (!m_file || m_written > m_size)
+					{
+						discard();
+					}
+					else if (m_written == m_size)
+					{
+						complete();
+					}
+				}
+
+				return data_in_read < data_in_size ? RESPONSE_FILTER_NEED_MORE_DATA : RESPONSE_FILTER_DONE;
+			}
+		private:
+			void complete()
+			{
+				m_file.close();
+
+				boost::system::error_code error;
+				boost::filesystem::rename(m_partial, m_target, error);
+
+				if (error)
+				{
+					BLING_LOG_WARNING("MediaResourceProvider", "Could not save " << m_target << ": " << error.message());
+
+					boost::filesystem::remove(m_partial, error);
+					return;
+				}
+
+				core::service::MediaIndex::get().add(m_url, m_target);
+			}
+
+			void discard()
+			{
+				if (m_file.is_open())
+				{
+					m_file.close();
+
+					boost::system::error_code error;
+					boost::filesystem::remove(m_partial, error);
+				}
+			}
+		private:
+			std::string		m_url;
+			std::string		m_target;
+			std::string		m_partial;
+			std::ofstream	m_file;
+			std::uint64_t	m_size = 0;
+			std::uint64_t	m_written = 0;
+
+			IMPLEMENT_REFCOUNTING(MediaCacheFilter);
+		};
+
+		// Size of the clip when the response is all of it: a 200, or a 206 from the first byte to the last
+		std::uint64_t wholeSize(CefRefPtr<CefResponse> response)
+		{
+			auto encoding = response->GetHeader("Content-Encoding").ToString();
+
+			if (!encoding.empty() && !boost::algorithm::iequals(encoding, "identity"))
+			{
+				return 0;
+			}
+
+			std::uint64_t size = 0;
+
+			if (response->GetStatus() == 200)
+			{
+				if (!toNumber(boost::algorithm::trim_copy(response->GetHeader("Content-Length").ToString()), size))
+				{
+					return 0;
+				}
+			}
+			else if (response->GetStatus() == 206)
+			{
+				// bytes 0-last/size
+				auto range = boost::algorithm::trim_copy(response->GetHeader("Content-Range").ToString());
+				auto dash = range.find('-');
+				auto slash = range.find('/');
+
+				std::uint64_t last = 0;
+
+				if (!boost::algorithm::istarts_with(range, "bytes 0-") || dash == std::string::npos || slash == std::string::npos || slash < dash ||
+					!toNumber(range.substr(dash + 1, slash - dash - 1), last) || !toNumber(range.substr(slash + 1), size) || last + 1 != size)
+				{
+					return 0;
+				}
+			}
+
+			return size;
+		}
+	}
+
+	bool MediaResourceProvider::OnRequest(scoped_refptr<CefResourceManager::Request> request)
+	{
+		CEF_REQUIRE_IO_THREAD();
+
+		if (request->request()->GetMethod() != "GET")
+		{
+			return false;
+		}
+
+		auto file = core::service::MediaIndex::get().find(request->url());
+
+		if (file.empty())
+		{
+			return false;
+		}
+
+		request->Continue(new MediaFileHandler(file));
+
+		return true;
+	}
+
+	CefRefPtr<CefResponseFilter> createMediaCacheFilter(CefRefPtr<CefRequest> request, CefRefPtr<CefResponse> response)
+	{
+		auto& index = core::service::MediaIndex::get();
+
+		std::string url = request->GetURL();
+		auto target = index.cachePath(url);
+
+		if (target.empty() || request->GetMethod() != "GET")
+		{
+			return nullptr;
+		}
+
+		auto size = wholeSize(response);
+
+		// Clips served from disk pass through here too
+		if (size == 0 || !index.find(url).empty())
+		{
+			return nullptr;
+		}
+
+		return new MediaCacheFilter(url, target, size);
+	}
+}}}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#pragma warning(push)
+#pragma warning(disable : 4100)
+#pragma warning(disable : 4481)
+#include <cef/cef_request.h>
+#include <cef/cef_response.h>
+#include <cef/cef_response_filter.h>
+#include <cef/wrapper/cef_resource_manager.h>
+#pragma warning(pop)
+
+namespace desktop { namespace ui { namespace service {
+
+	// Plays the clips in core::service::MediaIndex from disk instead of Blink's servers, answering
+	// Range requests so the player can seek. Clips that are not there go to the network.
+	class MediaResourceProvider : public CefResourceManager::Provider
+	{
+	public:
+		bool OnRequest(scoped_refptr<CefResourceManager::Request> request) override;
+	};
+
+	// Saves a clip the viewer fetches from the network while it plays and indexes it once complete,
+	// so the provider serves it the next time. Null unless the response carries the whole clip.
+	CefRefPtr<CefResponseFilter> createMediaCacheFilter(CefRefPtr<CefRequest> request, CefRefPtr<CefResponse> response);
+}}}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "UIExecutorService.h"
+
+#include "DesktopCore\Utils\Logging\Logger.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4100)
+#pragma warning(disable : 4481)
+#include <cef/cef_app.h>
+#include <cef/cef_task.h>
+#pragma warning(pop)
+
+namespace desktop { namespace ui { namespace service {
+
+	namespace
+	{
+		class FunctionTask : public CefTask
+		{
+		public:
+			explicit FunctionTask(std::function<void()> function)
+			: m_function(function)
+			{
+
+			}
+
+			void Execute() OVERRIDE
+			{
+				m_function();
+			}
+		private:
+			std::function<void()> m_function;
+
+			IMPLEMENT_REFCOUNTING(FunctionTask);
+		};
+	}
+
+	UIExecutorService::UIExecutorService(std::size_t capacity)
+	: m_capacity(capacity)
+	{
+
+	}
+
+	UIExecutorService::~UIExecutorService() = default;
+
+	bool UIExecutorService::post(TaskType task, cup::OverflowPolicy overflow)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		if (m_tasks.size() >= m_capacity)
+		{
+			if (overflow == cup::OverflowPolicy::Backpressure && !CefCurrentlyOn(TID_UI))
+			{
+				m_cv.wait(lock, [this]() { return m_tasks.size() < m_capacity; });
+			}
+			else
+			{
+				m_tasks.pop_front();
+			}
+		}
+
+		m_tasks.push_back(std::move(task));
+
+		if (!m_scheduled)
+		{
+			auto self = shared_from_this();
+
+			m_scheduled = CefPostTask(TID_UI, new FunctionTask([self]()
+			{
+				self->drain();
+			}));
+
+			// The UI thread is gone, so nothing would ever drain the queue; whatever waits
+			// for room must not block on it either
+			if (!m_scheduled)
+			{
+				m_tasks.clear();
+				lock.unlock();
+
+				m_cv.notify_all();
+
+				BLING_LOG_WARNING("UIExecutorService", "Dropped a task, the UI thread does not take tasks anymore");
+
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void UIExecutorService::drain()
+	{
+		std::deque<TaskType> tasks;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			tasks.swap(m_tasks);
+			m_scheduled = false;
+		}
+
+		m_cv.notify_all();
+
+		for (auto& task : tasks)
+		{
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				BLING_LOG_ERROR("UIExecutorService", "Task failed: " << core::utils::logging::currentException());
+			}
+		}
+	}
+}}}
\ No newline at end of file
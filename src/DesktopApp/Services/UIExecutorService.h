@@ -0,0 +1,32 @@
+#pragma once
+
+#include "DesktopCore\Utils\Patterns\PublisherSubscriber\Executor.h"
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <condition_variable>
+
+namespace desktop { namespace ui { namespace service {
+
+	namespace cup = core::utils::patterns;
+
+	// Executor that runs Broker deliveries on the CEF UI thread. Tasks are queued here and
+	// drained by a single posted CEF task, so the queue can be bounded and drop its oldest entry.
+	class UIExecutorService : public cup::IExecutor, public std::enable_shared_from_this<UIExecutorService>
+	{
+	public:
+		UIExecutorService(std::size_t capacity = 256);
+		~UIExecutorService();
+
+		bool post(TaskType task, cup::OverflowPolicy overflow) override;
+	private:
+		void drain();
+	private:
+		std::size_t					m_capacity;
+		std::deque<TaskType>		m_tasks;
+		std::mutex					m_mutex;
+		std::condition_variable		m_cv;
+		bool						m_scheduled = false;
+	};
+}}}
\ No newline at end of file
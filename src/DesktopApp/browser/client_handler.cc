@@ -25,9 +25,9 @@
 #include "common/client_switches.h"
 
 #include "Events.h"
-#include "DesktopCore\Network\Model\Credentials.h"
-#include "DesktopCore\Network\Events.h"
+#include "DesktopCore\Network\Services\CredentialsStore.h"
 #include "DesktopCore\Network\Services\ParseURIService.h"
+#include "Services\MediaResourceProvider.h"
 #include "DesktopCore\Utils\Patterns\PublisherSubscriber\Broker.h"
 
 namespace client {
@@ -256,7 +256,8 @@ ClientHandler::ClientHandler(Delegate* delegate,
       console_log_file_(MainContext::Get()->GetConsoleLogPath()),
       first_console_message_(true),
       focus_on_editable_field_(false),
-      initial_navigation_(true) {
+      initial_navigation_(true),
+      download_status_channel_(std::chrono::milliseconds(250)) {
   DCHECK(!console_log_file_.empty());
 
 #if defined(OS_LINUX)
@@ -267,6 +268,9 @@ ClientHandler::ClientHandler(Delegate* delegate,
   resource_manager_ = new CefResourceManager();
   test_runner::SetupResourceManager(resource_manager_);
 
+  // Synced clips play from disk, ahead of every other provider
+  resource_manager_->AddProvider(new desktop::ui::service::MediaResourceProvider(), -100, "media");
+
   // Read command line settings.
   CefRefPtr<CefCommandLine> command_line =
       CefCommandLine::GetGlobalCommandLine();
@@ -478,19 +482,30 @@ void ClientHandler::OnDownloadUpdated(
                                     "\" downloaded successfully.");*/
   }
 
-  desktop::ui::events::DownloadStatusEvent evt;
+  const uint32 id = download_item->GetId();
 
-  evt.bIsValid = download_item->IsValid();
-  evt.bIsInProgress = download_item->IsInProgress();
-  evt.bIsComplete = download_item->IsComplete();
-  evt.bIsCanceled = download_item->IsCanceled();
-  evt.nProgress = download_item->GetPercentComplete();
-  evt.nSpeed = download_item->GetCurrentSpeed();
-  evt.nReceived = download_item->GetReceivedBytes();
-  evt.nTotal = download_item->GetTotalBytes();
-  evt.m_path = download_item->GetFullPath();
+  download_status_channel_.update(id, [&download_item](desktop::ui::events::DownloadStatusEvent& evt)
+  {
+    evt.bIsValid = download_item->IsValid();
+    evt.bIsInProgress = download_item->IsInProgress();
+    evt.bIsComplete = download_item->IsComplete();
+    evt.bIsCanceled = download_item->IsCanceled();
+    evt.nProgress = download_item->GetPercentComplete();
+    evt.nSpeed = download_item->GetCurrentSpeed();
+    evt.nReceived = download_item->GetReceivedBytes();
+    evt.nTotal = download_item->GetTotalBytes();
+
+    // The path is fixed once chosen; avoid converting it on every progress tick.
+    if (evt.m_path.empty() || evt.bIsComplete)
+    {
+      evt.m_path = download_item->GetFullPath();
+    }
+  });
 
-  desktop::core::utils::patterns::Broker::get().publish(evt);
+  if (download_item->IsComplete() || download_item->IsCanceled())
+  {
+    download_status_channel_.flush(id);
+  }
 }
 
 bool ClientHandler::OnDragEnter(CefRefPtr<CefBrowser> browser,
@@ -743,22 +758,18 @@ cef_return_value_t ClientHandler::OnBeforeResourceLoad(
   request->GetHeaderMap(headers);
 
   auto account = headers.find("ACCOUNT_ID");
+  auto token = headers.find("TOKEN_AUTH");
   
-  if (account != headers.end())
+  if (account != headers.end() && token != headers.end())
   {
-	  std::string protocol, domain, port, path, query, fragment;
+	  // Runs for every request of the viewer, the components are views into url
+	  desktop::core::service::ParseURIService::Components uri;
 
 	  desktop::core::service::ParseURIService service;
-	  if (service.parse(request->GetURL().ToString(), protocol, domain, port, path, query, fragment))
+	  if (service.parse(url, uri) && !uri.m_host.empty())
 	  {
-		  auto token = headers.find("TOKEN_AUTH");
-
-		  if (token != headers.end())
-		  {
-			desktop::core::model::Credentials credentials(domain, port, token->second, account->second);
-			desktop::core::events::CredentialsEvent evt(credentials);
-			desktop::core::utils::patterns::Broker::get().publish(evt);
-		  }
+		// Publishes only when the viewer logged in again or switched accounts
+		desktop::core::service::CredentialsStore::get().update(uri.m_host, uri.port(), token->second.ToString(), account->second.ToString());
 	  }
   }
 
@@ -782,6 +793,12 @@ CefRefPtr<CefResponseFilter> ClientHandler::GetResourceResponseFilter(
     CefRefPtr<CefRequest> request,
     CefRefPtr<CefResponse> response) {
   CEF_REQUIRE_IO_THREAD();
+
+  // Clips that are not on disk yet are saved as they play
+  CefRefPtr<CefResponseFilter> filter = desktop::ui::service::createMediaCacheFilter(request, response);
+  if (filter)
+	  return filter;
+
   return test_runner::GetResourceResponseFilter(browser, frame, request,
                                                 response);
 }
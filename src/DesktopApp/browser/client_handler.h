@@ -15,6 +15,9 @@
 #include "cef/wrapper/cef_resource_manager.h"
 #include "browser/client_types.h"
 
+#include "Events.h"
+#include "DesktopCore\Utils\Patterns\PublisherSubscriber\CoalescingChannel.h"
+
 #if defined(OS_LINUX)
 #include "browser/dialog_handler_gtk.h"
 #endif
@@ -381,6 +384,11 @@ class ClientHandler : public CefClient,
   // Set of Handlers registered with the message router.
   MessageHandlerSet message_handler_set_;
 
+  // Coalesces download progress per download id before it reaches the Broker.
+  // Inline DownloadStatusEvent subscribers run on its worker thread, not on the UI thread.
+  desktop::core::utils::patterns::CoalescingChannel<
+      desktop::ui::events::DownloadStatusEvent, uint32> download_status_channel_;
+
   DISALLOW_COPY_AND_ASSIGN(ClientHandler);
 };
 
@@ -28,7 +28,9 @@
 #include "DesktopCore\Blink\Agents\SyncThumbnailAgent.h"
 #include "DesktopCore\Blink\Agents\LiveViewAgent.h"
 #include "DesktopCore\Blink\Agents\ActivityAgent.h"
+#include "DesktopCore\Utils\Runtime\StartupTimeline.h"
 #include "Services\DownloadViewerService.h"
+#include "Services\UIExecutorService.h"
 
 // When generating projects with CMake the CEF_USE_SANDBOX value will be defined
 // automatically if using the required compiler version. Pass -DUSE_SANDBOX=OFF
@@ -47,6 +49,8 @@ namespace {
 
 int RunMain(HINSTANCE hInstance, int nCmdShow) 
 {
+	desktop::core::utils::runtime::StartupTimeline::get().mark("process");
+
 	desktop::core::service::CrashReportService service;
 	service.initialize({});
 
@@ -117,6 +121,8 @@ int RunMain(HINSTANCE hInstance, int nCmdShow)
   // Initialize CEF.
   context->Initialize(main_args, settings, app, sandbox_info);
 
+  desktop::core::utils::runtime::StartupTimeline::get().mark("cef");
+
   // Register scheme handlers.
   test_runner::RegisterSchemeHandlers();
 
@@ -126,10 +132,14 @@ int RunMain(HINSTANCE hInstance, int nCmdShow)
       !command_line->HasSwitch(switches::kHideControls);
   window_config.with_osr = settings.windowless_rendering_enabled ? true : false;
   
+  bool viewerInstalled = false;
+
   {
 	  desktop::core::service::ApplicationDataService applicationService;
 
-	  if (boost::filesystem::exists(applicationService.getViewerFolder() + "/index.html"))
+	  viewerInstalled = boost::filesystem::exists(applicationService.getViewerFolder() + "/index.html");
+
+	  if (viewerInstalled)
 	  {
 		  desktop::core::service::IniFileService iniFileService;
 
@@ -141,24 +151,51 @@ int RunMain(HINSTANCE hInstance, int nCmdShow)
 	  }
   }
 
+  desktop::core::utils::patterns::Broker::get().registerExecutor(desktop::core::utils::patterns::UI_EXECUTOR, std::make_shared<desktop::ui::service::UIExecutorService>());
+
   desktop::core::DesktopCore core;
 
+  core.initialize();
+
+  desktop::core::utils::runtime::StartupTimeline::get().reportWhen({"agents", "viewer"});
+
+  // None of these need the browser, and the viewer is served by the file server, so they are
+  // built in the background while the window is being created
+  core.addAgents({
+	  {"FileServerAgent", []() { return std::make_unique<desktop::core::agent::FileServerAgent>(); }},
+	  {"SyncVideoAgent", []() { return std::make_unique<desktop::core::agent::SyncVideoAgent>(); }},
+	  {"SyncThumbnailAgent", []() { return std::make_unique<desktop::core::agent::SyncThumbnailAgent>(); }},
+	  {"LiveViewAgent", []() { return std::make_unique<desktop::core::agent::LiveViewAgent>(); }}
+  });
+
+  bool browserCreated = false;
+
   desktop::core::utils::patterns::Subscriber subscriber;
-  subscriber.subscribe([&core](const desktop::core::utils::patterns::Event& rawEvt)
+  subscriber.subscribe<desktop::ui::events::BrowserCreatedEvent>("DesktopApp", [&core, &browserCreated, viewerInstalled](const desktop::ui::events::BrowserCreatedEvent& evt)
   {
-	  const auto& evt = static_cast<const desktop::ui::events::BrowserCreatedEvent&>(rawEvt);
-
 	  auto &browser = evt.m_browser;
 
-	  core.initialize();
+	  if (browserCreated)
+	  {
+		  return;
+	  }
+
+	  browserCreated = true;
+
+	  desktop::core::utils::runtime::StartupTimeline::get().mark("browser");
 
-      core.addAgent(std::make_unique<desktop::core::agent::UpgradeViewerAgent>(std::make_unique<desktop::ui::service::DownloadViewerService>(browser)));
-      core.addAgent(std::make_unique<desktop::core::agent::SyncVideoAgent>());
-      core.addAgent(std::make_unique<desktop::core::agent::SyncThumbnailAgent>());
-      core.addAgent(std::make_unique<desktop::core::agent::LiveViewAgent>());
-      core.addAgent(std::make_unique<desktop::core::agent::FileServerAgent>());
-      
-  }, desktop::ui::events::BROWSER_CREATED_EVENT);
+	  // A missing viewer is needed right away; an upgrade check can wait until the viewer is idle
+	  auto delay = std::chrono::milliseconds(viewerInstalled ? 30000 : 0);
+
+	  core.addAgents({
+		  {"UpgradeViewerAgent", [&browser]() { return std::make_unique<desktop::core::agent::UpgradeViewerAgent>(std::make_unique<desktop::ui::service::DownloadViewerService>(browser)); }, {}, delay}
+	  });
+  });
+
+  subscriber.subscribe<desktop::ui::events::BrowserLoadEndEvent>("DesktopApp", [](const desktop::ui::events::BrowserLoadEndEvent& /*evt*/)
+  {
+	  desktop::core::utils::runtime::StartupTimeline::get().mark("viewer");
+  });
 
   // Create the first window.
   context->GetRootWindowManager()->CreateRootWindow(window_config);
@@ -167,6 +204,8 @@ int RunMain(HINSTANCE hInstance, int nCmdShow)
   // RootWindowManager after all windows have been destroyed.
   int result = message_loop->Run();
 
+  desktop::core::utils::patterns::Broker::get().unregisterExecutor(desktop::core::utils::patterns::UI_EXECUTOR);
+
   // Shut down CEF.
   context->Shutdown();
 
@@ -0,0 +1,238 @@
+#include "AgentOrchestrator.h"
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Runtime/Runtime.h"
+#include "Utils/Runtime/StartupTimeline.h"
+
+#include <map>
+#include <stdexcept>
+
+namespace desktop { namespace core {
+
+	AgentOrchestrator::AgentOrchestrator(utils::runtime::Runtime& runtime)
+	: m_runtime(runtime)
+	{
+
+	}
+
+	AgentOrchestrator::~AgentOrchestrator() = default;
+
+	void AgentOrchestrator::add(std::vector<model::AgentDescriptor> agents)
+	{
+		auto batch = std::make_shared<Batch>();
+
+		batch->m_agents = std::move(agents);
+		batch->m_waiting.assign(batch->m_agents.size(), 0);
+		batch->m_dependents.resize(batch->m_agents.size());
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			std::map<std::string, std::size_t> indexes;
+
+			for (std::size_t i = 0; i < batch->m_agents.size(); ++i)
+			{
+				auto& name = batch->m_agents[i].m_name;
+
+				if (m_names.count(name) || !indexes.emplace(name, i).second)
+				{
+					throw std::invalid_argument("Agent " + name + " added twice");
+				}
+			}
+
+			for (std::size_t i = 0; i < batch->m_agents.size(); ++i)
+			{
+				for (auto& dependency : batch->m_agents[i].m_dependencies)
+				{
+					auto found = indexes.find(dependency);
+
+					if (found != indexes.end())
+					{
+						batch->m_dependents[found->second].push_back(i);
+						++batch->m_waiting[i];
+					}
+					else if (!m_running.count(dependency))
+					{
+						throw std::invalid_argument("Agent " + batch->m_agents[i].m_name + " depends on unknown agent " + dependency);
+					}
+				}
+			}
+
+			// Same walk as the builds will take; whatever it cannot reach waits on itself
+			auto waiting = batch->m_waiting;
+			std::vector<std::size_t> ready;
+
+			for (std::size_t i = 0; i < waiting.size(); ++i)
+			{
+				if (waiting[i] == 0)
+				{
+					ready.push_back(i);
+				}
+			}
+
+			for (std::size_t next = 0; next < ready.size(); ++next)
+			{
+				for (auto dependent : batch->m_dependents[ready[next]])
+				{
+					if (--waiting[dependent] == 0)
+					{
+						ready.push_back(dependent);
+					}
+				}
+			}
+
+			if (ready.size() != waiting.size())
+			{
+				throw std::invalid_argument("Agents depend on each other in a cycle");
+			}
+
+			for (auto& agent : batch->m_agents)
+			{
+				m_names.insert(agent.m_name);
+
+				if (agent.m_delay.count() == 0)
+				{
+					++batch->m_eager;
+				}
+			}
+		}
+
+		for (std::size_t i = 0; i < batch->m_agents.size(); ++i)
+		{
+			if (batch->m_waiting[i] == 0)
+			{
+				launch(batch, i);
+			}
+		}
+	}
+
+	std::vector<std::unique_ptr<model::IAgent>> AgentOrchestrator::shutdown(std::chrono::milliseconds timeout)
+	{
+		std::vector<std::unique_ptr<model::IAgent>> agents;
+		std::vector<std::shared_ptr<utils::runtime::Timer>> timers;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_stopping = true;
+
+			m_cv.wait_for(lock, timeout, [this]()
+			{
+				return m_building == 0;
+			});
+
+			agents.swap(m_agents);
+			timers.swap(m_timers);
+		}
+
+		for (auto& timer : timers)
+		{
+			timer->cancel(false);
+		}
+
+		return agents;
+	}
+
+	void AgentOrchestrator::launch(const std::shared_ptr<Batch>& batch, std::size_t index)
+	{
+		auto self = shared_from_this();
+
+		auto task = [self, batch, index]()
+		{
+			self->build(batch, index);
+		};
+
+		auto delay = batch->m_agents[index].m_delay;
+
+		if (delay.count() > 0)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (!m_stopping)
+			{
+				m_timers.push_back(m_runtime.schedule(delay, task));
+			}
+		}
+		else
+		{
+			m_runtime.post(task);
+		}
+	}
+
+	void AgentOrchestrator::build(const std::shared_ptr<Batch>& batch, std::size_t index)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (m_stopping)
+			{
+				return;
+			}
+
+			++m_building;
+		}
+
+		auto& descriptor = batch->m_agents[index];
+		auto begin = std::chrono::steady_clock::now();
+
+		std::unique_ptr<model::IAgent> agent;
+
+		try
+		{
+			agent = descriptor.m_factory();
+		}
+		catch (...)
+		{
+			BLING_LOG_ERROR("AgentOrchestrator", "Could not build " << descriptor.m_name << ": " << utils::logging::currentException());
+		}
+
+		std::vector<std::size_t> ready;
+		bool complete = false;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (agent && !m_stopping)
+			{
+				// Under the lock, so shutdown either gets the agent started or never sees it
+				agent->start();
+
+				m_agents.push_back(std::move(agent));
+				m_running.insert(descriptor.m_name);
+
+				BLING_LOG_INFO("AgentOrchestrator", "Started " << descriptor.m_name);
+			}
+
+			// A failed agent does not hold back the ones depending on it
+			for (auto dependent : batch->m_dependents[index])
+			{
+				if (--batch->m_waiting[dependent] == 0)
+				{
+					ready.push_back(dependent);
+				}
+			}
+
+			if (descriptor.m_delay.count() == 0)
+			{
+				complete = --batch->m_eager == 0;
+			}
+
+			--m_building;
+			m_cv.notify_all();
+		}
+
+		auto& timeline = utils::runtime::StartupTimeline::get();
+
+		timeline.measure(descriptor.m_name, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin));
+
+		for (auto dependent : ready)
+		{
+			launch(batch, dependent);
+		}
+
+		if (complete)
+		{
+			timeline.mark("agents");
+		}
+	}
+}}
\ No newline at end of file
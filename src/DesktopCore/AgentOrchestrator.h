@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Model/AgentDescriptor.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace desktop { namespace core {
+
+	namespace utils { namespace runtime {
+		class Runtime;
+		class Timer;
+	}}
+
+	// Builds and starts agents on the runtime threads instead of the caller's, each one as soon
+	// as its dependencies are running, so independent constructors overlap
+	class AgentOrchestrator : public std::enable_shared_from_this<AgentOrchestrator>
+	{
+	public:
+		explicit AgentOrchestrator(utils::runtime::Runtime& runtime);
+		~AgentOrchestrator();
+
+		// Dependencies name agents of the same call or agents already running. Throws
+		// std::invalid_argument for an unknown or duplicated name and for a cycle.
+		void add(std::vector<model::AgentDescriptor> agents);
+
+		// Nothing is built afterwards; waits up to timeout for the builds in progress
+		std::vector<std::unique_ptr<model::IAgent>> shutdown(std::chrono::milliseconds timeout);
+	private:
+		struct Batch
+		{
+			std::vector<model::AgentDescriptor>		m_agents;
+			std::vector<std::size_t>				m_waiting;
+			std::vector<std::vector<std::size_t>>	m_dependents;
+			std::size_t								m_eager = 0;
+		};
+
+		void launch(const std::shared_ptr<Batch>& batch, std::size_t index);
+		void build(const std::shared_ptr<Batch>& batch, std::size_t index);
+	private:
+		utils::runtime::Runtime&							m_runtime;
+
+		std::mutex											m_mutex;
+		std::condition_variable								m_cv;
+		std::vector<std::unique_ptr<model::IAgent>>			m_agents;
+		std::set<std::string>								m_names;
+		std::set<std::string>								m_running;
+		std::vector<std::shared_ptr<utils::runtime::Timer>>	m_timers;
+		std::size_t											m_building = 0;
+		bool												m_stopping = false;
+	};
+}}
\ No newline at end of file
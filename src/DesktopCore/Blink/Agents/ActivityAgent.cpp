@@ -1,16 +1,19 @@
 #include "ActivityAgent.h"
 
-#include "Utils\Patterns\PublisherSubscriber\Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Logging/Logger.h"
+#include "Utils/Timestamp/Timestamp.h"
+#include "Utils/Tracing/Tracer.h"
 #include "../../Network/Events.h"
-#include "..\..\Network\Model\Credentials.h"
-#include "..\..\System\Services\IniFileService.h"
+#include "../../Network/JournalCodecs.h"
+#include "../../Network/Model/Credentials.h"
+#include "../../System/Services/IniFileService.h"
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/filesystem.hpp>
 #include <iostream>
 #include <chrono>
-#include <thread>
 
 namespace desktop { namespace core { namespace agent {
 
@@ -18,9 +21,11 @@ namespace desktop { namespace core { namespace agent {
 									std::unique_ptr<service::HTTPClientService> clientService,
 									std::unique_ptr<service::ApplicationDataService> applicationService,
 									std::unique_ptr<service::IniFileService> iniFileService,
-									std::unique_ptr<service::TimestampFolderService> timestampFolderService)
-	: m_ioService()
-	, m_iniFileService(std::move(iniFileService))
+									std::unique_ptr<service::TimestampFolderService> timestampFolderService,
+									utils::runtime::Runtime& runtime)
+	: m_iniFileService(std::move(iniFileService))
+	, m_lifecycle(runtime)
+	, m_metrics("ActivityAgent")
 	, m_activityService(std::move(activityService))
 	, m_clientService(std::move(clientService))
 	, m_applicationService(std::move(applicationService))
@@ -28,43 +33,63 @@ namespace desktop { namespace core { namespace agent {
 	{
 		auto documents = m_applicationService->getMyDocuments();
 
+		m_settings = std::make_unique<service::LiveSettingsService<model::ActivitySettings>>(documents + "Blink.ini", [this, documents]()
 		{
-			m_seconds = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "Activity", "Interval", 10);
+			model::ActivitySettings settings;
 
-			m_timer = std::make_unique<boost::asio::deadline_timer>(m_ioService, boost::posix_time::seconds(m_seconds));
-		}
+			settings.m_enabled = m_iniFileService->get<bool>(documents + "Blink.ini", "Activity", "Enabled", true);
+			settings.m_interval = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "Activity", "Interval", 10);
+
+			return settings;
+		});
 
-		if(m_iniFileService->get<bool>(documents + "Blink.ini", "Activity", "Enabled", true))
+		setLastUpdateTimestamp();
+
+		auto onCredentials = [this](const core::events::CredentialsEvent& evt)
 		{
-			setLastUpdateTimestamp();
+			// Swapped atomically, execute takes its own copy on the blocking pool
+			bool first = !std::atomic_exchange(&m_credentials, evt.m_credentials);
 
-			m_subscriber.subscribe([this](const desktop::core::utils::patterns::Event& rawEvt)
+			// Does nothing before start, which arms the timer itself once credentials exist
+			if (first)
 			{
-				const auto& evt = static_cast<const core::events::CredentialsEvent&>(rawEvt);
+				armTimer(1);
+			}
+		};
 
-				m_credentials = std::make_unique<model::Credentials>(evt.m_credentials);
+		// Resume with the credentials of the last session before the viewer sends new ones
+		cup::Journal::get().replay<core::events::CredentialsEvent>([&onCredentials](const core::events::CredentialsEvent& evt)
+		{
+			onCredentials(evt);
+		});
 
-				auto documents = m_applicationService->getMyDocuments();
-			
-				if (!m_enabled)
-				{
-					m_enabled = true;
+		m_subscriber.subscribe<core::events::CredentialsEvent>("ActivityAgent", onCredentials, cup::DeliveryPolicy::executor(cup::CORE_EXECUTOR));
+	}
 
-					armTimer(1);
+	ActivityAgent::~ActivityAgent()
+	{
+		m_lifecycle.stop();
+		m_lifecycle.wait();
+	}
 
-					boost::thread t(boost::bind(&boost::asio::io_service::run, &m_ioService));
-					m_backgroundThread.swap(t);
-				}
-			}, events::CREDENTIALS_EVENT);
+	void ActivityAgent::start()
+	{
+		m_lifecycle.start();
+
+		if (std::atomic_load(&m_credentials))
+		{
+			armTimer(1);
 		}
 	}
 
-	ActivityAgent::~ActivityAgent()
+	void ActivityAgent::stop()
 	{
-		m_enabled = false;
-		m_timer->cancel();
-		m_backgroundThread.join();
-		m_ioService.reset();
+		m_lifecycle.stop();
+	}
+
+	bool ActivityAgent::drain(std::chrono::milliseconds timeout)
+	{
+		return m_lifecycle.drain(timeout);
 	}
 
 	std::string ActivityAgent::getLastUpdateTimestamp() const
@@ -82,16 +107,13 @@ namespace desktop { namespace core { namespace agent {
 
 		struct tm timeinfo;
 
+#ifdef _WIN32
 		localtime_s(&timeinfo, &rawtime);
+#else
+		localtime_r(&rawtime, &timeinfo);
+#endif
 
-		std::stringstream ss;
-		ss << timeinfo.tm_year + 1900 << "-" << std::setfill('0') << std::setw(2) << timeinfo.tm_mon + 1 << "-"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_mday
-			<< "T" << std::setfill('0') << std::setw(2) << timeinfo.tm_hour << ":"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_min << ":"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_sec << "+00:00";
-		
-		setLastUpdateTimestamp(ss.str());
+		setLastUpdateTimestamp(utils::timestamp::toString(utils::timestamp::fromTm(timeinfo)));
 	}
 
 	void ActivityAgent::setLastUpdateTimestamp(const std::string& timestamp) const
@@ -103,16 +125,18 @@ namespace desktop { namespace core { namespace agent {
 
 	void ActivityAgent::execute()
 	{
-		if (m_enabled && m_credentials)
+		auto credentials = std::atomic_load(&m_credentials);
+
+		if (m_lifecycle.running() && credentials && m_settings->get()->m_enabled)
 		{
 			std::map<std::string, std::string> videos;
 
 			std::string lastUpdate = getLastUpdateTimestamp();
 
 			std::stringstream ss;
-			ss << "/api/v1/accounts/" << m_credentials->m_account << "/media/changed?since=" << lastUpdate;
+			ss << "/api/v1/accounts/" << credentials->m_account << "/media/changed?since=" << lastUpdate;
 
-			getVideos(videos, ss.str(), 1);
+			getVideos(*credentials, videos, ss.str(), 1);
 
 			if (videos.size() > 0)
 			{
@@ -123,25 +147,29 @@ namespace desktop { namespace core { namespace agent {
 		}
 	}
 
-	void ActivityAgent::getVideos(std::map<std::string, std::string>& videos, const std::string& path, unsigned int page) const
+	void ActivityAgent::getVideos(const model::Credentials& credentials, std::map<std::string, std::string>& videos, const std::string& path, unsigned int page) const
 	{
 		std::map<std::string, std::string> requestHeaders, responseHeaders;
 		std::string content;
 		unsigned int status;
 
-		requestHeaders["token_auth"] = m_credentials->m_token;
+		requestHeaders["token_auth"] = credentials.m_token;
 
 		std::stringstream ss;
 		ss << "/api/v2/notification";// << "&page=" << page;
 
-		if (m_clientService->post(m_credentials->m_host, m_credentials->m_port, ss.str(), requestHeaders, responseHeaders, content, status))
+		if (m_clientService->post(credentials.m_host, credentials.m_port, ss.str(), requestHeaders, responseHeaders, content, status, m_lifecycle.token()))
 		{
 			std::stringstream contentSS(content);
 
 			try
 			{
 				boost::property_tree::ptree tree;
-				boost::property_tree::json_parser::read_json(contentSS, tree);
+
+				{
+					BLING_TRACE_SPAN("json", "parse");
+					boost::property_tree::json_parser::read_json(contentSS, tree);
+				}
 				
 				auto videosTag = tree.get_child("notification_recipient");
 
@@ -158,22 +186,24 @@ namespace desktop { namespace core { namespace agent {
 			}
 			catch (...)
 			{
-			
+				m_metrics.failed();
+
+				BLING_LOG_ERROR("ActivityAgent", "Could not read the notifications: " << utils::logging::currentException());
 			}
 		}
 	}
 
 	void ActivityAgent::armTimer(unsigned int seconds)
 	{
-		if (m_enabled)
+		m_lifecycle.schedule(std::chrono::seconds(seconds), [this]()
 		{
-			m_timer->expires_from_now(boost::posix_time::seconds(seconds));
+			BLING_TRACE_SPAN("agent", "ActivityAgent");
 
-			m_timer->async_wait([&](const boost::system::error_code& ec)
+			m_metrics.run([this]()
 			{
 				execute();
-				armTimer(m_seconds);
 			});
-		}
+			armTimer(m_settings->get()->m_interval);
+		});
 	}
 }}}
\ No newline at end of file
@@ -5,13 +5,16 @@
 #include "../../System/Services/ApplicationDataService.h"
 #include "../../System/Services/IniFileService.h"
 #include "../../System/Services/TimestampFolderService.h"
-#include "../../Utils\Patterns\PublisherSubscriber\Subscriber.h"
+#include "../../System/Services/LiveSettingsService.h"
+#include "../Model/ActivitySettings.h"
+#include "../../Utils/Patterns/PublisherSubscriber/Subscriber.h"
 #include "../../Model/IAgent.h"
+#include "../../Utils/Metrics/AgentMetrics.h"
+#include "../../Utils/Runtime/Lifecycle.h"
 
+#include <memory>
 #include <string>
 #include <map>
-#include <boost/thread.hpp>
-#include <boost/asio.hpp>
 
 namespace desktop { namespace core { 
 	
@@ -31,10 +34,15 @@ namespace desktop { namespace core {
 						std::unique_ptr<service::HTTPClientService> clientService = std::make_unique<service::HTTPClientService>(),
 						std::unique_ptr<service::ApplicationDataService> applicationService = std::make_unique<service::ApplicationDataService>(),
 						std::unique_ptr<service::IniFileService> iniFileService = std::make_unique<service::IniFileService>(),
-						std::unique_ptr<service::TimestampFolderService> timestampFolderService = std::make_unique<service::TimestampFolderService>());
+						std::unique_ptr<service::TimestampFolderService> timestampFolderService = std::make_unique<service::TimestampFolderService>(),
+						utils::runtime::Runtime& runtime = utils::runtime::Runtime::get());
 		~ActivityAgent();
 
-		void getVideos(std::map<std::string, std::string>& videos, const std::string& timestamp, unsigned int page) const;
+		void start() override;
+		void stop() override;
+		bool drain(std::chrono::milliseconds timeout) override;
+
+		void getVideos(const model::Credentials& credentials, std::map<std::string, std::string>& videos, const std::string& timestamp, unsigned int page) const;
 		void execute();
 	private:
 		void armTimer(unsigned int seconds = 10);
@@ -44,17 +52,16 @@ namespace desktop { namespace core {
 	private:
 		std::unique_ptr<service::IniFileService> m_iniFileService;
 
-		boost::asio::io_service		m_ioService;
-		std::unique_ptr<boost::asio::deadline_timer>	m_timer;
-		boost::thread				m_backgroundThread;
-		bool						m_enabled = false;
-		unsigned int				m_seconds;
+		utils::runtime::Lifecycle					m_lifecycle;
+		utils::metrics::AgentMetrics				m_metrics;
 
 		std::unique_ptr<service::IActivityNotificationService> m_activityService;
 		std::unique_ptr<service::HTTPClientService> m_clientService;
-		std::unique_ptr<model::Credentials>			m_credentials;
+		// Written by the broker and read by the timer, so only through std::atomic_load and std::atomic_exchange
+		std::shared_ptr<const model::Credentials>	m_credentials;
 		std::unique_ptr<service::ApplicationDataService> m_applicationService;
 		std::unique_ptr<service::TimestampFolderService> m_timestampFolderService;
+		std::unique_ptr<service::LiveSettingsService<model::ActivitySettings>> m_settings;
 
 		cup::Subscriber m_subscriber;
 	};
@@ -1,31 +1,31 @@
 #include "LiveViewAgent.h"
 
-#include "Utils\Patterns\PublisherSubscriber\Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Logging/Logger.h"
 #include "../../Network/Events.h"
-#include "..\..\Network\Model\Credentials.h"
-#include "..\..\System\Services\IniFileService.h"
-#include "System\Model\ExecutableFile.h"
-#include "System\Model\ProcessInformation.h"
+#include "../../Network/Model/Credentials.h"
+#include "../../System/Services/IniFileService.h"
+#include "System/Model/ExecutableFile.h"
+#include "System/Model/ProcessInformation.h"
 
 #include <boost/filesystem.hpp>
+#include <algorithm>
 #include <iostream>
 #include <chrono>
-#include <locale>
-#include <codecvt>
 #include <string>
 #include <thread>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
-#include <cpprest\http_listener.h>
-#include <cpprest\filestream.h>
-#include <boost/thread.hpp>
+#include <cpprest/http_listener.h>
+#include <cpprest/filestream.h>
 
 namespace desktop { namespace core { namespace agent {
 
 	LiveViewAgent::LiveViewAgent(std::unique_ptr<service::system::ICreateProcessService> createProcessService, 
 									std::unique_ptr<service::system::TerminateProcessService> terminateProcessService,
+									std::unique_ptr<service::system::LifeTimeProcessService> lifeTimeProcessService,
 									std::unique_ptr<service::HTTPClientService> clientService,
 									std::unique_ptr<service::ApplicationDataService> applicationService,
 									std::unique_ptr<service::IniFileService> iniFileService,
@@ -37,22 +37,26 @@ namespace desktop { namespace core { namespace agent {
 	, m_timestampFolderService(std::move(timestampFolderService))
 	, m_createProcessService(std::move(createProcessService))
 	, m_terminateProcessService(std::move(terminateProcessService))
+	, m_lifeTimeProcessService(std::move(lifeTimeProcessService))
 	, m_timeZoneService(std::move(timeZoneService))
+	, m_started(utils::metrics::Registry::get().counter("bling_live_sessions_started_total", "Live views recorded"))
+	, m_sessions(utils::metrics::Registry::get().gauge("bling_live_sessions", "Live views recording right now"))
 	{
 		auto documents = m_applicationService->getMyDocuments();
 
+		m_settings = std::make_unique<service::LiveSettingsService<model::LiveViewSettings>>(documents + "Blink.ini", [this, documents]()
 		{
-			m_seconds = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "LiveView", "Interval", 10);
+			model::LiveViewSettings settings;
 
-			m_outFolder = m_iniFileService->get<std::string>(documents + "Blink.ini", "LiveView", "Output", documents + "Download\\Videos\\");
+			settings.m_output = m_iniFileService->get<std::string>(documents + "Blink.ini", "LiveView", "Output", documents + "Download/Videos/");
+			settings.m_useLocalTime = m_iniFileService->get<bool>(documents + "Blink.ini", "LiveView", "UseLocalTime", false);
 
-			m_saveLocalTime = m_iniFileService->get<bool>(documents + "Blink.ini", "LiveView", "UseLocalTime", false);
-		}
+			return settings;
+		});
 
 		m_endpoint = m_iniFileService->get<std::string>(documents + "Blink.ini", "LiveView", "Endpoint", "http://127.0.0.1:9191/live");
 
-		std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-		std::wstring endpoint = converter.from_bytes(m_endpoint);
+		utility::string_t endpoint = utility::conversions::to_string_t(m_endpoint);
 
 		auto uri = web::uri_builder(endpoint).to_uri();
 
@@ -61,56 +65,114 @@ namespace desktop { namespace core { namespace agent {
 		m_listener->support(web::http::methods::GET, std::bind(&LiveViewAgent::handleGET, this, std::placeholders::_1));
 		m_listener->support(web::http::methods::POST, std::bind(&LiveViewAgent::handlePOST, this, std::placeholders::_1));
 		m_listener->support(web::http::methods::DEL, std::bind(&LiveViewAgent::handleDELETE, this, std::placeholders::_1));
+	}
+
+	LiveViewAgent::~LiveViewAgent()
+	{
+		stop();
+	}
+
+	void LiveViewAgent::start()
+	{
+		m_token = utils::runtime::CancellationToken();
 
 		m_listener->open();
 	}
 
-	LiveViewAgent::~LiveViewAgent()
+	void LiveViewAgent::stop()
 	{
-		m_listener->close();
+		// Releases requests still waiting for a playlist, so closing the listener does not block
+		m_token.cancel();
+
+		try
+		{
+			m_listener->close().wait();
+		}
+		catch (...)
+		{
+			BLING_LOG_WARNING("LiveViewAgent", "Could not close the listener: " << utils::logging::currentException());
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto& liveView : m_liveViews)
+		{
+			finish(std::move(liveView.second));
+		}
+
+		m_liveViews.clear();
+
+		m_sessions.set(0);
+
+		// Gives ffmpeg a moment to close its files, then kills what is left so nothing outlives us
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+
+		for (reap(); !m_stopping.empty() && std::chrono::steady_clock::now() < deadline; reap())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+
+		for (auto& process : m_stopping)
+		{
+			BLING_LOG_WARNING("LiveViewAgent", "ffmpeg " << process->m_processID << " did not stop, killing it");
 
-		m_enabled = false;
+			m_terminateProcessService->terminate(*process);
+		}
 
-		for(auto& liveView : m_liveViews)
+		for (reap(); !m_stopping.empty() && std::chrono::steady_clock::now() < deadline + std::chrono::seconds(1); reap())
 		{
-			m_terminateProcessService->sigint(*liveView.second);
-			m_liveViews.erase(liveView.first);
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
 		}
 	}
 
+	void LiveViewAgent::finish(ProcessType process)
+	{
+		m_terminateProcessService->sigint(*process);
+
+		m_stopping.push_back(std::move(process));
+	}
+
+	void LiveViewAgent::reap()
+	{
+		m_stopping.erase(std::remove_if(m_stopping.begin(), m_stopping.end(), [this](ProcessType& process)
+		{
+			return !m_lifeTimeProcessService->isAlive(*process);
+		}), m_stopping.end());
+	}
+
 	void LiveViewAgent::handleGET(web::http::http_request request) const
 	{
 		using namespace web::http;
 
 		auto bodyws = request.request_uri().path();
 
-		std::string body(bodyws.begin(), bodyws.end());
-
-		body = boost::replace_all_copy(body.substr(6), "/", "\\");
+		std::string body = utility::conversions::to_utf8string(bodyws);
 
-		boost::replace_all(body, "%20", " ");
+		body = boost::replace_all_copy(body.substr(6), "%20", " ");
 
-		boost::filesystem::path path(m_outFolder + body);
+		boost::filesystem::path path(m_settings->get()->m_output + body);
 		
 		if(path.extension() == ".m3u8")
 		{
 			while(!boost::filesystem::exists(path))
 			{
-				boost::this_thread::sleep_for(boost::chrono::milliseconds(200));
+				if (!m_token.sleepFor(std::chrono::milliseconds(200)))
+				{
+					break;
+				}
 			}
 		}
 
 		if (boost::filesystem::exists(path))
 		{
-			std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-			std::wstring pathws = converter.from_bytes(path.string());
+			utility::string_t pathws = utility::conversions::to_string_t(path.string());
 
 			concurrency::streams::fstream::open_istream(pathws, std::ios::in)
 				.then([=](concurrency::streams::istream is)
 			{
 				web::http::http_response response(web::http::status_codes::OK);
 
-				response.headers().add(L"Content-Disposition", U("inline; filename = \"") + pathws + U("\""));
+				response.headers().add(U("Content-Disposition"), U("inline; filename = \"") + pathws + U("\""));
 				response.set_body(std::move(is), U("application/x-mpegURL"));
 
 				request.reply(response).then([](pplx::task<void> t) {});
@@ -128,9 +190,9 @@ namespace desktop { namespace core { namespace agent {
 
 		auto payload = request.extract_json().get();
 
-		std::wstring urlws = payload.at(L"url").as_string();
+		utility::string_t urlws = payload.at(U("url")).as_string();
 
-		std::string url(urlws.begin(), urlws.end());
+		std::string url = utility::conversions::to_utf8string(urlws);
 
 		m_RTP = std::make_unique<model::RTP>(url);
 
@@ -143,7 +205,9 @@ namespace desktop { namespace core { namespace agent {
 
 		std::string currentTime = iso.substr(0, iso.find_first_of(",")) + "+00:00";
 
-		if (m_saveLocalTime)
+		auto settings = m_settings->get();
+
+		if (settings->m_useLocalTime)
 		{
 			currentTime = m_timeZoneService->universalToLocal(currentTime);
 		}
@@ -156,33 +220,47 @@ namespace desktop { namespace core { namespace agent {
 
 		auto folder = folderSS.str();
 
-		auto absPath = m_outFolder + folder;
+		auto absPath = settings->m_output + folder;
 
 		boost::filesystem::create_directories(absPath);
 
-		auto arguments = "-report -i \"" + m_RTP->m_url + "\" -c copy -vcodec copy -g 30 -hls_time 1 out.m3u8 -vcodec copy " + currentTime + ".mp4";
+		// The URL comes from the request body, so it stays a single argument
+		std::vector<std::string> arguments = { "-report", "-i", m_RTP->m_url, "-c", "copy", "-vcodec", "copy", "-g", "30", "-hls_time", "1", "out.m3u8", "-vcodec", "copy", currentTime + ".mp4" };
+
+#ifdef _WIN32
+		auto ffmpegPath = appFolder + "/ffmpeg.exe";
+#else
+		// Linux installs take ffmpeg from the distribution, so it is looked up on the PATH
+		std::string ffmpegPath = "ffmpeg";
+#endif
 
-		model::system::ExecutableFile ffmpeg(model::system::ExecutableFile::Path(appFolder + "\\ffmpeg.exe"), model::system::ExecutableFile::Arguments(arguments));
+		model::system::ExecutableFile ffmpeg(model::system::ExecutableFile::Path(ffmpegPath), model::system::ExecutableFile::Arguments(arguments));
 
-		int camera_id = payload.at(L"camera_id").as_integer();
+		int camera_id = payload.at(U("camera_id")).as_integer();
 
-		std::wstringstream camera_idss;
+		utility::stringstream_t camera_idss;
 		camera_idss << camera_id;
 
 		auto process = m_createProcessService->create(ffmpeg, absPath);
 
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		reap();
+
 		m_liveViews.insert(std::make_pair(camera_id, std::move(process)));
 
+		m_started.increment();
+		m_sessions.set(m_liveViews.size());
+
 		boost::replace_all(folder, "\\", "/");
 
 		std::string endpoint = m_endpoint + "/" + boost::replace_all_copy(folder, "\\", "/") + "/out.m3u8";
 
-		std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-		std::wstring endpointws = converter.from_bytes(endpoint);
+		utility::string_t endpointws = utility::conversions::to_string_t(endpoint);
 
 		http_response response(status_codes::OK);
-		response.headers().set_content_type(L"application/json");
-		response.set_body(L"{\"camera_id\": " + camera_idss.str() + L", \"url\": \"" + endpointws + L"\"}");
+		response.headers().set_content_type(U("application/json"));
+		response.set_body(U("{\"camera_id\": ") + camera_idss.str() + U(", \"url\": \"") + endpointws + U("\"}"));
 
 		request.reply(response);
 	}
@@ -193,19 +271,25 @@ namespace desktop { namespace core { namespace agent {
 
 		auto payload = request.extract_json().get();
 
-		int camera_id = payload.at(L"camera_id").as_integer();
+		int camera_id = payload.at(U("camera_id")).as_integer();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		reap();
 
 		auto liveView = m_liveViews.find(camera_id);
 
 		if (liveView != m_liveViews.end())
 		{
-			m_terminateProcessService->sigint(*liveView->second);
+			finish(std::move(liveView->second));
+
+			m_liveViews.erase(liveView);
 
-			m_liveViews.erase(camera_id);
+			m_sessions.set(m_liveViews.size());
 
 			http_response response(status_codes::OK);
-			response.headers().set_content_type(L"application/json");
-			response.set_body(L"{}");
+			response.headers().set_content_type(U("application/json"));
+			response.set_body(U("{}"));
 			
 			request.reply(response);
 		}
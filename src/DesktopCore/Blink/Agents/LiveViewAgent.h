@@ -6,13 +6,20 @@
 #include "../../System/Services/TimestampFolderService.h"
 #include "../../System/Services/Process/CreateProcessService.h"
 #include "../../System/Services/Process/TerminateProcessService.h"
+#include "../../System/Services/Process/LifeTimeProcessService.h"
 #include "../../System/Services/TimeZoneService.h"
-#include "../../Utils\Patterns\PublisherSubscriber\Subscriber.h"
+#include "../../System/Services/LiveSettingsService.h"
+#include "../Model/LiveViewSettings.h"
+#include "../../Utils/Patterns/PublisherSubscriber/Subscriber.h"
 #include "../../Model/IAgent.h"
+#include "../../Utils/Metrics/Metrics.h"
+#include "../../Utils/Runtime/CancellationToken.h"
 
 #include <string>
 #include <map>
-#include <cpprestsdk/cpprest/http_msg.h>
+#include <mutex>
+#include <vector>
+#include <cpprest/http_msg.h>
 
 namespace web { namespace http { namespace experimental { namespace listener { class http_listener; } } } }
 
@@ -32,6 +39,7 @@ namespace desktop { namespace core {
 	public:
 		LiveViewAgent(std::unique_ptr<service::system::ICreateProcessService> createProcessService = std::make_unique<service::system::CreateProcessService>(),
 						std::unique_ptr<service::system::TerminateProcessService> terminateProcessService = std::make_unique<service::system::TerminateProcessService>(),
+						std::unique_ptr<service::system::LifeTimeProcessService> lifeTimeProcessService = std::make_unique<service::system::LifeTimeProcessService>(),
 						std::unique_ptr<service::HTTPClientService> clientService = std::make_unique<service::HTTPClientService>(),
 						std::unique_ptr<service::ApplicationDataService> applicationService = std::make_unique<service::ApplicationDataService>(),
 						std::unique_ptr<service::IniFileService> iniFileService = std::make_unique<service::IniFileService>(),
@@ -39,17 +47,27 @@ namespace desktop { namespace core {
 						std::unique_ptr<service::TimeZoneService> timeZoneService = std::make_unique<service::TimeZoneService>());
 		~LiveViewAgent();
 
+		void start() override;
+		void stop() override;
+
 		void handlePOST(web::http::http_request);
 		void handleGET(web::http::http_request) const;
 		void handleDELETE(web::http::http_request);
+	private:
+		typedef std::unique_ptr<model::system::ProcessInformation> ProcessType;
+
+		// Asks ffmpeg to finish its file; it is reaped once it exited
+		void finish(ProcessType process);
+		// Forgets the stopped processes that exited, which also reaps them on Linux
+		void reap();
 	private:
 		std::unique_ptr<service::IniFileService> m_iniFileService;
-		bool						m_enabled = false;
-		unsigned int				m_seconds;
-		bool						m_saveLocalTime;
+		utils::runtime::CancellationToken	m_token;
 		std::string					m_endpoint;
 
-		std::map<int, std::unique_ptr<model::system::ProcessInformation>> m_liveViews;
+		std::map<int, ProcessType>			m_liveViews;
+		std::vector<ProcessType>			m_stopping;
+		std::mutex							m_mutex;
 
 		std::unique_ptr<service::HTTPClientService> m_clientService;
 		std::unique_ptr<model::RTP>			m_RTP;
@@ -57,10 +75,13 @@ namespace desktop { namespace core {
 		std::unique_ptr<service::TimestampFolderService> m_timestampFolderService;
 		std::unique_ptr<service::system::ICreateProcessService> m_createProcessService;
 		std::unique_ptr<service::system::TerminateProcessService> m_terminateProcessService;
+		std::unique_ptr<service::system::LifeTimeProcessService> m_lifeTimeProcessService;
 		std::unique_ptr<service::TimeZoneService>		m_timeZoneService;
 		std::unique_ptr<web::http::experimental::listener::http_listener> m_listener;
+		std::unique_ptr<service::LiveSettingsService<model::LiveViewSettings>> m_settings;
 		cup::Subscriber m_subscriber;
 
-		std::string m_outFolder;
+		utils::metrics::Counter&			m_started;
+		utils::metrics::Gauge&				m_sessions;
 	};
 }}}
\ No newline at end of file
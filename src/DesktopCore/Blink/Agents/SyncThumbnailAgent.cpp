@@ -1,16 +1,19 @@
 #include "SyncThumbnailAgent.h"
 
-#include "Utils\Patterns\PublisherSubscriber\Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Logging/Logger.h"
+#include "Utils/Timestamp/Timestamp.h"
+#include "Utils/Tracing/Tracer.h"
 #include "../../Network/Events.h"
-#include "..\..\Network\Model\Credentials.h"
-#include "..\..\System\Services\IniFileService.h"
+#include "../../Network/JournalCodecs.h"
+#include "../../Network/Model/Credentials.h"
+#include "../../System/Services/IniFileService.h"
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/filesystem.hpp>
 #include <iostream>
 #include <chrono>
-#include <thread>
 #include <map>
 
 namespace desktop { namespace core { namespace agent {
@@ -19,9 +22,12 @@ namespace desktop { namespace core { namespace agent {
 									std::unique_ptr<service::HTTPClientService> clientService,
 									std::unique_ptr<service::ApplicationDataService> applicationService,
 									std::unique_ptr<service::IniFileService> iniFileService,
-									std::unique_ptr<service::TimestampFolderService> timestampFolderService)
-	: m_ioService()
-	, m_iniFileService(std::move(iniFileService))
+									std::unique_ptr<service::TimestampFolderService> timestampFolderService,
+									utils::runtime::Runtime& runtime)
+	: m_iniFileService(std::move(iniFileService))
+	, m_lifecycle(runtime)
+	, m_metrics("SyncThumbnailAgent")
+	, m_thumbnails(utils::metrics::Registry::get().counter("bling_sync_thumbnail_thumbnails_total", "Thumbnails downloaded"))
 	, m_downloadService(std::move(downloadService))
 	, m_clientService(std::move(clientService))
 	, m_applicationService(std::move(applicationService))
@@ -29,45 +35,64 @@ namespace desktop { namespace core { namespace agent {
 	{
 		auto documents = m_applicationService->getMyDocuments();
 
+		m_settings = std::make_unique<service::LiveSettingsService<model::SyncThumbnailSettings>>(documents + "Blink.ini", [this, documents]()
 		{
-			m_seconds = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncThumbnail", "Interval", 3600);
+			model::SyncThumbnailSettings settings;
 
-			m_timer = std::make_unique<boost::asio::deadline_timer>(m_ioService, boost::posix_time::seconds(m_seconds));
+			settings.m_enabled = m_iniFileService->get<bool>(documents + "Blink.ini", "SyncThumbnail", "Enabled", false);
+			settings.m_interval = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncThumbnail", "Interval", 3600);
+			settings.m_sleep = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncThumbnail", "Sleep", 5);
+			settings.m_retries = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncThumbnail", "Retries", 10);
+			settings.m_output = m_iniFileService->get<std::string>(documents + "Blink.ini", "SyncThumbnail", "Output", documents + "Download/Thumbnails/");
 
-			m_outFolder = m_iniFileService->get<std::string>(documents + "Blink.ini", "SyncThumbnail", "Output", documents + "Download\\Thumbnails\\");
+			return settings;
+		});
 
-			boost::filesystem::create_directories(m_outFolder);
-		}
-
-		if(m_iniFileService->get<bool>(documents + "Blink.ini", "SyncThumbnail", "Enabled", false))
+		auto onCredentials = [this](const core::events::CredentialsEvent& evt)
 		{
-			m_subscriber.subscribe([this](const desktop::core::utils::patterns::Event& rawEvt)
+			// Swapped atomically, execute takes its own copy on the blocking pool
+			bool first = !std::atomic_exchange(&m_credentials, evt.m_credentials);
+
+			// Does nothing before start, which arms the timer itself once credentials exist
+			if (first)
 			{
-				const auto& evt = static_cast<const core::events::CredentialsEvent&>(rawEvt);
+				armTimer(1);
+			}
+		};
+
+		// Resume with the credentials of the last session before the viewer sends new ones
+		cup::Journal::get().replay<core::events::CredentialsEvent>([&onCredentials](const core::events::CredentialsEvent& evt)
+		{
+			onCredentials(evt);
+		});
 
-				m_credentials = std::make_unique<model::Credentials>(evt.m_credentials);
+		m_subscriber.subscribe<core::events::CredentialsEvent>("SyncThumbnailAgent", onCredentials, cup::DeliveryPolicy::executor(cup::CORE_EXECUTOR));
+	}
 
-				auto documents = m_applicationService->getMyDocuments();
-			
-				if (!m_enabled)
-				{
-					m_enabled = true;
+	SyncThumbnailAgent::~SyncThumbnailAgent()
+	{
+		m_lifecycle.stop();
+		m_lifecycle.wait();
+	}
 
-					armTimer(1);
+	void SyncThumbnailAgent::start()
+	{
+		m_lifecycle.start();
 
-					boost::thread t(boost::bind(&boost::asio::io_service::run, &m_ioService));
-					m_backgroundThread.swap(t);
-				}
-			}, events::CREDENTIALS_EVENT);
+		if (std::atomic_load(&m_credentials))
+		{
+			armTimer(1);
 		}
 	}
 
-	SyncThumbnailAgent::~SyncThumbnailAgent()
+	void SyncThumbnailAgent::stop()
 	{
-		m_enabled = false;
-		m_timer->cancel();
-		m_backgroundThread.join();
-		m_ioService.reset();
+		m_lifecycle.stop();
+	}
+
+	bool SyncThumbnailAgent::drain(std::chrono::milliseconds timeout)
+	{
+		return m_lifecycle.drain(timeout);
 	}
 
 	std::string SyncThumbnailAgent::getLastUpdateTimestamp() const
@@ -85,16 +110,13 @@ namespace desktop { namespace core { namespace agent {
 
 		struct tm timeinfo;
 
+#ifdef _WIN32
 		localtime_s(&timeinfo, &rawtime);
+#else
+		localtime_r(&rawtime, &timeinfo);
+#endif
 
-		std::stringstream ss;
-		ss << timeinfo.tm_year + 1900 << "-" << std::setfill('0') << std::setw(2) << timeinfo.tm_mon + 1 << "-"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_mday
-			<< "T" << std::setfill('0') << std::setw(2) << timeinfo.tm_hour << ":"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_min << ":"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_sec << "+00:00";
-		
-		setLastUpdateTimestamp(ss.str());
+		setLastUpdateTimestamp(utils::timestamp::toString(utils::timestamp::fromTm(timeinfo)));
 	}
 
 	void SyncThumbnailAgent::setLastUpdateTimestamp(const std::string& timestamp) const
@@ -106,126 +128,182 @@ namespace desktop { namespace core { namespace agent {
 
 	void SyncThumbnailAgent::execute()
 	{
-		if (m_enabled && m_credentials)
+		auto credentials = std::atomic_load(&m_credentials);
+
+		if (!m_lifecycle.running() || !credentials || !m_settings->get()->m_enabled)
+		{
+			m_cameras.clear();
+			m_command.reset();
+			return;
+		}
+
+		// Each tick polls the pending command once; the timer comes back after Sleep seconds while it is not complete
+		if (m_command)
+		{
+			if (!pollCompletion(*credentials))
+			{
+				return;
+			}
+		}
+		else if (m_cameras.empty())
 		{
 			std::vector<std::pair<unsigned int, std::vector<unsigned int>>> networkInfo;
 
-			getNetworkInfo(networkInfo);
+			getNetworkInfo(*credentials, networkInfo);
 
 			for (auto& network : networkInfo)
 			{
 				for (auto& camera : network.second)
 				{
-					requestThumbnail(network.first, camera);
+					m_cameras.emplace_back(network.first, camera);
 				}
 			}
 		}
+
+		while (!m_command && !m_cameras.empty())
+		{
+			if (!m_lifecycle.running())
+			{
+				return;
+			}
+
+			auto camera = m_cameras.front();
+
+			m_cameras.pop_front();
+
+			requestThumbnail(*credentials, camera.first, camera.second);
+		}
 	}
 
-	void SyncThumbnailAgent::requestThumbnail(unsigned int network, unsigned int camera) const
+	bool SyncThumbnailAgent::requestThumbnail(const model::Credentials& credentials, unsigned int network, unsigned int camera)
 	{
 		std::map<std::string, std::string> requestHeaders, responseHeaders;
 		std::string content;
 		unsigned int status;
 
-		requestHeaders["token_auth"] = m_credentials->m_token;
+		requestHeaders["token_auth"] = credentials.m_token;
 
 		std::stringstream path;
 		path << "/network/" << network << "/camera/" << camera << "/thumbnail";
 
-		if (m_clientService->post(m_credentials->m_host, m_credentials->m_port, path.str(), requestHeaders, responseHeaders, content, status))
+		if (m_clientService->post(credentials.m_host, credentials.m_port, path.str(), requestHeaders, responseHeaders, content, status, m_lifecycle.token()))
 		{
 			try
 			{
 				boost::property_tree::ptree tree;
 
 				std::stringstream contentSS(content);
-				boost::property_tree::json_parser::read_json(contentSS, tree);
 
-				auto command = tree.get_child("id").get_value<unsigned int>();
-
-				if (waitForCompletion(network, command))
 				{
-					saveThumbnail(network, camera);
+					BLING_TRACE_SPAN("json", "parse");
+					boost::property_tree::json_parser::read_json(contentSS, tree);
 				}
+
+				auto command = tree.get_child("id").get_value<unsigned int>();
+
+				m_command.reset(new Command{ network, camera, command, 0 });
+
+				return true;
 			}
 			catch (...)
 			{
+				m_metrics.failed();
 
+				BLING_LOG_ERROR("SyncThumbnailAgent", "Thumbnail of camera " << camera << " was not requested: " << utils::logging::currentException());
 			}
 		}
+
+		return false;
 	}
 
-	bool SyncThumbnailAgent::waitForCompletion(unsigned int network, unsigned int command) const
+	bool SyncThumbnailAgent::pollCompletion(const model::Credentials& credentials)
 	{
 		std::map<std::string, std::string> requestHeaders, responseHeaders;
 		std::string content;
 		unsigned int status;
 
-		requestHeaders["token_auth"] = m_credentials->m_token;
+		requestHeaders["token_auth"] = credentials.m_token;
 
-		auto documents = m_applicationService->getMyDocuments();
-		unsigned int sleep = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncThumbnail", "Sleep", 5);
-		unsigned int maxRetries = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncThumbnail", "Retries", 10);
+		auto command = *m_command;
 
 		std::stringstream path;
-		path << "/network/" << network << "/command/" << command;
+		path << "/network/" << command.m_network << "/command/" << command.m_id;
 
-		bool completed = false;
-		unsigned int retry = 0;
+		auto token = m_lifecycle.token();
 
 		try
 		{
 			boost::property_tree::ptree tree;
-			
-			do
+
+			m_clientService->get(credentials.m_host, credentials.m_port, path.str(), requestHeaders, responseHeaders, content, status, token);
+
+			if (token.cancelled())
 			{
-				std::this_thread::sleep_for(std::chrono::seconds{ sleep });
-				m_clientService->get(m_credentials->m_host, m_credentials->m_port, path.str(), requestHeaders, responseHeaders, content, status);
+				m_command.reset();
+				return true;
+			}
 
-				std::stringstream contentSS(content);
-				boost::property_tree::json_parser::read_json(contentSS, tree);
+			std::stringstream contentSS(content);
 
-				completed = tree.get_child("complete").get_value<bool>();
+			{
+				BLING_TRACE_SPAN("json", "parse");
+				boost::property_tree::json_parser::read_json(contentSS, tree);
+			}
 
-				++retry;
-			} while (!completed && retry < maxRetries);
+			bool completed = tree.get_child("complete").get_value<bool>();
 
-			return true;
+			if (!completed && ++m_command->m_retries < m_settings->get()->m_retries)
+			{
+				return false;
+			}
 		}
 		catch (...)
 		{
-		
+			m_metrics.failed();
+
+			BLING_LOG_ERROR("SyncThumbnailAgent", "Command " << command.m_id << " of network " << command.m_network << " did not complete: " << utils::logging::currentException());
+
+			m_command.reset();
+			return true;
 		}
 
-		return false;
+		// Like before, the thumbnail is saved once the retries are used up even if the command never completed
+		m_command.reset();
+
+		saveThumbnail(credentials, command.m_network, command.m_camera);
+
+		return true;
 	}
 
-	void SyncThumbnailAgent::saveThumbnail(unsigned int network, unsigned int camera) const
+	void SyncThumbnailAgent::saveThumbnail(const model::Credentials& credentials, unsigned int network, unsigned int camera) const
 	{
 		std::map<std::string, std::string> requestHeaders, responseHeaders;
 		std::string content;
 		unsigned int status;
 
-		requestHeaders["token_auth"] = m_credentials->m_token;
+		requestHeaders["token_auth"] = credentials.m_token;
 
 		std::stringstream path;
 		path << "/network/" << network << "/camera/" << camera;
 
-		if (m_clientService->get(m_credentials->m_host, m_credentials->m_port, path.str(), requestHeaders, responseHeaders, content, status))
+		if (m_clientService->get(credentials.m_host, credentials.m_port, path.str(), requestHeaders, responseHeaders, content, status, m_lifecycle.token()))
 		{
 			try
 			{
 				boost::property_tree::ptree tree;
 
 				std::stringstream contentSS(content);
-				boost::property_tree::json_parser::read_json(contentSS, tree);
+
+				{
+					BLING_TRACE_SPAN("json", "parse");
+					boost::property_tree::json_parser::read_json(contentSS, tree);
+				}
 
 				auto status = tree.get_child("camera_status");
 
 				auto thumbnail = status.get_child("thumbnail").get_value<std::string>();
 
-				auto folder = m_outFolder + m_timestampFolderService->get(status.get_child("updated_at").get_value<std::string>());
+				auto folder = m_settings->get()->m_output + m_timestampFolderService->get(status.get_child("updated_at").get_value<std::string>());
 				auto target = folder + boost::filesystem::path(thumbnail + ".jpg").filename().string();
 
 				if (!boost::filesystem::exists(folder))
@@ -233,33 +311,42 @@ namespace desktop { namespace core { namespace agent {
 					boost::filesystem::create_directories(folder);
 				}
 
-				m_downloadService->download(m_credentials->m_host, thumbnail + ".jpg", requestHeaders, target);
+				if (!m_downloadService->download(credentials.m_host, thumbnail + ".jpg", requestHeaders, target, m_lifecycle.token()).empty())
+				{
+					m_thumbnails.increment();
+				}
 			}
 			catch (...)
 			{
-				
+				m_metrics.failed();
+
+				BLING_LOG_ERROR("SyncThumbnailAgent", "Thumbnail of camera " << camera << " was not saved: " << utils::logging::currentException());
 			}
 		}
 	}
 
-	void SyncThumbnailAgent::getNetworkInfo(std::vector<std::pair<unsigned int, std::vector<unsigned int>>>& cameras) const
+	void SyncThumbnailAgent::getNetworkInfo(const model::Credentials& credentials, std::vector<std::pair<unsigned int, std::vector<unsigned int>>>& cameras) const
 	{
 		std::map<std::string, std::string> requestHeaders, responseHeaders;
 		std::string content;
 		unsigned int status;
 
-		requestHeaders["token_auth"] = m_credentials->m_token;
+		requestHeaders["token_auth"] = credentials.m_token;
 
 		std::string path = "/api/v1/camera/usage";
 
-		if (m_clientService->get(m_credentials->m_host, m_credentials->m_port, path, requestHeaders, responseHeaders, content, status))
+		if (m_clientService->get(credentials.m_host, credentials.m_port, path, requestHeaders, responseHeaders, content, status, m_lifecycle.token()))
 		{
 			std::stringstream contentSS(content);
 
 			try
 			{
 				boost::property_tree::ptree tree;
-				boost::property_tree::json_parser::read_json(contentSS, tree);
+
+				{
+					BLING_TRACE_SPAN("json", "parse");
+					boost::property_tree::json_parser::read_json(contentSS, tree);
+				}
 				
 				auto networks = tree.get_child("networks");
 
@@ -281,22 +368,27 @@ namespace desktop { namespace core { namespace agent {
 			}
 			catch (...)
 			{
-			
+				m_metrics.failed();
+
+				BLING_LOG_ERROR("SyncThumbnailAgent", "Could not read the cameras: " << utils::logging::currentException());
 			}
 		}
 	}
 
 	void SyncThumbnailAgent::armTimer(unsigned int seconds)
 	{
-		if (m_enabled)
+		m_lifecycle.schedule(std::chrono::seconds(seconds), [this]()
 		{
-			m_timer->expires_from_now(boost::posix_time::seconds(seconds));
+			BLING_TRACE_SPAN("agent", "SyncThumbnailAgent");
 
-			m_timer->async_wait([&](const boost::system::error_code& ec)
+			m_metrics.run([this]()
 			{
 				execute();
-				armTimer(m_seconds);
 			});
-		}
+
+			auto settings = m_settings->get();
+
+			armTimer(m_command ? settings->m_sleep : settings->m_interval);
+		});
 	}
 }}}
\ No newline at end of file
@@ -5,13 +5,17 @@
 #include "../../System/Services/ApplicationDataService.h"
 #include "../../System/Services/IniFileService.h"
 #include "../../System/Services/TimestampFolderService.h"
-#include "../../Utils\Patterns\PublisherSubscriber\Subscriber.h"
+#include "../../System/Services/LiveSettingsService.h"
+#include "../Model/SyncThumbnailSettings.h"
+#include "../../Utils/Patterns/PublisherSubscriber/Subscriber.h"
 #include "../../Model/IAgent.h"
+#include "../../Utils/Metrics/AgentMetrics.h"
+#include "../../Utils/Runtime/Lifecycle.h"
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <map>
-#include <boost/thread.hpp>
-#include <boost/asio.hpp>
 
 namespace desktop { namespace core { 
 	
@@ -31,34 +35,49 @@ namespace desktop { namespace core {
 						std::unique_ptr<service::HTTPClientService> clientService = std::make_unique<service::HTTPClientService>(),
 						std::unique_ptr<service::ApplicationDataService> applicationService = std::make_unique<service::ApplicationDataService>(),
 						std::unique_ptr<service::IniFileService> iniFileService = std::make_unique<service::IniFileService>(),
-						std::unique_ptr<service::TimestampFolderService> timestampFolderService = std::make_unique<service::TimestampFolderService>());
+						std::unique_ptr<service::TimestampFolderService> timestampFolderService = std::make_unique<service::TimestampFolderService>(),
+						utils::runtime::Runtime& runtime = utils::runtime::Runtime::get());
 		~SyncThumbnailAgent();
 
-		void getNetworkInfo(std::vector<std::pair<unsigned int, std::vector<unsigned int>>>& cameras) const;
-		void requestThumbnail(unsigned int network, unsigned int camera) const;
-		void saveThumbnail(unsigned int network, unsigned int camera) const;
+		void start() override;
+		void stop() override;
+		bool drain(std::chrono::milliseconds timeout) override;
+
+		void getNetworkInfo(const model::Credentials& credentials, std::vector<std::pair<unsigned int, std::vector<unsigned int>>>& cameras) const;
+		bool requestThumbnail(const model::Credentials& credentials, unsigned int network, unsigned int camera);
+		void saveThumbnail(const model::Credentials& credentials, unsigned int network, unsigned int camera) const;
 		void execute();
 	private:
 		void armTimer(unsigned int seconds = 60);
 		std::string getLastUpdateTimestamp() const;
 		void setLastUpdateTimestamp() const;
 		void setLastUpdateTimestamp(const std::string&) const;
-		bool waitForCompletion(unsigned int network, unsigned int command) const;
+		bool pollCompletion(const model::Credentials& credentials);
 	private:
+		struct Command
+		{
+			unsigned int m_network;
+			unsigned int m_camera;
+			unsigned int m_id;
+			unsigned int m_retries;
+		};
+
 		std::unique_ptr<service::IniFileService> m_iniFileService;
 
-		boost::asio::io_service		m_ioService;
-		std::unique_ptr<boost::asio::deadline_timer>	m_timer;
-		boost::thread				m_backgroundThread;
-		std::string					m_outFolder;
-		bool						m_enabled = false;
-		unsigned int				m_seconds;
+		utils::runtime::Lifecycle					m_lifecycle;
+		utils::metrics::AgentMetrics				m_metrics;
+		utils::metrics::Counter&					m_thumbnails;
 
 		std::unique_ptr<service::IDownloadFileService> m_downloadService;
 		std::unique_ptr<service::HTTPClientService> m_clientService;
-		std::unique_ptr<model::Credentials>			m_credentials;
+		// Written by the broker and read by the timer, so only through std::atomic_load and std::atomic_exchange
+		std::shared_ptr<const model::Credentials>	m_credentials;
+		// Cameras of the current run still to request and the command polled for the last one; only touched by the timer
+		std::deque<std::pair<unsigned int, unsigned int>> m_cameras;
+		std::unique_ptr<Command>					m_command;
 		std::unique_ptr<service::ApplicationDataService> m_applicationService;
 		std::unique_ptr<service::TimestampFolderService> m_timestampFolderService;
+		std::unique_ptr<service::LiveSettingsService<model::SyncThumbnailSettings>> m_settings;
 
 		cup::Subscriber m_subscriber;
 	};
@@ -1,9 +1,14 @@
 #include "SyncVideoAgent.h"
 
-#include "Utils\Patterns\PublisherSubscriber\Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Logging/Logger.h"
+#include "Utils/Timestamp/Timestamp.h"
+#include "Utils/Tracing/Tracer.h"
 #include "../../Network/Events.h"
-#include "..\..\Network\Model\Credentials.h"
-#include "..\..\System\Services\IniFileService.h"
+#include "../../Network/JournalCodecs.h"
+#include "../../Network/Model/Credentials.h"
+#include "../../System/Services/IniFileService.h"
+#include "../Services/MediaIndex.h"
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -11,7 +16,6 @@
 #include <boost/algorithm/string.hpp> 
 #include <iostream>
 #include <chrono>
-#include <thread>
 
 namespace desktop { namespace core { namespace agent {
 
@@ -20,9 +24,13 @@ namespace desktop { namespace core { namespace agent {
 									std::unique_ptr<service::ApplicationDataService> applicationService,
 									std::unique_ptr<service::IniFileService> iniFileService,
 									std::unique_ptr<service::TimestampFolderService> timestampFolderService,
-									std::unique_ptr<service::TimeZoneService> timeZoneService)
-	: m_ioService()
-	, m_iniFileService(std::move(iniFileService))
+									std::unique_ptr<service::TimeZoneService> timeZoneService,
+									utils::runtime::Runtime& runtime)
+	: m_iniFileService(std::move(iniFileService))
+	, m_lifecycle(runtime)
+	, m_metrics("SyncVideoAgent")
+	, m_clips(utils::metrics::Registry::get().counter("bling_sync_video_clips_total", "Clips downloaded"))
+	, m_clipsLastRun(utils::metrics::Registry::get().gauge("bling_sync_video_clips_last_run", "New clips listed by the last run"))
 	, m_downloadService(std::move(downloadService))
 	, m_clientService(std::move(clientService))
 	, m_applicationService(std::move(applicationService))
@@ -31,47 +39,64 @@ namespace desktop { namespace core { namespace agent {
 	{
 		auto documents = m_applicationService->getMyDocuments();
 
+		m_settings = std::make_unique<service::LiveSettingsService<model::SyncVideoSettings>>(documents + "Blink.ini", [this, documents]()
 		{
-			m_saveLocalTime = m_iniFileService->get<bool>(documents + "Blink.ini", "SyncVideo", "UseLocalTime", false);
+			model::SyncVideoSettings settings;
 
-			m_seconds = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncVideo", "Interval", 60);
+			settings.m_enabled = m_iniFileService->get<bool>(documents + "Blink.ini", "SyncVideo", "Enabled", true);
+			settings.m_useLocalTime = m_iniFileService->get<bool>(documents + "Blink.ini", "SyncVideo", "UseLocalTime", false);
+			settings.m_interval = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncVideo", "Interval", 60);
+			settings.m_sleep = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncVideo", "Sleep", 20);
+			settings.m_output = m_iniFileService->get<std::string>(documents + "Blink.ini", "SyncVideo", "Output", documents + "Download/Videos/");
 
-			m_timer = std::make_unique<boost::asio::deadline_timer>(m_ioService, boost::posix_time::seconds(m_seconds));
+			return settings;
+		});
 
-			m_outFolder = m_iniFileService->get<std::string>(documents + "Blink.ini", "SyncVideo", "Output", documents + "Download\\Videos\\");
+		auto onCredentials = [this](const core::events::CredentialsEvent& evt)
+		{
+			// Swapped atomically, execute takes its own copy on the blocking pool
+			bool first = !std::atomic_exchange(&m_credentials, evt.m_credentials);
 
-			boost::filesystem::create_directories(m_outFolder);
-		}
+			// Does nothing before start, which arms the timer itself once credentials exist
+			if (first)
+			{
+				armTimer(1);
+			}
+		};
 
-		if(m_iniFileService->get<bool>(documents + "Blink.ini", "SyncVideo", "Enabled", true))
+		// Resume with the credentials of the last session before the viewer sends new ones
+		cup::Journal::get().replay<core::events::CredentialsEvent>([&onCredentials](const core::events::CredentialsEvent& evt)
 		{
-			m_subscriber.subscribe([this](const desktop::core::utils::patterns::Event& rawEvt)
-			{
-				const auto& evt = static_cast<const core::events::CredentialsEvent&>(rawEvt);
+			onCredentials(evt);
+		});
 
-				m_credentials = std::make_unique<model::Credentials>(evt.m_credentials);
+		m_subscriber.subscribe<core::events::CredentialsEvent>("SyncVideoAgent", onCredentials, cup::DeliveryPolicy::executor(cup::CORE_EXECUTOR));
+	}
 
-				auto documents = m_applicationService->getMyDocuments();
-			
-				if (!m_enabled)
-				{
-					m_enabled = true;
+	SyncVideoAgent::~SyncVideoAgent()
+	{
+		m_lifecycle.stop();
+		m_lifecycle.wait();
+	}
 
-					armTimer(1);
+	void SyncVideoAgent::start()
+	{
+		m_lifecycle.start();
 
-					boost::thread t(boost::bind(&boost::asio::io_service::run, &m_ioService));
-					m_backgroundThread.swap(t);
-				}
-			}, events::CREDENTIALS_EVENT);
+		if (std::atomic_load(&m_credentials))
+		{
+			armTimer(1);
 		}
 	}
 
-	SyncVideoAgent::~SyncVideoAgent()
+	void SyncVideoAgent::stop()
 	{
-		m_enabled = false;
-		m_timer->cancel();
-		m_backgroundThread.join();
-		m_ioService.reset();
+		m_lifecycle.stop();
+	}
+
+	bool SyncVideoAgent::drain(std::chrono::milliseconds timeout)
+	{
+		return m_lifecycle.drain(timeout);
 	}
 
 	std::string SyncVideoAgent::getLastUpdateTimestamp() const
@@ -89,16 +114,13 @@ namespace desktop { namespace core { namespace agent {
 
 		struct tm timeinfo;
 
+#ifdef _WIN32
 		localtime_s(&timeinfo, &rawtime);
+#else
+		localtime_r(&rawtime, &timeinfo);
+#endif
 
-		std::stringstream ss;
-		ss << timeinfo.tm_year + 1900 << "-" << std::setfill('0') << std::setw(2) << timeinfo.tm_mon + 1 << "-"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_mday
-			<< "T" << std::setfill('0') << std::setw(2) << timeinfo.tm_hour << ":"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_min << ":"
-			<< std::setfill('0') << std::setw(2) << timeinfo.tm_sec << "+00:00";
-		
-		setLastUpdateTimestamp(ss.str());
+		setLastUpdateTimestamp(utils::timestamp::toString(utils::timestamp::fromTm(timeinfo)));
 	}
 
 	void SyncVideoAgent::setLastUpdateTimestamp(const std::string& timestamp) const
@@ -110,74 +132,116 @@ namespace desktop { namespace core { namespace agent {
 
 	void SyncVideoAgent::execute()
 	{
-		if (m_enabled && m_credentials)
+		auto settings = m_settings->get();
+		auto token = m_lifecycle.token();
+		auto credentials = std::atomic_load(&m_credentials);
+
+		if (!m_lifecycle.running() || !credentials || !settings->m_enabled)
+		{
+			m_pending.clear();
+			return;
+		}
+
+		// A run lists the clips once and then downloads one per timer tick
+		if (m_pending.empty())
 		{
 			std::map<std::string, std::string> videos;
 
 			std::string lastUpdate = getLastUpdateTimestamp();
 
 			std::stringstream ss;
-			ss << "/api/v1/accounts/" << m_credentials->m_account << "/media/changed?since=" << lastUpdate;
+			ss << "/api/v1/accounts/" << credentials->m_account << "/media/changed?since=" << lastUpdate;
+
+			getVideos(*credentials, videos, ss.str(), 1);
+
+			m_clipsLastRun.set(videos.size());
+
+			m_pending.assign(videos.begin(), videos.end());
+		}
+
+		std::map<std::string, std::string> requestHeaders;
+		requestHeaders["token_auth"] = credentials->m_token;
+
+		while (!m_pending.empty() && !token.cancelled())
+		{
+			auto video = m_pending.front();
 
-			getVideos(videos, ss.str(), 1);
+			auto folder = settings->m_output + m_timestampFolderService->get(video.first);
+			auto target = folder + formatFileName(*settings, video.first, video.second);
 
-			if (videos.size() > 0)
+			if (boost::filesystem::exists(target))
 			{
-				auto documents = m_applicationService->getMyDocuments();
-				unsigned int sleep = m_iniFileService->get<unsigned int>(documents + "Blink.ini", "SyncVideo", "Sleep", 20);
+				// Also indexes the clips synced before the index existed
+				service::MediaIndex::get().add(video.second, target);
 
-				std::map<std::string, std::string> requestHeaders;
-				requestHeaders["token_auth"] = m_credentials->m_token;
+				setLastUpdateTimestamp(video.first);
 
-				for (auto &video : videos)
-				{
-					auto folder = m_outFolder + m_timestampFolderService->get(video.first);
-					auto target = folder + formatFileName(video.first, video.second);
+				m_pending.pop_front();
+				continue;
+			}
 
-					if (!boost::filesystem::exists(target))
-					{
-						boost::filesystem::create_directories(folder);
+			boost::filesystem::create_directories(folder);
 
-						try
-						{
-							m_downloadService->download(m_credentials->m_host, video.second, requestHeaders, target);
-							setLastUpdateTimestamp(video.first);
+			try
+			{
+				auto saved = m_downloadService->download(credentials->m_host, video.second, requestHeaders, target, token);
 
-							std::this_thread::sleep_for(std::chrono::seconds{ sleep });
-						}
-						catch (...)
-						{
-							break;
-						}
-					}
-					else
+				if (saved.empty())
+				{
+					if (token.cancelled())
 					{
-						setLastUpdateTimestamp(video.first);
+						return;
 					}
 				}
+				else
+				{
+					m_clips.increment();
+
+					service::MediaIndex::get().add(video.second, saved);
+				}
+
+				setLastUpdateTimestamp(video.first);
 			}
+			catch (...)
+			{
+				m_metrics.failed();
+
+				BLING_LOG_ERROR("SyncVideoAgent", "Download of " << video.first << " failed: " << utils::logging::currentException());
+
+				// The next run starts again from the last clip saved
+				m_pending.clear();
+				return;
+			}
+
+			// The timer brings the next clip after Sleep seconds, no thread waits for it
+			m_pending.pop_front();
+			return;
 		}
 	}
 
-	void SyncVideoAgent::getVideos(std::map<std::string, std::string>& videos, const std::string& path, unsigned int page) const
+	void SyncVideoAgent::getVideos(const model::Credentials& credentials, std::map<std::string, std::string>& videos, const std::string& path, unsigned int page) const
 	{
 		std::map<std::string, std::string> requestHeaders, responseHeaders;
 		std::string content;
 		unsigned int status;
 
-		requestHeaders["token_auth"] = m_credentials->m_token;
+		requestHeaders["token_auth"] = credentials.m_token;
 
 		std::stringstream ss;
 		ss << path << "&page=" << page;
 
-		if (m_clientService->get(m_credentials->m_host, m_credentials->m_port, ss.str(), requestHeaders, responseHeaders, content, status))
+		if (m_clientService->get(credentials.m_host, credentials.m_port, ss.str(), requestHeaders, responseHeaders, content, status, m_lifecycle.token()))
 		{
 			std::stringstream contentSS(content);
 
 			try
 			{
 				boost::property_tree::ptree tree;
-				boost::property_tree::json_parser::read_json(contentSS, tree);
+
+				{
+					BLING_TRACE_SPAN("json", "parse");
+					boost::property_tree::json_parser::read_json(contentSS, tree);
+				}
 				
 				auto videosTag = tree.get_child("media");
 
@@ -191,33 +255,38 @@ namespace desktop { namespace core { namespace agent {
 						}
 					}
 
-					getVideos(videos, path, page + 1);
+					getVideos(credentials, videos, path, page + 1);
 				}
 			}
 			catch (...)
 			{
-			
+				m_metrics.failed();
+
+				BLING_LOG_ERROR("SyncVideoAgent", "Could not read page " << page << " of the media list: " << utils::logging::currentException());
 			}
 		}
 	}
 
 	void SyncVideoAgent::armTimer(unsigned int seconds)
 	{
-		if(m_enabled)
+		m_lifecycle.schedule(std::chrono::seconds(seconds), [this]()
 		{
-			m_timer->expires_from_now(boost::posix_time::seconds(seconds));
+			BLING_TRACE_SPAN("agent", "SyncVideoAgent");
 
-			m_timer->async_wait([&](const boost::system::error_code& ec)
+			m_metrics.run([this]()
 			{
 				execute();
-				armTimer(m_seconds);
 			});
-		}
+
+			auto settings = m_settings->get();
+
+			armTimer(m_pending.empty() ? settings->m_interval : settings->m_sleep);
+		});
 	}
 
-	std::string SyncVideoAgent::formatFileName(const std::string& timestamp, const std::string& fileName) const
+	std::string SyncVideoAgent::formatFileName(const model::SyncVideoSettings& settings, const std::string& timestamp, const std::string& fileName) const
 	{
-		if (m_saveLocalTime)
+		if (settings.m_useLocalTime)
 		{
 			return boost::replace_all_copy(m_timeZoneService->universalToLocal(timestamp), ":", "_") + ".mp4";
 		}
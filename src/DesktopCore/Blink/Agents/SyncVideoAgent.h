@@ -6,13 +6,17 @@
 #include "../../System/Services/IniFileService.h"
 #include "../../System/Services/TimestampFolderService.h"
 #include "../../System/Services/TimeZoneService.h"
-#include "../../Utils\Patterns\PublisherSubscriber\Subscriber.h"
+#include "../../System/Services/LiveSettingsService.h"
+#include "../Model/SyncVideoSettings.h"
+#include "../../Utils/Patterns/PublisherSubscriber/Subscriber.h"
 #include "../../Model/IAgent.h"
+#include "../../Utils/Metrics/AgentMetrics.h"
+#include "../../Utils/Runtime/Lifecycle.h"
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <map>
-#include <boost/thread.hpp>
-#include <boost/asio.hpp>
 
 namespace desktop { namespace core { 
 	
@@ -33,34 +37,40 @@ namespace desktop { namespace core {
 						std::unique_ptr<service::ApplicationDataService> applicationService = std::make_unique<service::ApplicationDataService>(),
 						std::unique_ptr<service::IniFileService> iniFileService = std::make_unique<service::IniFileService>(),
 						std::unique_ptr<service::TimestampFolderService> timestampFolderService = std::make_unique<service::TimestampFolderService>(),
-						std::unique_ptr<service::TimeZoneService> timeZoneService = std::make_unique<service::TimeZoneService>());
+						std::unique_ptr<service::TimeZoneService> timeZoneService = std::make_unique<service::TimeZoneService>(),
+						utils::runtime::Runtime& runtime = utils::runtime::Runtime::get());
 		~SyncVideoAgent();
 
-		void getVideos(std::map<std::string, std::string>& videos, const std::string& timestamp, unsigned int page) const;
+		void start() override;
+		void stop() override;
+		bool drain(std::chrono::milliseconds timeout) override;
+
+		void getVideos(const model::Credentials& credentials, std::map<std::string, std::string>& videos, const std::string& timestamp, unsigned int page) const;
 		void execute();
 	private:
 		void armTimer(unsigned int seconds = 60);
 		std::string getLastUpdateTimestamp() const;
 		void setLastUpdateTimestamp() const;
 		void setLastUpdateTimestamp(const std::string&) const;
-		std::string formatFileName(const std::string& timestamp, const std::string& fileName) const;
+		std::string formatFileName(const model::SyncVideoSettings& settings, const std::string& timestamp, const std::string& fileName) const;
 	private:
 		std::unique_ptr<service::IniFileService> m_iniFileService;
 
-		boost::asio::io_service		m_ioService;
-		std::unique_ptr<boost::asio::deadline_timer>	m_timer;
-		boost::thread				m_backgroundThread;
-		std::string					m_outFolder;
-		bool						m_enabled = false;
-		unsigned int				m_seconds;
-		bool						m_saveLocalTime;
+		utils::runtime::Lifecycle					m_lifecycle;
+		utils::metrics::AgentMetrics				m_metrics;
+		utils::metrics::Counter&					m_clips;
+		utils::metrics::Gauge&						m_clipsLastRun;
 
 		std::unique_ptr<service::IDownloadFileService> m_downloadService;
 		std::unique_ptr<service::HTTPClientService> m_clientService;
-		std::unique_ptr<model::Credentials>			m_credentials;
+		// Written by the broker and read by the timer, so only through std::atomic_load and std::atomic_exchange
+		std::shared_ptr<const model::Credentials>	m_credentials;
+		// Clips of the current run still to download, oldest first; only touched by the timer
+		std::deque<std::pair<std::string, std::string>> m_pending;
 		std::unique_ptr<service::ApplicationDataService> m_applicationService;
 		std::unique_ptr<service::TimestampFolderService> m_timestampFolderService;
 		std::unique_ptr<service::TimeZoneService>		m_timeZoneService;
+		std::unique_ptr<service::LiveSettingsService<model::SyncVideoSettings>> m_settings;
 
 		cup::Subscriber m_subscriber;
 	};
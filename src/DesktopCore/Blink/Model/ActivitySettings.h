@@ -0,0 +1,9 @@
+#pragma once
+
+namespace desktop { namespace core { namespace model { 
+	struct ActivitySettings
+	{
+		bool m_enabled;
+		unsigned int m_interval;
+	};
+}}}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+namespace desktop { namespace core { namespace model { 
+	struct LiveViewSettings
+	{
+		bool m_useLocalTime;
+		std::string m_output;
+	};
+}}}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+namespace desktop { namespace core { namespace model { 
+	struct SyncThumbnailSettings
+	{
+		bool m_enabled;
+		unsigned int m_interval;
+		unsigned int m_sleep;
+		unsigned int m_retries;
+		std::string m_output;
+	};
+}}}
\ No newline at end of file
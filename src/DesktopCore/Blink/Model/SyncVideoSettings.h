@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+namespace desktop { namespace core { namespace model { 
+	struct SyncVideoSettings
+	{
+		bool m_enabled;
+		bool m_useLocalTime;
+		unsigned int m_interval;
+		unsigned int m_sleep;
+		std::string m_output;
+	};
+}}}
\ No newline at end of file
@@ -0,0 +1,385 @@
+#include "MediaIndex.h"
+
+#include "../../Network/Services/CredentialsStore.h"
+#include "../../Network/Services/ParseURIService.h"
+#include "../../Utils/Logging/Logger.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+
+namespace desktop { namespace core { namespace service {
+
+	MediaIndex& MediaIndex::get()
+	{
+		// Leaked, the CEF IO thread can still look clips up during static destruction
+		static MediaIndex* S = new MediaIndex();
+		return *S;
+	}
+
+	MediaIndex::MediaIndex()
+	{
+
+	}
+
+	MediaIndex::~MediaIndex() = default;
+
+	bool MediaIndex::open(const std::string& path, const std::string& cacheFolder, std::uintmax_t cacheLimit)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_files.clear();
+		m_cacheFolder = cacheFolder;
+		m_cacheLimit = cacheLimit;
+		m_cached.clear();
+		m_cachedFiles.clear();
+		m_cacheSize = 0;
+		m_log.close();
+
+		std::size_t lines = 0;
+
+		{
+			std::ifstream in(path, std::ios::binary);
+			std::string line;
+
+			while (std::getline(in, line))
+			{
+				auto tab = line.find('\t');
+
+				if (tab == std::string::npos)
+				{
+					continue;
+				}
+
+				++lines;
+
+				// An empty file marks a clip that was removed
+				if (tab + 1 == line.size())
+				{
+					m_files.erase(line.substr(0, tab));
+				}
+				else
+				{
+					m_files[line.substr(0, tab)] = line.substr(tab + 1);
+				}
+			}
+		}
+
+		boost::system::error_code error;
+		boost::filesystem::create_directories(boost::filesystem::path(path).parent_path(), error);
+
+		if (lines > m_files.size())
+		{
+			auto temporary = path + ".tmp";
+
+			{
+				std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+				for (auto& file : m_files)
+				{
+					out << file.first << '\t' << file.second << '\n';
+				}
+			}
+
+			boost::filesystem::rename(temporary, path, error);
+
+			if (error)
+			{
+				BLING_LOG_WARNING("MediaIndex", "Could not rewrite " << path << ": " << error.message());
+			}
+		}
+
+		m_log.open(path, std::ios::binary | std::ios::app);
+
+		if (!m_log.is_open())
+		{
+			BLING_LOG_ERROR("MediaIndex", "Could not open " << path);
+			return false;
+		}
+
+		BLING_LOG_INFO("MediaIndex", "Loaded " << m_files.size() << " clips from " << path);
+
+		// Copies left by a crash or that could not be deleted while they played are not indexed
+		std::unordered_set<std::string> indexed;
+
+		for (auto& file : m_files)
+		{
+			if (isCached(file.second))
+			{
+				indexed.insert(file.second);
+			}
+		}
+
+		std::vector<std::pair<std::time_t, std::string>> copies;
+
+		boost::system::error_code listing;
+
+		for (boost::filesystem::directory_iterator it(m_cacheFolder, listing), end; !listing && it != end; it.increment(listing))
+		{
+			auto file = m_cacheFolder + it->path().filename().string();
+
+			if (!boost::filesystem::is_regular_file(it->status()))
+			{
+				continue;
+			}
+
+			boost::system::error_code ignored;
+
+			if (indexed.count(file))
+			{
+				copies.emplace_back(boost::filesystem::last_write_time(it->path(), ignored), file);
+			}
+			else
+			{
+				boost::filesystem::remove(it->path(), ignored);
+			}
+		}
+
+		// Modification times stand in for the last play across sessions
+		std::sort(copies.begin(), copies.end());
+
+		for (auto& copy : copies)
+		{
+			cache(copy.second);
+		}
+
+		evict();
+
+		BLING_LOG_INFO("MediaIndex", "Cache holds " << m_cached.size() << " clips, " << m_cacheSize / (1024 * 1024) << " MB");
+
+		return true;
+	}
+
+	void MediaIndex::add(const std::string& media, const std::string& file)
+	{
+		auto name = key(media);
+
+		if (name.empty() || file.empty())
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto& current = m_files[name];
+
+		if (current != file)
+		{
+			// A synced clip replaces the copy saved while the viewer played it. A copy that is
+			// still playing cannot be deleted yet; eviction or the next open does it.
+			if (!current.empty() && isCached(current))
+			{
+				uncache(current);
+			}
+
+			current = file;
+			append(name, file);
+		}
+
+		if (isCached(file))
+		{
+			cache(file);
+			evict();
+		}
+	}
+
+	std::string MediaIndex::find(const std::string& media)
+	{
+		auto name = key(media);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_files.find(name);
+
+		if (it == m_files.end())
+		{
+			return std::string();
+		}
+
+		boost::system::error_code error;
+		auto size = boost::filesystem::file_size(it->second, error);
+
+		if (error || size == 0)
+		{
+			if (isCached(it->second))
+			{
+				uncache(it->second);
+			}
+
+			m_files.erase(it);
+			append(name, std::string());
+
+			return std::string();
+		}
+
+		touch(it->second);
+
+		return it->second;
+	}
+
+	std::string MediaIndex::cachePath(const std::string& media) const
+	{
+		auto name = key(media);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (name.empty() || m_cacheFolder.empty() || m_cacheLimit == 0 || !boost::algorithm::iends_with(name, ".mp4"))
+		{
+			return std::string();
+		}
+
+		// The whole path, so clips of different accounts and cameras never share a name
+		std::string file;
+		file.reserve(name.size());
+
+		for (char c : name.substr(1))
+		{
+			file += (c == '/' || c == '\\' || c == ':') ? '_' : c;
+		}
+
+		return m_cacheFolder + file;
+	}
+
+	std::string MediaIndex::key(const std::string& media)
+	{
+		ParseURIService::Components components;
+
+		if (!ParseURIService().parse(media, components) || components.m_path.empty() || components.m_path[0] != '/')
+		{
+			return std::string();
+		}
+
+		// Absolute URLs are what pages in the browser request; only those of the Blink API host are clips.
+		// The agents pass the media field of the API, a bare path.
+		if (!components.m_scheme.empty() || !components.m_host.empty())
+		{
+			auto credentials = CredentialsStore::get().current();
+
+			if (!credentials || !boost::algorithm::iequals(components.m_scheme, "https") || !boost::algorithm::iequals(components.m_host, credentials->m_host) ||
+				components.port() != credentials->m_port)
+			{
+				return std::string();
+			}
+		}
+
+		std::string path;
+
+		// Each entry is a line of the index, and cache file names come from it
+		if (!ParseURIService::decode(components.m_path, path) || path.find_first_of("\t\n\r") != std::string::npos || path.find("..") != std::string::npos)
+		{
+			return std::string();
+		}
+
+		return path;
+	}
+
+	void MediaIndex::append(const std::string& key, const std::string& file)
+	{
+		if (m_log.is_open())
+		{
+			m_log << key << '\t' << file << '\n';
+			m_log.flush();
+		}
+	}
+
+	bool MediaIndex::isCached(const std::string& file) const
+	{
+		return !m_cacheFolder.empty() && boost::algorithm::starts_with(file, m_cacheFolder);
+	}
+
+	void MediaIndex::cache(const std::string& file)
+	{
+		boost::system::error_code error;
+		auto size = boost::filesystem::file_size(file, error);
+
+		if (error)
+		{
+			return;
+		}
+
+		auto it = m_cachedFiles.find(file);
+
+		if (it != m_cachedFiles.end())
+		{
+			m_cacheSize -= it->second->m_size;
+			m_cached.erase(it->second);
+		}
+
+		m_cached.push_back({file, size});
+		m_cachedFiles[file] = std::prev(m_cached.end());
+		m_cacheSize += size;
+	}
+
+	void MediaIndex::touch(const std::string& file)
+	{
+		auto it = m_cachedFiles.find(file);
+
+		if (it != m_cachedFiles.end())
+		{
+			m_cached.splice(m_cached.end(), m_cached, it->second);
+
+			boost::system::error_code error;
+			boost::filesystem::last_write_time(file, std::time(nullptr), error);
+		}
+	}
+
+	bool MediaIndex::uncache(const std::string& file)
+	{
+		boost::system::error_code error;
+		boost::filesystem::remove(file, error);
+
+		if (error)
+		{
+			return false;
+		}
+
+		auto it = m_cachedFiles.find(file);
+
+		if (it != m_cachedFiles.end())
+		{
+			m_cacheSize -= it->second->m_size;
+			m_cached.erase(it->second);
+			m_cachedFiles.erase(it);
+		}
+
+		return true;
+	}
+
+	void MediaIndex::evict()
+	{
+		if (m_cacheSize <= m_cacheLimit)
+		{
+			return;
+		}
+
+		std::unordered_map<std::string, std::string> keys;
+
+		for (auto& file : m_files)
+		{
+			if (isCached(file.second))
+			{
+				keys[file.second] = file.first;
+			}
+		}
+
+		for (auto it = m_cached.begin(); it != m_cached.end() && m_cacheSize > m_cacheLimit; )
+		{
+			auto file = (it++)->m_file;
+
+			if (!uncache(file))
+			{
+				continue;
+			}
+
+			auto key = keys.find(file);
+
+			if (key != keys.end())
+			{
+				m_files.erase(key->second);
+				append(key->second, std::string());
+			}
+		}
+	}
+}}}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace desktop { namespace core { namespace service {
+
+	// Process-wide map from the path of a Blink clip, as in the media field of the API or the URL
+	// the viewer plays it from, to the file it was saved to, so the viewer can play it from disk.
+	// URLs of any other host than the one of the current credentials are neither served nor cached.
+	// Kept in an append-only file, one tab separated line per change, so clips synced in earlier
+	// sessions are found too. Lookups check the file is still there and forget it otherwise.
+	// Write-through copies are kept under a size limit by deleting the least recently played.
+	class MediaIndex
+	{
+	public:
+		static MediaIndex& get();
+
+		// Loads path, rewriting it without the superseded lines, and saves write-through copies in
+		// cacheFolder. Files there that are not indexed are deleted, and so are the least recently
+		// played copies while they take more than cacheLimit bytes.
+		bool open(const std::string& path, const std::string& cacheFolder, std::uintmax_t cacheLimit);
+
+		// Replaces an earlier file of the clip, deleting it when it was only a write-through copy
+		void add(const std::string& media, const std::string& file);
+		// Empty when the clip is not on disk
+		std::string find(const std::string& media);
+
+		// Where a clip the viewer fetches from the network is saved as it plays; empty if it is not a clip
+		// or the cache limit is 0
+		std::string cachePath(const std::string& media) const;
+	private:
+		MediaIndex();
+		~MediaIndex();
+		MediaIndex(const MediaIndex&) = delete;
+		MediaIndex& operator=(const MediaIndex&) = delete;
+
+		struct Cached
+		{
+			std::string		m_file;
+			std::uintmax_t	m_size;
+		};
+
+		typedef std::list<Cached> CacheType;
+
+		static std::string key(const std::string& media);
+
+		void append(const std::string& key, const std::string& file);
+
+		bool isCached(const std::string& file) const;
+		void cache(const std::string& file);
+		void touch(const std::string& file);
+		bool uncache(const std::string& file);
+		void evict();
+	private:
+		std::unordered_map<std::string, std::string>	m_files;
+		std::string										m_cacheFolder;
+		std::ofstream									m_log;
+		mutable std::mutex								m_mutex;
+
+		// Write-through copies, least recently played first
+		CacheType										m_cached;
+		std::unordered_map<std::string, CacheType::iterator>	m_cachedFiles;
+		std::uintmax_t									m_cacheSize = 0;
+		std::uintmax_t									m_cacheLimit = 0;
+	};
+}}}
\ No newline at end of file
@@ -1,17 +1,32 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <vector>
 
 namespace desktop { namespace core {
 
+	class AgentOrchestrator;
+
 	namespace model
 	{
 		class IAgent;
 	}
 
+	namespace utils { namespace patterns {
+		class IExecutor;
+	}}
+
+	namespace utils { namespace runtime {
+		class Runtime;
+	}}
+
 	struct DesktopContext
 	{
+		utils::runtime::Runtime* m_runtime = nullptr;
+		std::shared_ptr<utils::patterns::IExecutor> m_executor;
 		std::vector<std::unique_ptr<model::IAgent>> m_agents;
+		std::shared_ptr<AgentOrchestrator> m_orchestrator;
+		std::chrono::milliseconds m_shutdownTimeout{3000};
 	};
 }}
\ No newline at end of file
@@ -1,20 +1,141 @@
 #include "DesktopCore.h"
 
 #include "DesktopContext.h"
+#include "AgentOrchestrator.h"
 
 #include "Model/IAgent.h"
+#include "Utils/Logging/Logger.h"
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Journal.h"
+#include "Utils/Runtime/Runtime.h"
+#include "Utils/Runtime/StartupTimeline.h"
+#include "Blink/Services/MediaIndex.h"
+#include "Network/JournalCodecs.h"
+#include "System/Services/ApplicationDataService.h"
+#include "System/Services/IniFileCache.h"
+#include "System/Services/IniFileService.h"
+
+#include <cstdlib>
 
 namespace desktop { namespace core {
 	DesktopCore::DesktopCore() = default;
-	DesktopCore::~DesktopCore() = default;
+
+	DesktopCore::~DesktopCore()
+	{
+		if (m_context)
+		{
+			auto deadline = std::chrono::steady_clock::now() + m_context->m_shutdownTimeout;
+
+			auto remaining = [&deadline]()
+			{
+				auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+				return left.count() > 0 ? left : std::chrono::milliseconds(0);
+			};
+
+			for (auto& agent : m_context->m_orchestrator->shutdown(remaining()))
+			{
+				m_context->m_agents.push_back(std::move(agent));
+			}
+
+			// Cancel everything first so the agents wind down in parallel
+			for (auto& agent : m_context->m_agents)
+			{
+				agent->stop();
+			}
+
+			bool stopped = true;
+
+			for (auto& agent : m_context->m_agents)
+			{
+				if (!agent->drain(remaining()))
+				{
+					BLING_LOG_WARNING("DesktopCore", "An agent did not stop within " << m_context->m_shutdownTimeout.count() << "ms");
+
+					// Its destructor would wait for the work still running; exiting matters more
+					agent.release();
+					stopped = false;
+				}
+			}
+
+			m_context->m_agents.clear();
+
+			utils::patterns::Journal::get().close();
+			utils::patterns::Broker::get().unregisterExecutor(utils::patterns::CORE_EXECUTOR);
+
+			if (!m_context->m_runtime->stop(remaining()))
+			{
+				BLING_LOG_WARNING("DesktopCore", "Runtime tasks did not finish within " << m_context->m_shutdownTimeout.count() << "ms");
+
+				stopped = false;
+			}
+
+			if (!stopped && !service::IniFileCache::get().flush())
+			{
+				BLING_LOG_ERROR("DesktopCore", "Settings could not be saved before exiting");
+			}
+
+			utils::logging::Logger::get().close();
+
+			// The work left running would use the Broker, the IniFileCache and the Journal while
+			// static destruction tears them down, so the process ends without running it
+			if (!stopped)
+			{
+				std::quick_exit(EXIT_FAILURE);
+			}
+		}
+	}
 	
 	void DesktopCore::initialize()
 	{
 		m_context = std::make_unique<DesktopContext>();
+
+		m_context->m_runtime = &utils::runtime::Runtime::get();
+		m_context->m_orchestrator = std::make_shared<AgentOrchestrator>(*m_context->m_runtime);
+
+		// Event deliveries keep their order but share the runtime threads
+		m_context->m_executor = m_context->m_runtime->serial();
+		utils::patterns::Broker::get().registerExecutor(utils::patterns::CORE_EXECUTOR, m_context->m_executor);
+
+		service::ApplicationDataService applicationService;
+		service::IniFileService iniFileService;
+
+		auto documents = applicationService.getMyDocuments();
+
+		utils::runtime::StartupTimeline::get().open(documents + "Startup.log");
+
+		auto& logger = utils::logging::Logger::get();
+
+		logger.setLevel(utils::logging::parseLevel(iniFileService.get<std::string>(documents + "Bling.ini", "Log", "Level", "info"), utils::logging::Level::INFO));
+		logger.open(documents + "Logs/Bling.log", iniFileService.get<unsigned int>(documents + "Bling.ini", "Log", "MaxSize", 5242880),
+					iniFileService.get<unsigned int>(documents + "Bling.ini", "Log", "Files", 3));
+
+		m_context->m_shutdownTimeout = std::chrono::milliseconds(iniFileService.get<unsigned int>(documents + "Bling.ini", "Shutdown", "Timeout", 3000));
+
+		if (iniFileService.get<bool>(documents + "Bling.ini", "Journal", "Enabled", true))
+		{
+			auto& journal = utils::patterns::Journal::get();
+
+			if (journal.open(documents + "Journal/events.log"))
+			{
+				// Credentials are sent with every request; only a new login is worth a record
+				journal.enable<events::CredentialsEvent>(utils::patterns::Journal::Options(true, 1));
+			}
+		}
+
+		// Lets the viewer play synced clips from disk
+		service::MediaIndex::get().open(documents + "Download/media.index", documents + "Download/Cache/",
+										iniFileService.get<std::uintmax_t>(documents + "Bling.ini", "Cache", "MaxSize", 1073741824));
 	}
 
 	void DesktopCore::addAgent(std::unique_ptr<model::IAgent> agent)
 	{
+		agent->start();
+
 		m_context->m_agents.push_back(std::move(agent));
 	}
+
+	void DesktopCore::addAgents(std::vector<model::AgentDescriptor> agents)
+	{
+		m_context->m_orchestrator->add(std::move(agents));
+	}
 }}
\ No newline at end of file
@@ -1,14 +1,12 @@
 #pragma once
 
+#include "Model/AgentDescriptor.h"
+
 #include <memory>
+#include <vector>
 
 namespace desktop { namespace core {
 	
-	namespace model
-	{
-		class IAgent;
-	}
-
 	class DesktopContext;
 	
 	class DesktopCore
@@ -18,6 +16,9 @@ namespace desktop { namespace core {
 		~DesktopCore();
 		void initialize();
 		void addAgent(std::unique_ptr<model::IAgent> agent);
+
+		// Built in the background, see AgentOrchestrator
+		void addAgents(std::vector<model::AgentDescriptor> agents);
 	private:
 		std::unique_ptr<DesktopContext> m_context;
 	};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "IAgent.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace desktop { namespace core { namespace model {
+
+	// How to build an agent at startup: once the agents it depends on are running and, for
+	// work that can wait, not before delay
+	struct AgentDescriptor
+	{
+		typedef std::function<std::unique_ptr<IAgent>()> FactoryType;
+
+		AgentDescriptor(std::string name, FactoryType factory, std::vector<std::string> dependencies = {},
+						std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+		: m_name(std::move(name))
+		, m_factory(std::move(factory))
+		, m_dependencies(std::move(dependencies))
+		, m_delay(delay)
+		{
+
+		}
+
+		std::string					m_name;
+		FactoryType					m_factory;
+		std::vector<std::string>	m_dependencies;
+		std::chrono::milliseconds	m_delay;
+	};
+}}}
\ No newline at end of file
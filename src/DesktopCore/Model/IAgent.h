@@ -1,9 +1,20 @@
 #pragma once
 
+#include <chrono>
+
 namespace desktop { namespace core { namespace model { 
 	class IAgent
 	{
 	public:
 		virtual ~IAgent() = default;
+
+		// Agents do no work before start; the constructor only wires services and subscriptions
+		virtual void start() {}
+
+		// Cancels pending and running work without waiting for it
+		virtual void stop() {}
+
+		// Waits for work cancelled by stop, false if it is still running after the timeout
+		virtual bool drain(std::chrono::milliseconds /*timeout*/) { return true; }
 	};
 }}}
\ No newline at end of file
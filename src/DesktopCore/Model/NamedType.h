@@ -1,5 +1,7 @@
 #pragma once
 
+#include <utility>
+
 namespace desktop { namespace core { namespace model {
 
 	template <typename T, typename Parameter>
@@ -0,0 +1,90 @@
+#include "CredentialsAgent.h"
+
+#include "../../Utils/Logging/Logger.h"
+#include "../../Utils/Tracing/Tracer.h"
+#include "../Services/CredentialsStore.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace desktop { namespace core { namespace agent {
+
+	CredentialsAgent::CredentialsAgent(std::unique_ptr<service::ApplicationDataService> applicationService,
+										std::unique_ptr<service::IniFileService> iniFileService,
+										utils::runtime::Runtime& runtime)
+	: m_applicationService(std::move(applicationService))
+	, m_iniFileService(std::move(iniFileService))
+	, m_lifecycle(runtime)
+	, m_metrics("CredentialsAgent")
+	{
+		auto documents = m_applicationService->getMyDocuments();
+
+		m_path = m_iniFileService->get<std::string>(documents + "Bling.ini", "Credentials", "File", documents + "credentials.json");
+	}
+
+	CredentialsAgent::~CredentialsAgent()
+	{
+		m_lifecycle.stop();
+		m_lifecycle.wait();
+	}
+
+	void CredentialsAgent::start()
+	{
+		m_lifecycle.start();
+
+		armTimer(0);
+	}
+
+	void CredentialsAgent::stop()
+	{
+		m_lifecycle.stop();
+	}
+
+	bool CredentialsAgent::drain(std::chrono::milliseconds timeout)
+	{
+		return m_lifecycle.drain(timeout);
+	}
+
+	void CredentialsAgent::execute()
+	{
+		boost::system::error_code error;
+		auto lastWrite = boost::filesystem::last_write_time(m_path, error);
+
+		if (error || lastWrite == m_lastWrite)
+		{
+			return;
+		}
+
+		m_lastWrite = lastWrite;
+
+		try
+		{
+			boost::property_tree::ptree tree;
+			boost::property_tree::json_parser::read_json(m_path, tree);
+
+			service::CredentialsStore::get().update(tree.get<std::string>("host"), tree.get<std::string>("port"),
+													tree.get<std::string>("token"), tree.get<std::string>("account"));
+		}
+		catch (...)
+		{
+			m_metrics.failed();
+
+			BLING_LOG_ERROR("CredentialsAgent", "Could not read " << m_path << ": " << utils::logging::currentException());
+		}
+	}
+
+	void CredentialsAgent::armTimer(unsigned int seconds)
+	{
+		m_lifecycle.schedule(std::chrono::seconds(seconds), [this]()
+		{
+			BLING_TRACE_SPAN("agent", "CredentialsAgent");
+
+			m_metrics.run([this]()
+			{
+				execute();
+			});
+			armTimer();
+		});
+	}
+}}}
\ No newline at end of file
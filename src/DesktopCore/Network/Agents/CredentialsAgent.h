@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../../System/Services/ApplicationDataService.h"
+#include "../../System/Services/IniFileService.h"
+#include "../../Model/IAgent.h"
+#include "../../Utils/Metrics/AgentMetrics.h"
+#include "../../Utils/Runtime/Lifecycle.h"
+
+#include <ctime>
+#include <string>
+
+namespace desktop { namespace core { namespace agent {
+
+	// Publishes the credentials stored in a JSON file, {"host", "port", "token", "account"},
+	// and again each time the file changes. Used where no viewer is there to log in.
+	class CredentialsAgent : public model::IAgent
+	{
+	public:
+		CredentialsAgent(std::unique_ptr<service::ApplicationDataService> applicationService = std::make_unique<service::ApplicationDataService>(),
+						std::unique_ptr<service::IniFileService> iniFileService = std::make_unique<service::IniFileService>(),
+						utils::runtime::Runtime& runtime = utils::runtime::Runtime::get());
+		~CredentialsAgent();
+
+		void start() override;
+		void stop() override;
+		bool drain(std::chrono::milliseconds timeout) override;
+
+		void execute();
+	private:
+		void armTimer(unsigned int seconds = 5);
+	private:
+		std::unique_ptr<service::ApplicationDataService>	m_applicationService;
+		std::unique_ptr<service::IniFileService>			m_iniFileService;
+		std::string											m_path;
+		std::time_t											m_lastWrite = 0;
+
+		utils::runtime::Lifecycle							m_lifecycle;
+		utils::metrics::AgentMetrics						m_metrics;
+	};
+}}}
\ No newline at end of file
@@ -1,35 +1,40 @@
 #include "FileServerAgent.h"
 
-#include <locale>
-#include <codecvt>
+#include "../../System/Services/AssetCache.h"
+#include "../../Utils/Logging/Logger.h"
+#include "../../Utils/Patterns/PublisherSubscriber/Instrumentation.h"
+#include "../../Utils/Tracing/Tracer.h"
+#include "../Services/CredentialsStore.h"
+
 #include <string>
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/replace.hpp>
-#include <cpprestsdk/cpprest/http_listener.h>
-#include <cpprest\filestream.h>
+#include <cpprest/http_listener.h>
+#include <cpprest/json.h>
+#include <cpprest/filestream.h>
 
 namespace desktop { namespace core { namespace agent {
 
-	static const std::map<std::wstring, std::wstring> g_mimeTypes = { 
-																	{L".html", L"text/html" },
-																	{L".htm", L"text/html" },
-																	{L".js", L"application/javascript" },
-																	{L".css", L"text/css" },
-																	{L".gif", L"image/gif" },
-																	{L".jpg", L"image/jpeg" },
-																	{L".png", L"image/png" },
-																	{L".svg", L"image/svg+xml" },
-																	{L".pdf", L"application/pdf" },
-																	{L".eot", L"application/vnd.ms-fontobject" },
-																	{L".ttf", L"application/x-font-ttf" },
-																	{L".woff", L"application/font-woff" },
-																	{L".woff2", L"application/font-woff2" }
+	static const std::map<utility::string_t, utility::string_t> g_mimeTypes = { 
+																	{U(".html"), U("text/html") },
+																	{U(".htm"), U("text/html") },
+																	{U(".js"), U("application/javascript") },
+																	{U(".css"), U("text/css") },
+																	{U(".gif"), U("image/gif") },
+																	{U(".jpg"), U("image/jpeg") },
+																	{U(".png"), U("image/png") },
+																	{U(".svg"), U("image/svg+xml") },
+																	{U(".pdf"), U("application/pdf") },
+																	{U(".eot"), U("application/vnd.ms-fontobject") },
+																	{U(".ttf"), U("application/x-font-ttf") },
+																	{U(".woff"), U("application/font-woff") },
+																	{U(".woff2"), U("application/font-woff2") }
 																};
 
 	namespace 
 	{
-		std::wstring getContentType(const std::wstring& extension)
+		utility::string_t getContentType(const utility::string_t& extension)
 		{
 			auto value = g_mimeTypes.find(extension);
 
@@ -39,8 +44,67 @@ namespace desktop { namespace core { namespace agent {
 			}
 			else
 			{
-				return L"text/html";
+				return U("text/html");
+			}
+		}
+
+		web::json::value toJson(const utils::patterns::Instrumentation::Snapshot& snapshot)
+		{
+			using utility::conversions::to_string_t;
+
+			web::json::value result;
+			result[U("enabled")] = web::json::value::boolean(snapshot.m_enabled);
+			result[U("sampleRate")] = web::json::value::number(snapshot.m_sampleRate);
+			result[U("slowThresholdMicroseconds")] = web::json::value::number(static_cast<uint64_t>(snapshot.m_slowThresholdMicroseconds));
+
+			result[U("events")] = web::json::value::array();
+
+			for (std::size_t i = 0; i < snapshot.m_events.size(); ++i)
+			{
+				web::json::value event;
+				event[U("event")] = web::json::value::string(to_string_t(snapshot.m_events[i].m_event));
+				event[U("published")] = web::json::value::number(static_cast<uint64_t>(snapshot.m_events[i].m_published));
+
+				result[U("events")][i] = event;
+			}
+
+			result[U("handlers")] = web::json::value::array();
+
+			for (std::size_t i = 0; i < snapshot.m_handlers.size(); ++i)
+			{
+				const auto& stats = snapshot.m_handlers[i];
+
+				web::json::value handler;
+				handler[U("event")] = web::json::value::string(to_string_t(stats.m_event));
+				handler[U("handler")] = web::json::value::string(to_string_t(stats.m_handler));
+				handler[U("calls")] = web::json::value::number(static_cast<uint64_t>(stats.m_calls));
+				handler[U("sampled")] = web::json::value::number(static_cast<uint64_t>(stats.m_sampled));
+				handler[U("meanMicroseconds")] = web::json::value::number(static_cast<uint64_t>(stats.m_meanMicroseconds));
+				handler[U("maxMicroseconds")] = web::json::value::number(static_cast<uint64_t>(stats.m_maxMicroseconds));
+				handler[U("slow")] = web::json::value::number(static_cast<uint64_t>(stats.m_slow));
+				handler[U("histogram")] = web::json::value::array();
+
+				for (std::size_t j = 0; j < stats.m_histogram.size(); ++j)
+				{
+					handler[U("histogram")][j] = web::json::value::number(static_cast<uint64_t>(stats.m_histogram[j]));
+				}
+
+				result[U("handlers")][i] = handler;
 			}
+
+			result[U("recentSlow")] = web::json::value::array();
+
+			for (std::size_t i = 0; i < snapshot.m_recentSlow.size(); ++i)
+			{
+				web::json::value slow;
+				slow[U("event")] = web::json::value::string(to_string_t(snapshot.m_recentSlow[i].m_event));
+				slow[U("handler")] = web::json::value::string(to_string_t(snapshot.m_recentSlow[i].m_handler));
+				slow[U("microseconds")] = web::json::value::number(static_cast<uint64_t>(snapshot.m_recentSlow[i].m_microseconds));
+
+				result[U("recentSlow")][i] = slow;
+			}
+
+			return result;
 		}
 	}
 
@@ -48,6 +112,9 @@ namespace desktop { namespace core { namespace agent {
 									std::unique_ptr<service::IniFileService> iniFileService)
 	: m_iniFileService(std::move(iniFileService))
 	, m_applicationService(std::move(applicationService))
+	, m_gets(utils::metrics::Registry::get().counter("bling_file_server_requests_total", "Requests to the local server", {{"method", "GET"}}))
+	, m_posts(utils::metrics::Registry::get().counter("bling_file_server_requests_total", "Requests to the local server", {{"method", "POST"}}))
+	, m_notFound(utils::metrics::Registry::get().counter("bling_file_server_not_found_total", "Requests to the local server answered with 404"))
 	{
 		auto documents = m_applicationService->getMyDocuments();
 		
@@ -55,8 +122,7 @@ namespace desktop { namespace core { namespace agent {
 
 		m_endpoint = m_iniFileService->get<std::string>(documents + "Bling.ini", "FileServer", "Endpoint", "http://127.0.0.1:9191/");
 
-		std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-		std::wstring endpoint = converter.from_bytes(m_endpoint);
+		utility::string_t endpoint = utility::conversions::to_string_t(m_endpoint);
 
 		auto uri = web::uri_builder(endpoint).to_uri();
 
@@ -64,13 +130,28 @@ namespace desktop { namespace core { namespace agent {
 
 		m_listener->support(web::http::methods::GET, std::bind(&FileServerAgent::handleGET, this, std::placeholders::_1));
 		m_listener->support(web::http::methods::POST, std::bind(&FileServerAgent::handlePOST, this, std::placeholders::_1));
+	}
 
+	FileServerAgent::~FileServerAgent()
+	{
+		stop();
+	}
+
+	void FileServerAgent::start()
+	{
 		m_listener->open();
 	}
 
-	FileServerAgent::~FileServerAgent()
+	void FileServerAgent::stop()
 	{
-		
+		try
+		{
+			m_listener->close().wait();
+		}
+		catch (...)
+		{
+			BLING_LOG_WARNING("FileServerAgent", "Could not close the listener: " << utils::logging::currentException());
+		}
 	}
 
 	void FileServerAgent::handleGET(web::http::http_request request) const
@@ -79,29 +160,72 @@ namespace desktop { namespace core { namespace agent {
 
 		auto bodyws = request.request_uri().path();
 
-		std::string body(bodyws.begin(), bodyws.end());
+		std::string body = utility::conversions::to_utf8string(bodyws);
+
+		m_gets.increment();
+
+		if (body == "/_broker")
+		{
+			request.reply(status_codes::OK, toJson(utils::patterns::Instrumentation::get().snapshot()));
+			return;
+		}
+
+		if (body == "/metrics")
+		{
+			request.reply(status_codes::OK, utils::metrics::Registry::get().render(), "text/plain; version=0.0.4; charset=utf-8");
+			return;
+		}
+
+		if (body == "/_trace")
+		{
+			request.reply(status_codes::OK, utils::tracing::Tracer::get().dump(), "application/json");
+			return;
+		}
 
 		if (body == "" || *body.rbegin() == '/')
 		{
 			body = "/index.html";
 		}
 
-		body = boost::replace_all_copy(body, "/", "\\");
-
 		boost::filesystem::path path(m_folder + body);
 
-		if (boost::filesystem::exists(path))
+		auto asset = service::AssetCache::get().find(path.string());
+
+		if (asset)
+		{
+			auto etag = utility::conversions::to_string_t(asset->m_etag);
+
+			auto match = request.headers().find(header_names::if_none_match);
+
+			if (match != request.headers().end() && match->second == etag)
+			{
+				http_response response(status_codes::NotModified);
+				response.headers().add(header_names::etag, etag);
+
+				request.reply(response).then([](pplx::task<void> t) {});
+				return;
+			}
+
+			http_response response(status_codes::OK);
+
+			utility::string_t extension = utility::conversions::to_string_t(path.extension().string());
+
+			response.set_body(asset->m_body);
+			response.headers().set_content_type(getContentType(extension));
+			response.headers().add(header_names::etag, etag);
+
+			request.reply(response).then([](pplx::task<void> t) {});
+		}
+		else if (boost::filesystem::exists(path))
 		{
-			std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-			std::wstring pathws = converter.from_bytes(path.string());
+			utility::string_t pathws = utility::conversions::to_string_t(path.string());
 
 			concurrency::streams::fstream::open_istream(pathws, std::ios::in)
 				.then([=](concurrency::streams::istream is)
 			{
 				web::http::http_response response(web::http::status_codes::OK);
 
-				std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-				std::wstring extension = converter.from_bytes(path.extension().string());
+				utility::string_t extension = utility::conversions::to_string_t(path.extension().string());
 
 				response.set_body(std::move(is), getContentType(extension));
 
@@ -110,6 +234,8 @@ namespace desktop { namespace core { namespace agent {
 		}
 		else
 		{
+			m_notFound.increment();
+
 			request.reply(status_codes::NotFound);
 		}
 	}
@@ -120,32 +246,90 @@ namespace desktop { namespace core { namespace agent {
 
 		auto bodyws = request.request_uri().path();
 
-		std::string body(bodyws.begin(), bodyws.end());
+		std::string body = utility::conversions::to_utf8string(bodyws);
 
-		body = boost::replace_all_copy(body, "/", "\\");
+		m_posts.increment();
+
+		if (body == "/_credentials" && !m_secret.empty())
+		{
+			handleCredentials(request);
+			return;
+		}
 
 		boost::filesystem::path path(m_folder + body);
 
 		if (path.extension() == ".json")
 		{
-			std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-			std::wstring pathws = converter.from_bytes(path.string());
+			utility::string_t pathws = utility::conversions::to_string_t(path.string());
 
-			std::wstring payload = request.extract_string().get();
+			utility::string_t payload = request.extract_string().get();
 
 			std::unique_lock<std::mutex> lock(m_mutex);
 
-			std::string out(payload.begin(), payload.end());
+			std::string out = utility::conversions::to_utf8string(payload);
 
 			std::ofstream f(path.string());
 			f << out;
 			f.close();
 
-			request.reply(status_codes::OK, L"{}");
+			request.reply(status_codes::OK, U("{}"));
 		}
 		else
 		{
+			m_notFound.increment();
+
 			request.reply(status_codes::NotFound);
 		}
 	}
+
+	void FileServerAgent::acceptCredentials(const std::string& secret)
+	{
+		m_secret = secret;
+	}
+
+	// Lets a headless install log in without the viewer: {"host", "port", "token", "account"}
+	void FileServerAgent::handleCredentials(web::http::http_request request) const
+	{
+		using namespace web::http;
+
+		auto headers = request.headers();
+		auto authorization = headers.find(header_names::authorization);
+
+		std::string presented = authorization != headers.end() ? utility::conversions::to_utf8string(authorization->second) : std::string();
+		std::string expected = "Bearer " + m_secret;
+
+		// Compares every byte so the time taken does not tell how much of the secret matched
+		unsigned char difference = presented.size() == expected.size() ? 0 : 1;
+
+		for (std::size_t i = 0; i < presented.size() && i < expected.size(); ++i)
+		{
+			difference |= static_cast<unsigned char>(presented[i] ^ expected[i]);
+		}
+
+		if (difference != 0)
+		{
+			BLING_LOG_WARNING("FileServerAgent", "Rejected credentials without the secret");
+
+			request.reply(status_codes::Unauthorized);
+			return;
+		}
+
+		try
+		{
+			auto payload = request.extract_json().get();
+
+			service::CredentialsStore::get().update(utility::conversions::to_utf8string(payload.at(U("host")).as_string()),
+													utility::conversions::to_utf8string(payload.at(U("port")).as_string()),
+													utility::conversions::to_utf8string(payload.at(U("token")).as_string()),
+													utility::conversions::to_utf8string(payload.at(U("account")).as_string()));
+
+			request.reply(status_codes::OK, U("{}"));
+		}
+		catch (...)
+		{
+			BLING_LOG_WARNING("FileServerAgent", "Rejected credentials: " << utils::logging::currentException());
+
+			request.reply(status_codes::BadRequest);
+		}
+	}
 }}}
\ No newline at end of file
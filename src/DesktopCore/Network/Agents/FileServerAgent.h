@@ -3,10 +3,11 @@
 #include "../../System/Services/ApplicationDataService.h"
 #include "../../System/Services/IniFileService.h"
 #include "../../Model/IAgent.h"
+#include "../../Utils/Metrics/Metrics.h"
 
 #include <string>
 #include <map>
-#include <cpprestsdk/cpprest/http_msg.h>
+#include <cpprest/http_msg.h>
 
 namespace web { namespace http { namespace experimental { namespace listener { class http_listener; } } } }
 
@@ -21,16 +22,29 @@ namespace desktop { namespace core {
 						std::unique_ptr<service::IniFileService> iniFileService = std::make_unique<service::IniFileService>());
 		~FileServerAgent();
 
+		void start() override;
+		void stop() override;
+
+		// Enables POST /_credentials for requests carrying "Authorization: Bearer <secret>".
+		// Only the daemon calls this; without it the endpoint does not exist.
+		void acceptCredentials(const std::string& secret);
+
 		void handlePOST(web::http::http_request);
 		void handleGET(web::http::http_request) const;
-
+	private:
+		void handleCredentials(web::http::http_request) const;
 	private:
 		std::unique_ptr<service::ApplicationDataService>					m_applicationService;
 		std::unique_ptr<service::IniFileService>							m_iniFileService;
 		std::string															m_endpoint;
 		std::unique_ptr<web::http::experimental::listener::http_listener>	m_listener;
 		std::string															m_folder;
+		std::string															m_secret;
 
 		std::mutex															m_mutex;
+
+		utils::metrics::Counter&											m_gets;
+		utils::metrics::Counter&											m_posts;
+		utils::metrics::Counter&											m_notFound;
 	};
 }}}
\ No newline at end of file
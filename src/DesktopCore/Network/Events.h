@@ -1,23 +1,26 @@
 #pragma once
 
-#include "..\Utils\Patterns\PublisherSubscriber\Event.h"
+#include "../Utils/Patterns/PublisherSubscriber/Event.h"
 
-#include "..\Network\Model\Credentials.h"
-#include "..\Network\Model\RTP.h"
+#include "../Network/Model/Credentials.h"
+#include "../Network/Model/RTP.h"
+
+#include <memory>
 
 namespace desktop { namespace core { namespace events {
 	
 	namespace sup = utils::patterns;
 	
-	const sup::EventType CREDENTIALS_EVENT = "CREDENTIALS_EVENT";
+	constexpr sup::EventType CREDENTIALS_EVENT = sup::makeEventType("CREDENTIALS_EVENT");
 	struct CredentialsEvent : public sup::Event
 	{
-		CredentialsEvent(const model::Credentials& credentials)
+		// Shared with every subscriber, never changed once published
+		CredentialsEvent(const std::shared_ptr<const model::Credentials>& credentials)
 		: m_credentials(credentials)
 		{
 			m_name = CREDENTIALS_EVENT;
 		}
 
-		model::Credentials m_credentials;
+		std::shared_ptr<const model::Credentials> m_credentials;
 	};
 }}}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Events.h"
+
+#include "../Utils/Patterns/PublisherSubscriber/Journal.h"
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	template<>
+	struct JournalCodec<events::CredentialsEvent>
+	{
+		static EventType id()
+		{
+			return events::CREDENTIALS_EVENT;
+		}
+
+		static void encode(const events::CredentialsEvent& evt, boost::property_tree::ptree& pt)
+		{
+			pt.put("host", evt.m_credentials->m_host);
+			pt.put("port", evt.m_credentials->m_port);
+			pt.put("token", evt.m_credentials->m_token);
+			pt.put("account", evt.m_credentials->m_account);
+		}
+
+		static events::CredentialsEvent decode(const boost::property_tree::ptree& pt)
+		{
+			return events::CredentialsEvent(std::make_shared<const model::Credentials>(pt.get<std::string>("host"), pt.get<std::string>("port"),
+																pt.get<std::string>("token"), pt.get<std::string>("account")));
+		}
+	};
+}}}}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "CredentialsStore.h"
+
+#include "../../Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "../Events.h"
+
+#include <initializer_list>
+
+namespace desktop { namespace core { namespace service {
+
+	namespace
+	{
+		// FNV-1a of the fields, each followed by a NUL so they can not run into each other
+		std::uint64_t hash(std::initializer_list<boost::string_view> fields)
+		{
+			std::uint64_t value = 14695981039346656037ULL;
+
+			for (auto& field : fields)
+			{
+				for (char c : field)
+				{
+					value = (value ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+				}
+
+				value *= 1099511628211ULL;
+			}
+
+			return value | 1;
+		}
+	}
+
+	CredentialsStore& CredentialsStore::get()
+	{
+		static CredentialsStore S;
+		return S;
+	}
+
+	CredentialsStore::CredentialsStore()
+	: m_hash(0)
+	{
+
+	}
+
+	CredentialsStore::~CredentialsStore() = default;
+
+	bool CredentialsStore::update(boost::string_view host, boost::string_view port, boost::string_view token, boost::string_view account)
+	{
+		auto value = hash({ host, port, token, account });
+
+		if (m_hash.load(std::memory_order_acquire) == value)
+		{
+			return false;
+		}
+
+		// Publishing under the lock keeps the events in the order of the snapshots
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_hash.load(std::memory_order_relaxed) == value)
+		{
+			return false;
+		}
+
+		SnapshotType snapshot = std::make_shared<const model::Credentials>(host.to_string(), port.to_string(), token.to_string(), account.to_string());
+
+		std::atomic_store(&m_current, snapshot);
+		m_hash.store(value, std::memory_order_release);
+
+		events::CredentialsEvent evt(snapshot);
+		utils::patterns::Broker::get().publish(evt);
+
+		return true;
+	}
+
+	CredentialsStore::SnapshotType CredentialsStore::current() const
+	{
+		return std::atomic_load(&m_current);
+	}
+}}}
\ No newline at end of file
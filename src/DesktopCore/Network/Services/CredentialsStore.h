@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../Model/Credentials.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <boost/utility/string_view.hpp>
+
+namespace desktop { namespace core { namespace service {
+
+	// Process-wide credentials of the account that is logged in. The viewer reports them with
+	// every API request, so update() only compares a hash of the fields against the current one
+	// and builds a snapshot, and publishes CredentialsEvent, when they really changed. Snapshots
+	// are immutable and swapped atomically, so holders share them instead of copying.
+	class CredentialsStore
+	{
+	public:
+		typedef std::shared_ptr<const model::Credentials> SnapshotType;
+
+		static CredentialsStore& get();
+
+		// True when the credentials differ from the current ones and were published
+		bool update(boost::string_view host, boost::string_view port, boost::string_view token, boost::string_view account);
+
+		// Null until the first update
+		SnapshotType current() const;
+	private:
+		CredentialsStore();
+		~CredentialsStore();
+		CredentialsStore(const CredentialsStore&) = delete;
+		CredentialsStore& operator=(const CredentialsStore&) = delete;
+	private:
+		// Never 0, which stands for no credentials
+		std::atomic<std::uint64_t>	m_hash;
+		SnapshotType				m_current;
+		std::mutex					m_mutex;
+	};
+}}}
\ No newline at end of file
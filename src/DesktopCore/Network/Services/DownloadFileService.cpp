@@ -1,5 +1,7 @@
 #include "DownloadFileService.h"
 
+#include "Utils/Tracing/Tracer.h"
+
 namespace desktop { namespace core { namespace service {
 
 	DownloadFileService::DownloadFileService(std::unique_ptr<service::HTTPClientService> clientService, 
@@ -8,20 +10,117 @@ namespace desktop { namespace core { namespace service {
 	: m_clientService(std::move(clientService))
 	, m_uriService(std::move(uriService))
 	, m_fileIOService(std::move(fileIOService))
+	, m_downloads(utils::metrics::Registry::get().counter("bling_downloads_total", "Files downloaded or attempted"))
+	, m_failures(utils::metrics::Registry::get().counter("bling_download_failures_total", "Downloads that saved nothing"))
+	, m_bytes(utils::metrics::Registry::get().counter("bling_downloaded_bytes_total", "Bytes saved by downloads"))
+	, m_size(utils::metrics::Registry::get().histogram("bling_download_size_bytes", "Size of each saved download", utils::metrics::Histogram::Unit::BYTES))
+	, m_duration(utils::metrics::Registry::get().histogram("bling_download_duration_seconds", "Time taken by each download, redirects included", utils::metrics::Histogram::Unit::MICROSECONDS))
 	{
 	
 	}
 
 	DownloadFileService::~DownloadFileService() = default;
 
-	std::string DownloadFileService::download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder) const
+	std::string DownloadFileService::download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder,
+											 const utils::runtime::CancellationToken& token) const
+	{
+		BLING_TRACE_SPAN("download", "download");
+
+		auto start = std::chrono::steady_clock::now();
+		std::size_t bytes = 0;
+
+		auto saved = fetch(host, url, requestHeaders, folder, token, bytes);
+
+		m_duration.observe(std::chrono::steady_clock::now() - start);
+		m_downloads.increment();
+
+		if (saved.empty())
+		{
+			m_failures.increment();
+		}
+		else
+		{
+			m_bytes.increment(bytes);
+			m_size.observe(static_cast<unsigned long long>(bytes));
+		}
+
+		return saved;
+	}
+
+	bool DownloadFileService::canStream() const
+	{
+		return true;
+	}
+
+	bool DownloadFileService::stream(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, SinkType sink,
+									const utils::runtime::CancellationToken& token) const
+	{
+		BLING_TRACE_SPAN("download", "stream");
+
+		auto start = std::chrono::steady_clock::now();
+		std::size_t bytes = 0;
+
+		std::map<std::string, std::string> responseHeaders;
+		unsigned int status = 0;
+
+		// The body of a redirect is not the file
+		auto body = [&sink, &status, &bytes](const char* data, std::size_t size)
+		{
+			if (status != 200)
+			{
+				return true;
+			}
+
+			bytes += size;
+
+			return sink(data, size);
+		};
+
+		bool result = m_clientService->stream(host, "443", url, requestHeaders, responseHeaders, body, status, token);
+
+		if (result && status == 302)
+		{
+			auto location = responseHeaders.find("Location");
+			std::string protocol, domain, port, path, query, fragment;
+
+			result = location != responseHeaders.end() && m_uriService->parse(location->second, protocol, domain, port, path, query, fragment);
+
+			if (result)
+			{
+				std::map<std::string, std::string> requestHeaders, responseHeaders;
+
+				// Release assets redirect to signed storage URLs
+				result = m_clientService->stream(domain, "443", query.empty() ? path : path + "?" + query, requestHeaders, responseHeaders, body, status, token);
+			}
+		}
+
+		result = result && status == 200;
+
+		m_duration.observe(std::chrono::steady_clock::now() - start);
+		m_downloads.increment();
+
+		if (result)
+		{
+			m_bytes.increment(bytes);
+			m_size.observe(static_cast<unsigned long long>(bytes));
+		}
+		else
+		{
+			m_failures.increment();
+		}
+
+		return result;
+	}
+
+	std::string DownloadFileService::fetch(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder,
+											const utils::runtime::CancellationToken& token, std::size_t& bytes) const
 	{
 		std::map<std::string, std::string> responseHeaders;
 		unsigned int status;
 
 		std::string file;
 
-		if (m_clientService->get(host, "443", url, requestHeaders, responseHeaders, file, status))
+		if (m_clientService->get(host, "443", url, requestHeaders, responseHeaders, file, status, token))
 		{
 			if (status == 302)
 			{
@@ -34,8 +133,13 @@ namespace desktop { namespace core { namespace service {
 					{
 						std::map<std::string, std::string> requestHeaders, responseHeaders;
 
-						if (m_clientService->get(domain, "443", path, requestHeaders, responseHeaders, file, status) && status == 200)
+						// Release assets redirect to signed storage URLs
+						if (m_clientService->get(domain, "443", query.empty() ? path : path + "?" + query, requestHeaders, responseHeaders, file, status, token) && status == 200)
 						{
+							bytes = file.size();
+
+							BLING_TRACE_SPAN("download", "save");
+
 							if (m_fileIOService->save(folder, file))
 							{
 								return folder;
@@ -46,6 +150,10 @@ namespace desktop { namespace core { namespace service {
 			}
 			else if (status == 200)
 			{
+				bytes = file.size();
+
+				BLING_TRACE_SPAN("download", "save");
+
 				if (m_fileIOService->save(folder, file))
 				{
 					return folder;
@@ -15,10 +15,24 @@ namespace desktop { namespace core { namespace service {
 							std::unique_ptr<service::ParseURIService> uriService = std::make_unique<service::ParseURIService>(),
 							std::unique_ptr<service::FileIOService> fileIOService = std::make_unique<service::FileIOService>());
 		~DownloadFileService();
-		std::string download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder) const override;
+		std::string download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder,
+							const utils::runtime::CancellationToken& token = utils::runtime::CancellationToken()) const override;
+
+		bool canStream() const override;
+		bool stream(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, SinkType sink,
+					const utils::runtime::CancellationToken& token = utils::runtime::CancellationToken()) const override;
+	private:
+		std::string fetch(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder,
+							const utils::runtime::CancellationToken& token, std::size_t& bytes) const;
 	private:
 		std::unique_ptr<service::HTTPClientService> m_clientService;
 		std::unique_ptr<service::ParseURIService> m_uriService;
 		std::unique_ptr<service::FileIOService> m_fileIOService;
+
+		utils::metrics::Counter& m_downloads;
+		utils::metrics::Counter& m_failures;
+		utils::metrics::Counter& m_bytes;
+		utils::metrics::Histogram& m_size;
+		utils::metrics::Histogram& m_duration;
 	};
 }}}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "HTTPClientService.h"
 
+#include "Utils/Tracing/Tracer.h"
+
 #include <iostream>
 #include <istream>
 #include <ostream>
@@ -13,17 +15,24 @@ namespace desktop { namespace core { namespace service {
 
 	using boost::asio::ip::tcp;
 
+	const std::chrono::seconds HTTPClientService::TIMEOUT{ 60 };
+
 	HTTPClientService::HTTPClientService()
 	: m_io_service()
+	, m_resolver(m_io_service)
+	, m_deadline(m_io_service)
+	, m_generation(0)
 	, context_(boost::asio::ssl::context::sslv23)
+	, m_requests(utils::metrics::Registry::get().counter("bling_http_requests_total", "Requests sent to Blink and GitHub servers"))
+	, m_failures(utils::metrics::Registry::get().counter("bling_http_request_failures_total", "Requests without a complete response, cancelled ones included"))
+	, m_received(utils::metrics::Registry::get().counter("bling_http_received_bytes_total", "Response body bytes received"))
+	, m_duration(utils::metrics::Registry::get().histogram("bling_http_request_duration_seconds", "Time from connect to the end of the response", utils::metrics::Histogram::Unit::MICROSECONDS))
 	{
 		context_.set_options(
 			boost::asio::ssl::context::default_workarounds
 			| boost::asio::ssl::context::no_sslv2
 			| boost::asio::ssl::context::no_sslv3
 			| boost::asio::ssl::context::no_tlsv1);
-
-		m_socket.reset(new boost::asio::ssl::stream<boost::asio::ip::tcp::socket>(m_io_service, context_));
 	}
 
 	HTTPClientService::~HTTPClientService() = default;
@@ -31,34 +40,139 @@ namespace desktop { namespace core { namespace service {
 	bool HTTPClientService::get(const std::string& server, const std::string& port, const std::string& path,
 		const std::map<std::string, std::string>& requestHeaders,
 		std::map<std::string, std::string>& responseHeaders,
-		std::string& content, unsigned int& status_code)
+		std::string& content, unsigned int& status_code,
+		const utils::runtime::CancellationToken& token)
 	{
-		return send(server, port, "GET", path, requestHeaders, responseHeaders, content, status_code);
+		return send(server, port, "GET", path, requestHeaders, responseHeaders, content, status_code, token);
 	}
 
 	bool HTTPClientService::post(const std::string& server, const std::string& port, const std::string& path,
 		const std::map<std::string, std::string>& requestHeaders,
 		std::map<std::string, std::string>& responseHeaders,
-		std::string& content, unsigned int& status_code)
+		std::string& content, unsigned int& status_code,
+		const utils::runtime::CancellationToken& token)
 	{
-		return send(server, port, "POST", path, requestHeaders, responseHeaders, content, status_code);
+		return send(server, port, "POST", path, requestHeaders, responseHeaders, content, status_code, token);
+	}
+
+	bool HTTPClientService::stream(const std::string& server, const std::string& port, const std::string& path,
+		const std::map<std::string, std::string>& requestHeaders,
+		std::map<std::string, std::string>& responseHeaders,
+		SinkType sink, unsigned int& status_code,
+		const utils::runtime::CancellationToken& token)
+	{
+		return send(server, port, "GET", path, requestHeaders, responseHeaders, std::move(sink), status_code, token);
 	}
 
 	bool HTTPClientService::send(const std::string& server, const std::string& port, const std::string& action, 
 								const std::string& path, const std::map<std::string, std::string>& requestHeaders,
 								std::map<std::string, std::string>& responseHeaders,
-								std::string& content, unsigned int& status_code)
+								std::string& content, unsigned int& status_code,
+								const utils::runtime::CancellationToken& token)
 	{
+		content.clear();
+
+		return send(server, port, action, path, requestHeaders, responseHeaders, [&content](const char* data, std::size_t size)
+		{
+			content.append(data, size);
+			return true;
+		}, status_code, token);
+	}
+
+	bool HTTPClientService::send(const std::string& server, const std::string& port, const std::string& action, 
+								const std::string& path, const std::map<std::string, std::string>& requestHeaders,
+								std::map<std::string, std::string>& responseHeaders,
+								SinkType sink, unsigned int& status_code,
+								const utils::runtime::CancellationToken& token)
+	{
+		BLING_TRACE_SPAN("http", "request");
+
+		auto start = std::chrono::steady_clock::now();
+		std::size_t received = 0;
+
+		SinkType counted = [&sink, &received](const char* data, std::size_t size)
+		{
+			received += size;
+			return sink(data, size);
+		};
+
+		bool result = exchange(server, port, action, path, requestHeaders, responseHeaders, counted, status_code, token);
+
+		m_duration.observe(std::chrono::steady_clock::now() - start);
+		m_requests.increment();
+
+		if (result)
+		{
+			m_received.increment(received);
+
+			utils::metrics::Registry::get().counter("bling_http_responses_total", "Complete responses by status code", {{"status", std::to_string(status_code)}}).increment();
+		}
+		else
+		{
+			m_failures.increment();
+		}
+
+		return result;
+	}
+
+	bool HTTPClientService::exchange(const std::string& server, const std::string& port, const std::string& action, 
+								const std::string& path, const std::map<std::string, std::string>& requestHeaders,
+								std::map<std::string, std::string>& responseHeaders,
+								const SinkType& sink, unsigned int& status_code,
+								const utils::runtime::CancellationToken& token)
+	{
+		// Handlers of an aborted request can still be queued when the next one starts
+		auto generation = ++m_generation;
+
+		// The socket is only closed on the thread running the io_service, which also
+		// completes a resolve still waiting for the name server
+		auto registration = token.onCancel([this, generation]()
+		{
+			m_io_service.post([this, generation]()
+			{
+				abort(generation);
+			});
+		});
+
+		if (token.cancelled())
+		{
+			return false;
+		}
+
 		try
 		{
-			tcp::resolver resolver(m_io_service);
-			tcp::resolver::query query(server, port);
-			tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
+			m_socket.reset(new boost::asio::ssl::stream<boost::asio::ip::tcp::socket>(m_io_service, context_));
 
 			boost::system::error_code error;
-			boost::asio::connect(m_socket->lowest_layer(), endpoint_iterator, error);
+			tcp::resolver::iterator endpoint_iterator;
+
+			{
+				BLING_TRACE_SPAN("http", "resolve");
+				m_resolver.async_resolve(tcp::resolver::query(server, port), [&error, &endpoint_iterator](const boost::system::error_code& result, tcp::resolver::iterator iterator)
+				{
+					error = result;
+					endpoint_iterator = iterator;
+				});
+				wait(generation, error);
+			}
 
-			m_socket->handshake(boost::asio::ssl::stream_base::client, error);
+			{
+				BLING_TRACE_SPAN("http", "connect");
+				boost::asio::async_connect(m_socket->lowest_layer(), endpoint_iterator, [&error](const boost::system::error_code& result, tcp::resolver::iterator)
+				{
+					error = result;
+				});
+				wait(generation, error);
+			}
+
+			{
+				BLING_TRACE_SPAN("http", "handshake");
+				m_socket->async_handshake(boost::asio::ssl::stream_base::client, [&error](const boost::system::error_code& result)
+				{
+					error = result;
+				});
+				wait(generation, error);
+			}
 
 			boost::asio::streambuf request;
 			std::ostream request_stream(&request);
@@ -75,26 +189,45 @@ namespace desktop { namespace core { namespace service {
 
 			request_stream << "\r\n";
 
-			boost::asio::write(*(m_socket.get()), request);
+			{
+				BLING_TRACE_SPAN("http", "write");
+				boost::asio::async_write(*(m_socket.get()), request, [&error](const boost::system::error_code& result, std::size_t)
+				{
+					error = result;
+				});
+				wait(generation, error);
+			}
 
-			bool result = receive(responseHeaders, content, status_code);
+			bool result = receive(generation, responseHeaders, sink, status_code) && !token.cancelled();
 
-			m_socket->shutdown(error);
 			m_socket->lowest_layer().close(error);
-			m_io_service.stop();
 
 			return result;
 		}
 		catch (...)
 		{
+			boost::system::error_code error;
+			m_socket->lowest_layer().close(error);
+
 			return false;
 		}	
 	}
 
-	bool HTTPClientService::receive(std::map<std::string, std::string>& headers, std::string& content, unsigned int& status_code)
+	bool HTTPClientService::receive(std::size_t generation, std::map<std::string, std::string>& headers, const SinkType& sink, unsigned int& status_code)
 	{
 		boost::asio::streambuf response;
-		boost::asio::read_until(*(m_socket.get()), response, "\r\n");
+		boost::system::error_code error;
+
+		auto completed = [&error](const boost::system::error_code& result, std::size_t)
+		{
+			error = result;
+		};
+
+		{
+			BLING_TRACE_SPAN("http", "wait");
+			boost::asio::async_read_until(*(m_socket.get()), response, "\r\n", completed);
+			wait(generation, error);
+		}
 
 		std::istream response_stream(&response);
 		std::string http_version;
@@ -111,7 +244,9 @@ namespace desktop { namespace core { namespace service {
 		else
 		{
 			// Read the response headers, which are terminated by a blank line.
-			boost::asio::read_until(*(m_socket.get()), response, "\r\n\r\n");
+			BLING_TRACE_SPAN("http", "read");
+			boost::asio::async_read_until(*(m_socket.get()), response, "\r\n\r\n", completed);
+			wait(generation, error);
 
 			// Process the response headers.
 			std::string header;
@@ -134,24 +269,82 @@ namespace desktop { namespace core { namespace service {
 				headers.insert(header_struct);
 			}
 
-			std::stringstream content_os;
+			auto deliver = [&response, &sink]()
+			{
+				auto size = response.size();
+				bool accepted = sink(boost::asio::buffer_cast<const char*>(response.data()), size);
+
+				response.consume(size);
+
+				return accepted;
+			};
 
 			// Write whatever content we already have to output.
-			if (response.size() > 0)
+			if (response.size() > 0 && !deliver())
 			{
-				content_os << &response;
+				return false;
 			}
 
 			// Read until EOF, writing data to output as we go.
-			boost::system::error_code error;
-			while (boost::asio::read(*(m_socket.get()), response, boost::asio::transfer_at_least(1), error))
+			while (true)
+			{
+				boost::asio::async_read(*(m_socket.get()), response, boost::asio::transfer_at_least(1), completed);
+
+				try
+				{
+					wait(generation, error);
+				}
+				catch (const boost::system::system_error& e)
+				{
+					return boost::asio::error::eof == e.code();
+				}
+
+				if (!deliver())
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	void HTTPClientService::wait(std::size_t generation, boost::system::error_code& error)
+	{
+		error = boost::asio::error::would_block;
+
+		// Each step may take up to TIMEOUT, a slow download only fails when it stalls
+		m_deadline.expires_from_now(TIMEOUT);
+		m_deadline.async_wait([this, generation](const boost::system::error_code&)
+		{
+			// A deadline that fired as the step completed finds the expiry of the next one
+			if (m_deadline.expires_at() <= boost::asio::steady_timer::clock_type::now())
 			{
-				content_os << &response;
+				abort(generation);
 			}
+		});
+
+		m_io_service.reset();
 
-			content = content_os.str();
+		while (error == boost::asio::error::would_block)
+		{
+			m_io_service.run_one();
+		}
+
+		m_deadline.cancel();
+
+		if (error)
+		{
+			throw boost::system::system_error(error);
+		}
+	}
+
+	void HTTPClientService::abort(std::size_t generation)
+	{
+		if (generation == m_generation && m_socket.get())
+		{
+			boost::system::error_code error;
 
-			return (boost::asio::error::eof == error);
+			m_resolver.cancel();
+			m_socket->lowest_layer().close(error);
 		}
 	}
 }}}
\ No newline at end of file
@@ -1,34 +1,76 @@
 #pragma once
 
+#include "../../Utils/Metrics/Metrics.h"
+#include "../../Utils/Runtime/CancellationToken.h"
+
+#include <chrono>
+#include <functional>
 #include <string>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 namespace desktop { namespace core { namespace service {
 
+	// Requests fail as soon as the token is cancelled or a step makes no progress for TIMEOUT. Every
+	// step runs asynchronously on the calling thread, so cancelling closes the socket there.
 	class HTTPClientService
 	{
 	public:
+		typedef std::function<bool(const char* data, std::size_t size)> SinkType;
+
+		static const std::chrono::seconds TIMEOUT;
+
 		HTTPClientService();
 		~HTTPClientService();
 		bool get(const std::string& server, const std::string& port, const std::string&, 
 					const std::map<std::string, std::string>& requestHeaders, 
 					std::map<std::string, std::string>& responseHeaders, 
-					std::string& content, unsigned int& status_code);
+					std::string& content, unsigned int& status_code,
+					const utils::runtime::CancellationToken& token = utils::runtime::CancellationToken());
 		bool post(const std::string& server, const std::string& port, const std::string&,
 			const std::map<std::string, std::string>& requestHeaders,
 			std::map<std::string, std::string>& responseHeaders,
-			std::string& content, unsigned int& status_code);
+			std::string& content, unsigned int& status_code,
+			const utils::runtime::CancellationToken& token = utils::runtime::CancellationToken());
+		// GET that hands the body to sink as it is read instead of keeping it. status_code is set
+		// before the first call; a sink returning false stops the transfer and the request fails.
+		bool stream(const std::string& server, const std::string& port, const std::string& path,
+			const std::map<std::string, std::string>& requestHeaders,
+			std::map<std::string, std::string>& responseHeaders,
+			SinkType sink, unsigned int& status_code,
+			const utils::runtime::CancellationToken& token = utils::runtime::CancellationToken());
 	private:
 		bool send(const std::string& server, const std::string& port, const std::string& action,
 			const std::string& path, const std::map<std::string, std::string>& requestHeaders,
 			std::map<std::string, std::string>& responseHeaders,
-			std::string& content, unsigned int& status_code);
-		bool receive(std::map<std::string, std::string>& headers, std::string& content, unsigned int& status_code);
+			std::string& content, unsigned int& status_code,
+			const utils::runtime::CancellationToken& token);
+		bool send(const std::string& server, const std::string& port, const std::string& action,
+			const std::string& path, const std::map<std::string, std::string>& requestHeaders,
+			std::map<std::string, std::string>& responseHeaders,
+			SinkType sink, unsigned int& status_code,
+			const utils::runtime::CancellationToken& token);
+		bool exchange(const std::string& server, const std::string& port, const std::string& action,
+			const std::string& path, const std::map<std::string, std::string>& requestHeaders,
+			std::map<std::string, std::string>& responseHeaders,
+			const SinkType& sink, unsigned int& status_code,
+			const utils::runtime::CancellationToken& token);
+		bool receive(std::size_t generation, std::map<std::string, std::string>& headers, const SinkType& sink, unsigned int& status_code);
+		void wait(std::size_t generation, boost::system::error_code& error);
+		void abort(std::size_t generation);
 	private:
 		boost::asio::io_service m_io_service;
+		boost::asio::ip::tcp::resolver m_resolver;
+		boost::asio::steady_timer m_deadline;
+		std::size_t m_generation;
 		std::string m_root;
 		std::auto_ptr<boost::asio::ssl::stream<boost::asio::ip::tcp::socket>> m_socket;
 		boost::asio::ssl::context context_;
+
+		utils::metrics::Counter& m_requests;
+		utils::metrics::Counter& m_failures;
+		utils::metrics::Counter& m_received;
+		utils::metrics::Histogram& m_duration;
 	};
 }}}
\ No newline at end of file
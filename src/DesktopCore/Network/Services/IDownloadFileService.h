@@ -1,15 +1,35 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <map>
 #include <memory>
 
+#include "../../Utils/Runtime/CancellationToken.h"
+
 namespace desktop { namespace core { namespace service {
 
 	class IDownloadFileService
 	{
 	public:
+		typedef std::function<bool(const char* data, std::size_t size)> SinkType;
+
 		virtual ~IDownloadFileService() = default;
-		virtual std::string download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder) const = 0;
+		// Returns an empty path when the download failed or the token was cancelled
+		virtual std::string download(const std::string& host, const std::string& url, std::map<std::string, std::string> requestHeaders, const std::string &folder,
+								const utils::runtime::CancellationToken& token = utils::runtime::CancellationToken()) const = 0;
+
+		// Services that download through the browser can only save files
+		virtual bool canStream() const
+		{
+			return false;
+		}
+
+		// Hands the body to sink as it arrives instead of saving it. Fails when the sink returns false.
+		virtual bool stream(const std::string& /*host*/, const std::string& /*url*/, std::map<std::string, std::string> /*requestHeaders*/, SinkType /*sink*/,
+							const utils::runtime::CancellationToken& /*token*/ = utils::runtime::CancellationToken()) const
+		{
+			return false;
+		}
 	};
 }}}
\ No newline at end of file
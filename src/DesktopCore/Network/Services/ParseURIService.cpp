@@ -1,47 +1,443 @@
 #include "ParseURIService.h"
 
-#include <boost/regex.hpp>
+#include <algorithm>
+#include <cstring>
+#include <boost/algorithm/string/predicate.hpp>
 
 namespace desktop { namespace core { namespace service {
 
+	namespace
+	{
+		bool isAlpha(char c)
+		{
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+		}
+
+		bool isDigit(char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		int hexValue(char c)
+		{
+			if (isDigit(c))
+			{
+				return c - '0';
+			}
+			else if (c >= 'a' && c <= 'f')
+			{
+				return c - 'a' + 10;
+			}
+			else if (c >= 'A' && c <= 'F')
+			{
+				return c - 'A' + 10;
+			}
+
+			return -1;
+		}
+
+		enum Class : unsigned char
+		{
+			// Unreserved characters and sub-delimiters, allowed anywhere in an authority
+			NAME = 1,
+			PRINTABLE = 2
+		};
+
+		struct Classes
+		{
+			unsigned char m_values[256];
+
+			Classes()
+			{
+				for (int c = 0; c < 256; ++c)
+				{
+					bool name = isAlpha(static_cast<char>(c)) || isDigit(static_cast<char>(c)) || std::strchr("-._~!$&'()*+,;=", c) != nullptr;
+
+					m_values[c] = static_cast<unsigned char>((name && c != 0 ? NAME : 0) | (c > 0x20 && c != 0x7f ? PRINTABLE : 0));
+				}
+			}
+
+			bool is(char c, Class value) const
+			{
+				return (m_values[static_cast<unsigned char>(c)] & value) != 0;
+			}
+		};
+
+		const Classes g_classes;
+
+		// Unreserved characters, sub-delimiters, percent escapes and colons when allowed
+		bool isValid(const char* p, const char* end, bool colons)
+		{
+			while (p != end)
+			{
+				if (*p == '%')
+				{
+					if (end - p < 3 || hexValue(p[1]) < 0 || hexValue(p[2]) < 0)
+					{
+						return false;
+					}
+
+					p += 3;
+				}
+				else if (g_classes.is(*p, NAME) || (colons && *p == ':'))
+				{
+					++p;
+				}
+				else
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Up to the first of the stop characters, failing on spaces and control characters
+		bool scan(const char*& p, const char* end, char first, char second)
+		{
+			while (p != end && *p != first && *p != second)
+			{
+				if (!g_classes.is(*p++, PRINTABLE))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Four decimal octets without leading zeros
+		bool isIPv4(const char* p, const char* end)
+		{
+			for (int octet = 0; octet < 4; ++octet)
+			{
+				if (octet > 0 && (p == end || *p++ != '.'))
+				{
+					return false;
+				}
+
+				const char* start = p;
+				int value = 0;
+
+				while (p != end && isDigit(*p) && p - start < 3)
+				{
+					value = value * 10 + (*p++ - '0');
+				}
+
+				if (p == start || value > 255 || (*start == '0' && p - start > 1))
+				{
+					return false;
+				}
+			}
+
+			return p == end;
+		}
+
+		bool isIPv6(const char* p, const char* end)
+		{
+			int groups = 0;
+			bool compressed = false;
+
+			if (end - p >= 2 && p[0] == ':' && p[1] == ':')
+			{
+				compressed = true;
+				p += 2;
+			}
+
+			while (p != end)
+			{
+				const char* start = p;
+
+				while (p != end && hexValue(*p) >= 0)
+				{
+					++p;
+				}
+
+				// The last 32 bits may be written as an IPv4 address
+				if (p != end && *p == '.')
+				{
+					if (!isIPv4(start, end))
+					{
+						return false;
+					}
+
+					groups += 2;
+					break;
+				}
+
+				if (p == start || p - start > 4)
+				{
+					return false;
+				}
+
+				++groups;
+
+				if (p == end)
+				{
+					break;
+				}
+
+				if (*p++ != ':' || p == end)
+				{
+					return false;
+				}
+
+				if (*p == ':')
+				{
+					if (compressed)
+					{
+						return false;
+					}
+
+					compressed = true;
+					++p;
+				}
+			}
+
+			return compressed ? groups < 8 : groups == 8;
+		}
+
+		bool isIPLiteral(const char* p, const char* end)
+		{
+			if (p != end && (*p == 'v' || *p == 'V'))
+			{
+				const char* dot = std::find(p, end, '.');
+
+				return dot - p > 1 && std::all_of(p + 1, dot, [](char c) { return hexValue(c) >= 0; }) && dot != end && dot + 1 != end && isValid(dot + 1, end, true);
+			}
+
+			return isIPv6(p, end);
+		}
+
+		boost::string_view view(const char* begin, const char* end)
+		{
+			return boost::string_view(begin, static_cast<std::size_t>(end - begin));
+		}
+	}
+
+	boost::string_view ParseURIService::Components::port() const
+	{
+		if (!m_port.empty())
+		{
+			return m_port;
+		}
+		else if (boost::algorithm::iequals(m_scheme, "https"))
+		{
+			return "443";
+		}
+		else if (boost::algorithm::iequals(m_scheme, "http"))
+		{
+			return "80";
+		}
+
+		return m_port;
+	}
+
 	ParseURIService::ParseURIService()
 	{
-	
+
 	}
 
 	ParseURIService::~ParseURIService() = default;
 
-	bool ParseURIService::parse(const std::string& uri, std::string& protocol, std::string& domain, std::string& port, std::string& path, std::string& query, std::string& fragment) const
+	bool ParseURIService::parse(boost::string_view uri, Components& components) const
 	{
-		boost::regex ex("(http|https)://([^/ :]+):?([^/ ]*)(/?[^ #?]*)\\x3f?([^ #]*)#?([^ ]*)");
-		boost::cmatch what;
+		const char* p = uri.data();
+		const char* end = p + uri.size();
 
-		if (regex_match(uri.c_str(), what, ex))
+		Components result;
+
+		const char* q = p;
+
+		if (q != end && isAlpha(*q))
+		{
+			while (q != end && (isAlpha(*q) || isDigit(*q) || *q == '+' || *q == '-' || *q == '.'))
+			{
+				++q;
+			}
+
+			if (q != end && *q == ':')
+			{
+				result.m_scheme = view(p, q);
+				p = q + 1;
+			}
+		}
+
+		if (end - p >= 2 && p[0] == '/' && p[1] == '/')
 		{
-			protocol = std::string(what[1].first, what[1].second);
-			domain = std::string(what[2].first, what[2].second);
-			port = std::string(what[3].first, what[3].second);
-			path = std::string(what[4].first, what[4].second);
-			query = std::string(what[5].first, what[5].second);
-			fragment = std::string(what[6].first, what[6].second);
+			p += 2;
+
+			const char* authorityEnd = p;
+			const char* at = nullptr;
 
-			if (port == "")
+			// The last @ ends the user information, which may contain escaped ones
+			while (authorityEnd != end && *authorityEnd != '/' && *authorityEnd != '?' && *authorityEnd != '#')
 			{
-				if (protocol == "https")
+				if (*authorityEnd == '@')
 				{
-					port = "443";
+					at = authorityEnd;
 				}
-				else
+
+				++authorityEnd;
+			}
+
+			if (at)
+			{
+				if (!isValid(p, at, true))
 				{
-					port = "80";
+					return false;
 				}
+
+				result.m_userInfo = view(p, at);
+				p = at + 1;
 			}
 
-			return true;
+			if (p != authorityEnd && *p == '[')
+			{
+				const char* close = std::find(p, authorityEnd, ']');
+
+				if (close == authorityEnd || !isIPLiteral(p + 1, close))
+				{
+					return false;
+				}
+
+				result.m_host = view(p + 1, close);
+				p = close + 1;
+			}
+			else
+			{
+				const char* hostEnd = std::find(p, authorityEnd, ':');
+
+				if (!isValid(p, hostEnd, false))
+				{
+					return false;
+				}
+
+				result.m_host = view(p, hostEnd);
+				p = hostEnd;
+			}
+
+			if (p != authorityEnd)
+			{
+				if (*p != ':' || !std::all_of(p + 1, authorityEnd, isDigit))
+				{
+					return false;
+				}
+
+				result.m_port = view(p + 1, authorityEnd);
+			}
+
+			p = authorityEnd;
 		}
-		else
+		else if (result.m_scheme.empty())
+		{
+			// A relative path can not start with what looks like a scheme
+			const char* segmentEnd = std::find_if(p, end, [](char c) { return c == '/' || c == '?' || c == '#'; });
+
+			if (std::find(p, segmentEnd, ':') != segmentEnd)
+			{
+				return false;
+			}
+		}
+
+		const char* start = p;
+
+		if (!scan(p, end, '?', '#'))
+		{
+			return false;
+		}
+
+		result.m_path = view(start, p);
+
+		if (p != end && *p == '?')
+		{
+			start = ++p;
+
+			if (!scan(p, end, '#', '#'))
+			{
+				return false;
+			}
+
+			result.m_query = view(start, p);
+		}
+
+		if (p != end && *p == '#')
+		{
+			start = ++p;
+
+			// Only stops early on a NUL
+			if (!scan(p, end, '\0', '\0') || p != end)
+			{
+				return false;
+			}
+
+			result.m_fragment = view(start, p);
+		}
+
+		components = result;
+
+		return true;
+	}
+
+	bool ParseURIService::parse(const std::string& uri, std::string& protocol, std::string& domain, std::string& port, std::string& path, std::string& query, std::string& fragment) const
+	{
+		Components components;
+
+		if (!parse(boost::string_view(uri), components) || components.m_host.empty() ||
+			!(boost::algorithm::iequals(components.m_scheme, "http") || boost::algorithm::iequals(components.m_scheme, "https")))
 		{
 			return false;
 		}
+
+		protocol = components.m_scheme.to_string();
+		domain = components.m_host.to_string();
+		port = components.port().to_string();
+		path = components.m_path.to_string();
+		query = components.m_query.to_string();
+		fragment = components.m_fragment.to_string();
+
+		return true;
+	}
+
+	std::size_t ParseURIService::decode(boost::string_view text, char* out)
+	{
+		std::size_t size = 0;
+
+		for (std::size_t i = 0; i < text.size(); ++i)
+		{
+			if (text[i] == '%')
+			{
+				if (text.size() - i < 3 || hexValue(text[i + 1]) < 0 || hexValue(text[i + 2]) < 0)
+				{
+					return boost::string_view::npos;
+				}
+
+				out[size++] = static_cast<char>(hexValue(text[i + 1]) * 16 + hexValue(text[i + 2]));
+				i += 2;
+			}
+			else
+			{
+				out[size++] = text[i];
+			}
+		}
+
+		return size;
+	}
+
+	bool ParseURIService::decode(boost::string_view text, std::string& out)
+	{
+		out.resize(text.size());
+
+		auto size = decode(text, &out[0]);
+
+		if (size == boost::string_view::npos)
+		{
+			out.clear();
+			return false;
+		}
+
+		out.resize(size);
+
+		return true;
 	}
 }}}
\ No newline at end of file
@@ -2,14 +2,40 @@
 
 #include <string>
 #include <memory>
+#include <boost/utility/string_view.hpp>
 
 namespace desktop { namespace core { namespace service {
 
 	class ParseURIService
 	{
 	public:
+		// Views into the parsed text, which must outlive them. Hosts given as IP literals are kept
+		// without their brackets; percent escapes are left as they are.
+		struct Components
+		{
+			boost::string_view m_scheme;
+			boost::string_view m_userInfo;
+			boost::string_view m_host;
+			boost::string_view m_port;
+			boost::string_view m_path;
+			boost::string_view m_query;
+			boost::string_view m_fragment;
+
+			// m_port, or the port of http and https when there is none
+			boost::string_view port() const;
+		};
+
 		ParseURIService();
 		~ParseURIService();
+
+		// RFC 3986 URI or relative reference, without allocating. Paths, queries and fragments only
+		// reject spaces and control characters, as browsers do.
+		bool parse(boost::string_view uri, Components& components) const;
+		// http and https URIs with a host
 		bool parse(const std::string& uri, std::string& protocol, std::string& domain, std::string& port, std::string& path, std::string& query, std::string& fragment) const;
+
+		// Writes at most text.size() characters into out and returns how many; npos for a malformed escape
+		static std::size_t decode(boost::string_view text, char* out);
+		static bool decode(boost::string_view text, std::string& out);
 	};
 }}}
\ No newline at end of file
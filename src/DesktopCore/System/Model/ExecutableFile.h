@@ -1,15 +1,17 @@
 #pragma once
 
-#include "Model\NamedType.h"
+#include "Model/NamedType.h"
 
 #include <string>
+#include <vector>
 #include <boost/filesystem/path.hpp>
 
 namespace desktop { namespace core { namespace model { namespace system {
 	struct ExecutableFile
 	{
 		using Path = NamedType<boost::filesystem::path, struct PathParameter>;
-		using Arguments = NamedType<std::string, struct ArgumentsParameter>;
+		// One entry per argument, passed as is; never joined into a command line for a shell
+		using Arguments = NamedType<std::vector<std::string>, struct ArgumentsParameter>;
 
 		ExecutableFile(Path path, Arguments arguments);
 
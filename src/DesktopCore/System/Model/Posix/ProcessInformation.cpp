@@ -0,0 +1,12 @@
+#include "../ProcessInformation.h"
+
+namespace desktop { namespace core { namespace model { namespace system {
+	ProcessInformation::ProcessInformation(unsigned long processID)
+	: m_hProcess(nullptr)
+	, m_hThread(nullptr)
+	, m_processID(processID)
+	, m_threadID(0)
+	{
+
+	}
+}}}}
\ No newline at end of file
@@ -12,6 +12,15 @@ namespace desktop { namespace core { namespace model { namespace system {
 
 	}
 
+	ProcessInformation::ProcessInformation(unsigned long processID)
+	: m_hProcess(nullptr)
+	, m_hThread(nullptr)
+	, m_processID(processID)
+	, m_threadID(0)
+	{
+
+	}
+
 	bool ProcessInformation::operator==(const PROCESS_INFORMATION& other) const
 	{
 		return m_hProcess == other.hProcess && m_hThread == other.hThread;
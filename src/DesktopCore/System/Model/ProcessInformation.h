@@ -9,6 +9,7 @@ namespace desktop { namespace core { namespace model { namespace system {
 	struct ProcessInformation
 	{
 		ProcessInformation(const PROCESS_INFORMATION& processInfo);
+		explicit ProcessInformation(unsigned long processID);
 
 		bool operator==(const PROCESS_INFORMATION& other) const;
 				
@@ -12,17 +12,22 @@ namespace desktop { namespace core { namespace service {
 
 	std::string ApplicationDataService::getMyDocuments() const
 	{
-		CHAR my_documents[MAX_PATH];
-		HRESULT result = SHGetFolderPath(NULL, CSIDL_PERSONAL, NULL, SHGFP_TYPE_CURRENT, my_documents);
-
-		if (result == S_OK)
-		{
-			return std::string(my_documents) + "\\" + getApplicationName() + "\\";
-		}
-		else
+		static const std::string documents = [this]()
 		{
-			return "";
-		}
+			CHAR my_documents[MAX_PATH];
+			HRESULT result = SHGetFolderPath(NULL, CSIDL_PERSONAL, NULL, SHGFP_TYPE_CURRENT, my_documents);
+
+			if (result == S_OK)
+			{
+				return std::string(my_documents) + "\\" + getApplicationName() + "\\";
+			}
+			else
+			{
+				return std::string();
+			}
+		}();
+
+		return documents;
 	}
 
 	std::string ApplicationDataService::getApplicationFolder() const
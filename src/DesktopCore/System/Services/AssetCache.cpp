@@ -0,0 +1,171 @@
+#include "AssetCache.h"
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Tracing/Tracer.h"
+
+#include <fstream>
+#include <sstream>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/filesystem.hpp>
+
+namespace desktop { namespace core { namespace service {
+
+	const std::uintmax_t AssetCache::MAX_FILE;
+	const std::uintmax_t AssetCache::MAX_TOTAL;
+
+	AssetCache& AssetCache::get()
+	{
+		// Leaked, file server threads can outlive main
+		static AssetCache* instance = new AssetCache();
+		return *instance;
+	}
+
+	AssetCache::AssetCache() = default;
+	AssetCache::~AssetCache() = default;
+
+	void AssetCache::preload(const std::string& folder, const DeltaFolderService::ManifestType& manifest)
+	{
+		BLING_TRACE_SPAN("upgrade", "preload");
+
+		std::unordered_map<std::string, AssetType> assets;
+		std::uintmax_t total = 0;
+
+		for (auto& item : manifest)
+		{
+			auto path = (boost::filesystem::path(folder) / item.first).string();
+			auto size = item.second.first;
+
+			boost::system::error_code ec;
+			auto mtime = boost::filesystem::last_write_time(path, ec);
+
+			if (ec || size > MAX_FILE || total + size > MAX_TOTAL)
+			{
+				continue;
+			}
+
+			auto asset = read(path, size, mtime, "\"" + item.second.second.substr(0, 16) + "\"");
+
+			if (asset)
+			{
+				total += asset->m_size;
+				assets[key(path)] = asset;
+			}
+		}
+
+		auto count = assets.size();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_assets.swap(assets);
+			m_size = total;
+		}
+
+		BLING_LOG_INFO("AssetCache", "Preloaded " << count << " files (" << total << " bytes) from " << folder);
+	}
+
+	AssetCache::AssetType AssetCache::find(const std::string& path)
+	{
+		auto id = key(path);
+
+		boost::system::error_code ec;
+		auto size = boost::filesystem::file_size(path, ec);
+
+		if (ec)
+		{
+			return nullptr;
+		}
+
+		auto mtime = boost::filesystem::last_write_time(path, ec);
+
+		if (ec)
+		{
+			return nullptr;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto it = m_assets.find(id);
+
+			if (it != m_assets.end() && it->second->m_size == size && it->second->m_mtime == mtime)
+			{
+				return it->second;
+			}
+		}
+
+		if (size > MAX_FILE)
+		{
+			return nullptr;
+		}
+
+		std::stringstream etag;
+		etag << "\"" << std::hex << size << "-" << mtime << "\"";
+
+		auto asset = read(path, size, mtime, etag.str());
+
+		if (asset)
+		{
+			store(id, asset);
+		}
+
+		return asset;
+	}
+
+	std::string AssetCache::key(const std::string& path)
+	{
+		auto result = boost::filesystem::path(path).generic_string();
+
+		while (result.find("//") != std::string::npos)
+		{
+			boost::algorithm::replace_all(result, "//", "/");
+		}
+
+		return result;
+	}
+
+	AssetCache::AssetType AssetCache::read(const std::string& path, std::uintmax_t size, std::time_t mtime, const std::string& etag)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+
+		if (!file.is_open())
+		{
+			return nullptr;
+		}
+
+		auto asset = std::make_shared<Asset>();
+		asset->m_body.resize(static_cast<std::size_t>(size));
+
+		if (size > 0 && !file.read(reinterpret_cast<char*>(asset->m_body.data()), asset->m_body.size()))
+		{
+			return nullptr;
+		}
+
+		asset->m_etag = etag;
+		asset->m_size = size;
+		asset->m_mtime = mtime;
+
+		return asset;
+	}
+
+	void AssetCache::store(const std::string& key, AssetType asset)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto& slot = m_assets[key];
+		auto previous = slot ? slot->m_size : 0;
+
+		if (m_size - previous + asset->m_size > MAX_TOTAL)
+		{
+			if (!slot)
+			{
+				m_assets.erase(key);
+			}
+
+			return;
+		}
+
+		m_size = m_size - previous + asset->m_size;
+		slot = asset;
+	}
+}}}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "DeltaFolderService.h"
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace desktop { namespace core { namespace service {
+
+	// Process-wide copy in memory of the files served by the file server. An upgrade preloads the
+	// whole viewer before announcing itself, so the first load after it reads nothing from disk;
+	// other files are kept the first time they are asked for. Each lookup compares the size and
+	// mtime on disk, so files changed behind the cache are read again.
+	class AssetCache
+	{
+	public:
+		struct Asset
+		{
+			std::vector<unsigned char>	m_body;
+			std::string					m_etag;
+			std::uintmax_t				m_size = 0;
+			std::time_t					m_mtime = 0;
+		};
+
+		typedef std::shared_ptr<const Asset> AssetType;
+
+		static const std::uintmax_t MAX_FILE = 8 * 1024 * 1024;
+		static const std::uintmax_t MAX_TOTAL = 64 * 1024 * 1024;
+
+		static AssetCache& get();
+
+		// Replaces the cache with the files listed in the manifest of folder, tagged with their hashes
+		void preload(const std::string& folder, const DeltaFolderService::ManifestType& manifest);
+		// Null when the file does not exist or does not fit in the cache
+		AssetType find(const std::string& path);
+	private:
+		AssetCache();
+		~AssetCache();
+		AssetCache(const AssetCache&) = delete;
+		AssetCache& operator=(const AssetCache&) = delete;
+
+		static std::string key(const std::string& path);
+		static AssetType read(const std::string& path, std::uintmax_t size, std::time_t mtime, const std::string& etag);
+
+		void store(const std::string& key, AssetType asset);
+	private:
+		std::unordered_map<std::string, AssetType>		m_assets;
+		std::uintmax_t									m_size = 0;
+		std::mutex										m_mutex;
+	};
+}}}
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "BinaryPatchService.h"
+
+#include "Utils/Tracing/Tracer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace desktop { namespace core { namespace service {
+
+	namespace
+	{
+		const char g_copy = 'C';
+		const char g_add = 'A';
+		const std::uint32_t g_base = 257;
+
+		void put(std::string& out, std::uint64_t value)
+		{
+			for (unsigned int i = 0; i < 8; ++i)
+			{
+				out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+			}
+		}
+
+		bool take(const std::string& in, std::size_t& offset, std::uint64_t& value)
+		{
+			if (in.size() - offset < 8)
+			{
+				return false;
+			}
+
+			value = 0;
+
+			for (unsigned int i = 0; i < 8; ++i)
+			{
+				value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[offset + i])) << (8 * i);
+			}
+
+			offset += 8;
+
+			return true;
+		}
+
+		std::uint32_t hash(const char* data, std::size_t size)
+		{
+			std::uint32_t result = 0;
+
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				result = result * g_base + static_cast<unsigned char>(data[i]);
+			}
+
+			return result;
+		}
+
+		void addBytes(std::string& patch, const std::string& target, std::size_t from, std::size_t to)
+		{
+			if (to > from)
+			{
+				patch.push_back(g_add);
+				put(patch, to - from);
+				patch.append(target, from, to - from);
+			}
+		}
+	}
+
+	const char* BinaryPatchService::MAGIC = "BLPATCH1";
+	const std::size_t BinaryPatchService::BLOCK;
+
+	BinaryPatchService::BinaryPatchService() = default;
+	BinaryPatchService::~BinaryPatchService() = default;
+
+	std::string BinaryPatchService::diff(const std::string& source, const std::string& target) const
+	{
+		BLING_TRACE_SPAN("upgrade", "diff");
+
+		std::string patch(MAGIC);
+		put(patch, target.size());
+
+		// First offset of each aligned block of source, by hash
+		std::unordered_map<std::uint32_t, std::size_t> blocks;
+
+		for (std::size_t offset = 0; offset + BLOCK <= source.size(); offset += BLOCK)
+		{
+			blocks.emplace(hash(source.data() + offset, BLOCK), offset);
+		}
+
+		// Weight of the byte that leaves the rolling window
+		std::uint32_t outgoing = 1;
+
+		for (std::size_t i = 1; i < BLOCK; ++i)
+		{
+			outgoing *= g_base;
+		}
+
+		std::size_t pending = 0, position = 0;
+
+		if (target.size() >= BLOCK && !blocks.empty())
+		{
+			auto rolling = hash(target.data(), BLOCK);
+
+			while (true)
+			{
+				auto found = blocks.find(rolling);
+
+				if (found != blocks.end() && std::memcmp(source.data() + found->second, target.data() + position, BLOCK) == 0)
+				{
+					auto from = found->second, length = BLOCK;
+
+					while (position + length < target.size() && from + length < source.size() && target[position + length] == source[from + length])
+					{
+						++length;
+					}
+
+					while (position > pending && from > 0 && target[position - 1] == source[from - 1])
+					{
+						--position;
+						--from;
+						++length;
+					}
+
+					addBytes(patch, target, pending, position);
+
+					patch.push_back(g_copy);
+					put(patch, from);
+					put(patch, length);
+
+					position += length;
+					pending = position;
+
+					if (position + BLOCK > target.size())
+					{
+						break;
+					}
+
+					rolling = hash(target.data() + position, BLOCK);
+				}
+				else if (position + BLOCK < target.size())
+				{
+					rolling = (rolling - static_cast<unsigned char>(target[position]) * outgoing) * g_base + static_cast<unsigned char>(target[position + BLOCK]);
+					++position;
+				}
+				else
+				{
+					break;
+				}
+			}
+		}
+
+		addBytes(patch, target, pending, target.size());
+
+		return patch;
+	}
+
+	bool BinaryPatchService::apply(const std::string& source, const std::string& patch, std::string& target) const
+	{
+		BLING_TRACE_SPAN("upgrade", "patch");
+
+		auto magic = std::strlen(MAGIC);
+
+		if (patch.compare(0, magic, MAGIC) != 0)
+		{
+			return false;
+		}
+
+		std::size_t offset = magic;
+		std::uint64_t size;
+
+		if (!take(patch, offset, size))
+		{
+			return false;
+		}
+
+		target.clear();
+
+		// The size is not checked yet; an installer rarely outgrows the old one and the patch together
+		target.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(size, source.size() + patch.size())));
+
+		while (offset < patch.size())
+		{
+			auto op = patch[offset++];
+			std::uint64_t first, second;
+
+			if (op == g_copy && take(patch, offset, first) && take(patch, offset, second) && first <= source.size() && second <= source.size() - first)
+			{
+				target.append(source, static_cast<std::size_t>(first), static_cast<std::size_t>(second));
+			}
+			else if (op == g_add && take(patch, offset, first) && first <= patch.size() - offset)
+			{
+				target.append(patch, offset, static_cast<std::size_t>(first));
+				offset += static_cast<std::size_t>(first);
+			}
+			else
+			{
+				return false;
+			}
+
+			if (target.size() > size)
+			{
+				return false;
+			}
+		}
+
+		return target.size() == size;
+	}
+}}}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+namespace desktop { namespace core { namespace service {
+
+	// Patches that turn one version of a file into the next. A patch is a list of copies of blocks
+	// found in the old file and the bytes that are new, so its size follows the bytes that changed
+	// instead of the size of the file. diff is run by the release build, apply by the updater.
+	class BinaryPatchService
+	{
+	public:
+		static const char* MAGIC;
+		static const std::size_t BLOCK = 64;
+
+		BinaryPatchService();
+		~BinaryPatchService();
+
+		std::string diff(const std::string& source, const std::string& target) const;
+		// Fails on patches that are truncated or point outside source
+		bool apply(const std::string& source, const std::string& patch, std::string& target) const;
+	};
+}}}
\ No newline at end of file
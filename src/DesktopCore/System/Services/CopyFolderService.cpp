@@ -1,51 +1,249 @@
 #include "CopyFolderService.h"
 
+#include "Utils/Logging/Logger.h"
+#include "Utils/Tracing/Tracer.h"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <boost/filesystem.hpp>
 
-namespace desktop { namespace core { namespace service {
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-	CopyFolderService::CopyFolderService() = default;
-	CopyFolderService::~CopyFolderService() = default;
+namespace desktop { namespace core { namespace service {
 
 	namespace
 	{
-		void recursiveCopy(const boost::filesystem::path& input, const boost::filesystem::path& output)
-		{
-			if (boost::filesystem::exists(output))
-			{
-				throw std::runtime_error(output.generic_string() + " exists");
-			}
+		const unsigned int g_maxWorkers = 8;
+
+		typedef std::vector<std::pair<boost::filesystem::path, boost::filesystem::path>> FilesType;
 
+		void collect(const boost::filesystem::path& input, const boost::filesystem::path& output, FilesType& files)
+		{
 			if (boost::filesystem::is_directory(input))
 			{
 				boost::filesystem::create_directories(output);
 
 				for (boost::filesystem::directory_entry& item : boost::filesystem::directory_iterator(input))
 				{
-					recursiveCopy(item.path(), output / item.path().filename());
+					collect(item.path(), output / item.path().filename(), files);
 				}
 			}
 			else if (boost::filesystem::is_regular_file(input))
 			{
-				boost::filesystem::copy(input, output);
+				files.emplace_back(input, output);
 			}
 			else
 			{
 				throw std::runtime_error(output.generic_string() + " not dir or file");
 			}
 		}
+
+		bool alreadyCopied(const boost::filesystem::path& input, const boost::filesystem::path& output)
+		{
+			boost::system::error_code ec;
+
+			auto size = boost::filesystem::file_size(output, ec);
+
+			return !ec && size == boost::filesystem::file_size(input)
+				&& boost::filesystem::last_write_time(output, ec) == boost::filesystem::last_write_time(input) && !ec;
+		}
+
+		// Lets the file system do the copy: block cloning or server side copies on Windows,
+		// reflinks or copy_file_range on Linux, so the data may never pass through this process
+		void copyFile(const boost::filesystem::path& input, const boost::filesystem::path& output)
+		{
+#ifdef _WIN32
+			if (!CopyFileExW(input.wstring().c_str(), output.wstring().c_str(), nullptr, nullptr, nullptr, 0))
+			{
+				throw std::runtime_error("cannot copy " + input.string());
+			}
+#elif defined(__linux__)
+			int source = open(input.c_str(), O_RDONLY | O_CLOEXEC);
+
+			if (source < 0)
+			{
+				throw std::runtime_error("cannot read " + input.string());
+			}
+
+			struct stat status;
+			fstat(source, &status);
+
+			int target = open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, status.st_mode & 0777);
+
+			if (target < 0)
+			{
+				close(source);
+				throw std::runtime_error("cannot write " + output.string());
+			}
+
+			bool copied = false;
+
+#ifdef FICLONE
+			copied = ioctl(target, FICLONE, source) == 0;
+#endif
+
+			off_t left = status.st_size;
+
+			while (!copied && left > 0)
+			{
+				auto count = copy_file_range(source, nullptr, target, nullptr, static_cast<std::size_t>(left), 0);
+
+				if (count <= 0)
+				{
+					break;
+				}
+
+				left -= count;
+			}
+
+			close(source);
+			close(target);
+
+			if (!copied && left > 0)
+			{
+				// Older kernels or file systems without copy_file_range
+				boost::filesystem::copy_file(input, output, boost::filesystem::copy_option::overwrite_if_exists);
+			}
+#else
+			boost::filesystem::copy_file(input, output, boost::filesystem::copy_option::overwrite_if_exists);
+#endif
+		}
+	}
+
+	CopyFolderService::CopyFolderService(unsigned int workers)
+	: m_workers(workers)
+	, m_files(utils::metrics::Registry::get().counter("bling_copied_files_total", "Files copied between folders"))
+	, m_bytes(utils::metrics::Registry::get().counter("bling_copied_bytes_total", "Bytes copied between folders"))
+	, m_duration(utils::metrics::Registry::get().histogram("bling_copy_duration_seconds", "Time taken by each folder copy", utils::metrics::Histogram::Unit::MICROSECONDS))
+	{
+		if (m_workers == 0)
+		{
+			m_workers = std::thread::hardware_concurrency();
+			m_workers = m_workers == 0 ? 1 : m_workers < g_maxWorkers ? m_workers : g_maxWorkers;
+		}
 	}
 
+	CopyFolderService::~CopyFolderService() = default;
+
 	bool CopyFolderService::copy(const std::string& input, const std::string& output) const
 	{
+		BLING_TRACE_SPAN("copy", "folder");
+
+		auto start = std::chrono::steady_clock::now();
+
+		FilesType files;
+
 		try
 		{
-			recursiveCopy(input, output);
-			return true;
+			collect(input, output, files);
 		}
 		catch (...)
 		{
+			BLING_LOG_ERROR("CopyFolderService", "Could not list " << input << ": " << utils::logging::currentException());
 			return false;
 		}
+
+		std::atomic<std::size_t> next{0};
+		std::atomic<unsigned long long> bytes{0};
+		std::atomic<std::size_t> skipped{0};
+		std::atomic<bool> failed{false};
+		std::exception_ptr error;
+		std::mutex mutex;
+
+		auto work = [&]()
+		{
+			for (auto index = next++; index < files.size() && !failed; index = next++)
+			{
+				auto& file = files[index];
+
+				try
+				{
+					BLING_TRACE_SPAN("copy", "file");
+
+					if (alreadyCopied(file.first, file.second))
+					{
+						++skipped;
+						continue;
+					}
+
+					auto partial = file.second;
+					partial += ".partial";
+
+					copyFile(file.first, partial);
+
+					boost::filesystem::last_write_time(partial, boost::filesystem::last_write_time(file.first));
+					boost::filesystem::rename(partial, file.second);
+
+					bytes += boost::filesystem::file_size(file.second);
+					m_files.increment();
+				}
+				catch (...)
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+
+					if (!error)
+					{
+						error = std::current_exception();
+					}
+
+					failed = true;
+				}
+			}
+		};
+
+		std::size_t count = m_workers < files.size() ? m_workers : files.size();
+		std::vector<std::thread> workers;
+
+		for (std::size_t i = 1; i < count; ++i)
+		{
+			workers.emplace_back(work);
+		}
+
+		work();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		m_bytes.increment(bytes);
+		m_duration.observe(elapsed);
+
+		if (error)
+		{
+			try
+			{
+				std::rethrow_exception(error);
+			}
+			catch (...)
+			{
+				BLING_LOG_ERROR("CopyFolderService", "Could not copy " << input << " to " << output << ": " << utils::logging::currentException());
+			}
+
+			return false;
+		}
+
+		auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+
+		BLING_LOG_INFO("CopyFolderService", "Copied " << files.size() - skipped << " files (" << bytes / (1024 * 1024) << " MB) from " << input << " in "
+			<< seconds << "s with " << (count == 0 ? 1 : count) << " workers, " << (seconds > 0 ? bytes / 1048576.0 / seconds : 0) << " MB/s; "
+			<< skipped << " already there");
+
+		return true;
 	}
 }}}
\ No newline at end of file
@@ -1,14 +1,26 @@
 #pragma once
 
+#include "../../Utils/Metrics/Metrics.h"
+
 #include <string>
 
 namespace desktop { namespace core { namespace service {
+
+	// Copies a folder tree with a bounded set of worker threads. Each file is copied next to its
+	// target and renamed when complete, so a copy that stops half way can be run again and
+	// skips the files that are already there with the same size and time.
 	class CopyFolderService
 	{
 	public:
-		CopyFolderService();
+		// No workers means one per core, at most 8
+		explicit CopyFolderService(unsigned int workers = 0);
 		~CopyFolderService();
 
 		bool copy(const std::string& input, const std::string& output) const;
+	private:
+		unsigned int				m_workers;
+		utils::metrics::Counter&	m_files;
+		utils::metrics::Counter&	m_bytes;
+		utils::metrics::Histogram&	m_duration;
 	};
 }}}
\ No newline at end of file
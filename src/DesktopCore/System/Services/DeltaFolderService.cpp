@@ -0,0 +1,331 @@
+#include "DeltaFolderService.h"
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Tracing/Tracer.h"
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <openssl/evp.h>
+
+namespace desktop { namespace core { namespace service {
+
+	namespace
+	{
+		const unsigned int g_switchRetries = 10;
+		const std::chrono::milliseconds g_switchDelay(200);
+
+		std::string sha256(const boost::filesystem::path& path)
+		{
+			std::ifstream file(path.string(), std::ios::in | std::ios::binary);
+
+			if (!file.is_open())
+			{
+				throw std::runtime_error("cannot read " + path.string());
+			}
+
+			std::unique_ptr<EVP_MD_CTX, void(*)(EVP_MD_CTX*)> context(EVP_MD_CTX_create(), [](EVP_MD_CTX* c) { EVP_MD_CTX_destroy(c); });
+
+			EVP_DigestInit_ex(context.get(), EVP_sha256(), nullptr);
+
+			std::array<char, 65536> buffer;
+
+			while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+			{
+				EVP_DigestUpdate(context.get(), buffer.data(), static_cast<std::size_t>(file.gcount()));
+			}
+
+			unsigned char digest[EVP_MAX_MD_SIZE];
+			unsigned int length = 0;
+
+			EVP_DigestFinal_ex(context.get(), digest, &length);
+
+			std::stringstream ss;
+
+			for (unsigned int i = 0; i < length; ++i)
+			{
+				ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned int>(digest[i]);
+			}
+
+			return ss.str();
+		}
+
+		std::string relativePath(const boost::filesystem::path& root, const boost::filesystem::path& path)
+		{
+			auto full = path.generic_string();
+			auto prefix = root.generic_string();
+
+			return full.substr(prefix.size() + (*prefix.rbegin() == '/' ? 0 : 1));
+		}
+
+		// Hard links cost no data I/O; a copy is the fallback on volumes without them
+		void link(const boost::filesystem::path& from, const boost::filesystem::path& to)
+		{
+			boost::system::error_code ec;
+			boost::filesystem::create_hard_link(from, to, ec);
+
+			if (ec)
+			{
+				boost::filesystem::copy_file(from, to);
+			}
+		}
+
+		void move(const boost::filesystem::path& from, const boost::filesystem::path& to)
+		{
+			boost::system::error_code ec;
+			boost::filesystem::rename(from, to, ec);
+
+			if (ec)
+			{
+				boost::filesystem::copy_file(from, to);
+			}
+		}
+
+		std::string folderPath(const std::string& output)
+		{
+			boost::filesystem::path target(output);
+
+			// Output usually ends with a separator
+			while (target.filename() == ".")
+			{
+				target = target.parent_path();
+			}
+
+			return target.string();
+		}
+
+		std::int64_t modified(const boost::filesystem::path& path)
+		{
+			return static_cast<std::int64_t>(boost::filesystem::last_write_time(path));
+		}
+
+		// Windows refuses to rename a folder while a file inside is open, so the swap is retried
+		bool renameFolder(const boost::filesystem::path& from, const boost::filesystem::path& to)
+		{
+			for (unsigned int attempt = 0; attempt < g_switchRetries; ++attempt)
+			{
+				boost::system::error_code ec;
+				boost::filesystem::rename(from, to, ec);
+
+				if (!ec)
+				{
+					return true;
+				}
+
+				std::this_thread::sleep_for(g_switchDelay);
+			}
+
+			return false;
+		}
+	}
+
+	const char* DeltaFolderService::MANIFEST = ".manifest";
+
+	DeltaFolderService::DeltaFolderService() = default;
+	DeltaFolderService::~DeltaFolderService() = default;
+
+	DeltaFolderService::ManifestType DeltaFolderService::hash(const std::string& folder) const
+	{
+		BLING_TRACE_SPAN("upgrade", "hash");
+
+		ManifestType manifest;
+
+		boost::filesystem::path root(folder);
+
+		for (auto& item : boost::filesystem::recursive_directory_iterator(root))
+		{
+			if (boost::filesystem::is_regular_file(item.path()) && item.path().filename() != MANIFEST)
+			{
+				manifest[relativePath(root, item.path())] = std::make_pair(boost::filesystem::file_size(item.path()), sha256(item.path()));
+			}
+		}
+
+		return manifest;
+	}
+
+	DeltaFolderService::ManifestType DeltaFolderService::load(const std::string& folder) const
+	{
+		ManifestType manifest;
+
+		boost::filesystem::path root(folder);
+
+		if (!boost::filesystem::exists(root))
+		{
+			return manifest;
+		}
+
+		std::ifstream file((root / MANIFEST).string());
+
+		if (!file.is_open())
+		{
+			return hash(folder);
+		}
+
+		std::string line;
+
+		while (std::getline(file, line))
+		{
+			std::stringstream ss(line);
+			std::string digest, path;
+			std::uintmax_t size;
+			std::int64_t time;
+
+			// Lines of manifests written before the time was recorded never match and are hashed once
+			if (std::getline(ss, digest, '\t') && ss >> size && ss.get() == '\t' && ss >> time && ss.get() == '\t' && std::getline(ss, path))
+			{
+				boost::system::error_code sizeError, timeError;
+				auto actual = boost::filesystem::file_size(root / path, sizeError);
+				auto actualTime = static_cast<std::int64_t>(boost::filesystem::last_write_time(root / path, timeError));
+
+				if (!sizeError && !timeError)
+				{
+					manifest[path] = std::make_pair(actual, actual == size && actualTime == time ? digest : sha256(root / path));
+				}
+			}
+		}
+
+		// Files added since the manifest was written, and every file of an old format manifest
+		for (auto& item : boost::filesystem::recursive_directory_iterator(root))
+		{
+			if (boost::filesystem::is_regular_file(item.path()) && item.path().filename() != MANIFEST)
+			{
+				auto path = relativePath(root, item.path());
+
+				if (!manifest.count(path))
+				{
+					manifest[path] = std::make_pair(boost::filesystem::file_size(item.path()), sha256(item.path()));
+				}
+			}
+		}
+
+		return manifest;
+	}
+
+	bool DeltaFolderService::recover(const std::string& output) const
+	{
+		auto target = folderPath(output);
+		auto previous = target + ".old";
+
+		boost::system::error_code ec;
+
+		if (boost::filesystem::exists(target, ec))
+		{
+			return true;
+		}
+
+		if (!boost::filesystem::exists(previous, ec))
+		{
+			return false;
+		}
+
+		// Cut short between moving the folder away and moving the new version in
+		if (!renameFolder(previous, target))
+		{
+			BLING_LOG_ERROR("DeltaFolderService", "Could not restore " << target << " from " << previous);
+			return false;
+		}
+
+		BLING_LOG_WARNING("DeltaFolderService", "Restored " << target << " from an upgrade that did not finish");
+
+		return true;
+	}
+
+	bool DeltaFolderService::replace(const std::string& input, const std::string& output) const
+	{
+		BLING_TRACE_SPAN("upgrade", "replace");
+
+		boost::filesystem::path target(folderPath(output));
+
+		auto staging = target.string() + ".next";
+		auto previous = target.string() + ".old";
+
+		try
+		{
+			// The previous version may be the only one left
+			recover(target.string());
+
+			boost::filesystem::remove_all(staging);
+			boost::filesystem::remove_all(previous);
+
+			auto installed = load(target.string());
+			auto incoming = hash(input);
+
+			std::size_t reused = 0, changed = 0, dropped = 0;
+
+			std::stringstream manifest;
+
+			for (auto& entry : incoming)
+			{
+				auto destination = boost::filesystem::path(staging) / entry.first;
+
+				boost::filesystem::create_directories(destination.parent_path());
+
+				auto current = installed.find(entry.first);
+
+				if (current != installed.end() && current->second == entry.second)
+				{
+					link(target / entry.first, destination);
+					++reused;
+				}
+				else
+				{
+					move(boost::filesystem::path(input) / entry.first, destination);
+					++changed;
+				}
+
+				// A copy instead of a link or rename gets a new time
+				manifest << entry.second.second << "\t" << entry.second.first << "\t" << modified(destination) << "\t" << entry.first << "\n";
+			}
+
+			for (auto& entry : installed)
+			{
+				dropped += incoming.count(entry.first) == 0 ? 1 : 0;
+			}
+
+			{
+				std::ofstream file((boost::filesystem::path(staging) / MANIFEST).string(), std::ios::out | std::ios::trunc);
+				file << manifest.str();
+			}
+
+			if (boost::filesystem::exists(target) && !renameFolder(target, previous))
+			{
+				BLING_LOG_WARNING("DeltaFolderService", target.string() << " is in use, upgrade postponed");
+
+				boost::filesystem::remove_all(staging);
+				return false;
+			}
+
+			if (!renameFolder(staging, target))
+			{
+				// Put the old version back rather than leave nothing to serve
+				renameFolder(previous, target);
+
+				boost::filesystem::remove_all(staging);
+				return false;
+			}
+
+			boost::system::error_code ec;
+			boost::filesystem::remove_all(previous, ec);
+			boost::filesystem::remove_all(input, ec);
+
+			BLING_LOG_INFO("DeltaFolderService", "Replaced " << target.string() << ": " << changed << " files changed, " << reused << " reused, " << dropped << " dropped");
+
+			return true;
+		}
+		catch (...)
+		{
+			BLING_LOG_ERROR("DeltaFolderService", "Could not replace " << target.string() << ": " << utils::logging::currentException());
+
+			boost::system::error_code ec;
+			boost::filesystem::remove_all(staging, ec);
+
+			return false;
+		}
+	}
+}}}
\ No newline at end of file
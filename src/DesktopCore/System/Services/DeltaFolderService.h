@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace desktop { namespace core { namespace service {
+
+	// Replaces a folder with a new version doing I/O only for what changed. The new version is
+	// assembled next to the folder, hard linking unchanged files and moving changed ones from
+	// input, and swapped in with two renames so the folder is never served half-written. Between
+	// the renames the folder is missing and the previous version waits next to it as <folder>.old;
+	// recover() moves it back after a crash there. The hashes are kept in a manifest inside the
+	// folder with the size and modification time of each file, so installed files are not read again.
+	class DeltaFolderService
+	{
+	public:
+		// Relative path to size and SHA-256
+		typedef std::map<std::string, std::pair<std::uintmax_t, std::string>> ManifestType;
+
+		static const char* MANIFEST;
+
+		DeltaFolderService();
+		~DeltaFolderService();
+
+		bool replace(const std::string& input, const std::string& output) const;
+		// Puts the previous version back when a replace was cut short after the folder was moved
+		// away; true when output exists afterwards
+		bool recover(const std::string& output) const;
+
+		ManifestType hash(const std::string& folder) const;
+		// Hashes again the files the manifest of folder misses or has a different size or time for
+		ManifestType load(const std::string& folder) const;
+	};
+}}}
\ No newline at end of file
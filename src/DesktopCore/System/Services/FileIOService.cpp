@@ -33,7 +33,7 @@ namespace desktop { namespace core { namespace service {
 			f << content;
 			f.close();
 
-			return true;
+			return !f.fail();
 		}
 		catch (...)
 		{
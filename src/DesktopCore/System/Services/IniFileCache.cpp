@@ -0,0 +1,371 @@
+#include "IniFileCache.h"
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Tracing/Tracer.h"
+
+#include <sstream>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+
+namespace desktop { namespace core { namespace service {
+
+	namespace
+	{
+		const std::chrono::milliseconds g_checkInterval(1000);
+		const std::chrono::milliseconds g_flushDelay(500);
+
+		bool stat(const std::string& path, std::time_t& mtime, std::uintmax_t& size)
+		{
+			boost::system::error_code ec;
+
+			mtime = boost::filesystem::last_write_time(path, ec);
+
+			if (ec)
+			{
+				return false;
+			}
+
+			size = boost::filesystem::file_size(path, ec);
+
+			return !ec;
+		}
+	}
+
+	IniFileCache& IniFileCache::get()
+	{
+		static IniFileCache S;
+		return S;
+	}
+
+	IniFileCache::IniFileCache(std::unique_ptr<FileIOService> fileIOService)
+	: m_fileIOService(std::move(fileIOService))
+	{
+		m_writer = std::thread(&IniFileCache::run, this);
+	}
+
+	IniFileCache::~IniFileCache()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_cv.notify_one();
+		m_writer.join();
+
+		flush();
+	}
+
+	bool IniFileCache::find(const std::string& path, const std::string& key, std::string& value)
+	{
+		BLING_TRACE_SPAN("ini", "read");
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto& entry = refresh(path);
+
+		auto it = entry.m_values.find(key);
+
+		if (it != entry.m_values.end())
+		{
+			value = it->second;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool IniFileCache::store(const std::string& path, const std::string& key, const std::string& value)
+	{
+		BLING_TRACE_SPAN("ini", "write");
+
+		bool saved;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			auto& entry = refresh(path);
+
+			entry.m_pending[key] = value;
+			entry.m_tree.put(key, value);
+			entry.m_values[key] = value;
+
+			saved = !entry.m_failed;
+
+			m_dirty = true;
+		}
+
+		m_cv.notify_one();
+
+		return saved;
+	}
+
+	bool IniFileCache::flush()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		return flushDirty(lock);
+	}
+
+	IniFileCache::Entry& IniFileCache::refresh(const std::string& path)
+	{
+		auto& entry = m_entries[path];
+
+		auto now = std::chrono::steady_clock::now();
+
+		if (entry.m_checked == std::chrono::steady_clock::time_point() || now - entry.m_checked >= g_checkInterval)
+		{
+			std::time_t mtime = 0;
+			std::uintmax_t size = 0;
+
+			bool exists = stat(path, mtime, size);
+
+			if (entry.m_checked == std::chrono::steady_clock::time_point() || exists != entry.m_exists || mtime != entry.m_mtime || size != entry.m_size)
+			{
+				entry.m_exists = exists;
+				entry.m_mtime = mtime;
+				entry.m_size = size;
+				++entry.m_version;
+
+				reload(path, entry);
+			}
+
+			entry.m_checked = now;
+		}
+
+		return entry;
+	}
+
+	void IniFileCache::reload(const std::string& path, Entry& entry)
+	{
+		BLING_TRACE_SPAN("ini", "load");
+
+		entry.m_tree.clear();
+		entry.m_values.clear();
+
+		std::stringstream iss;
+
+		if (entry.m_exists && m_fileIOService->load(path, iss))
+		{
+			try
+			{
+				boost::property_tree::ini_parser::read_ini(iss, entry.m_tree);
+			}
+			catch (...)
+			{
+				entry.m_tree.clear();
+			}
+		}
+
+		for (auto& pending : entry.m_pending)
+		{
+			entry.m_tree.put(pending.first, pending.second);
+		}
+
+		for (auto& section : entry.m_tree)
+		{
+			if (section.second.empty())
+			{
+				entry.m_values[section.first] = section.second.data();
+			}
+
+			for (auto& value : section.second)
+			{
+				entry.m_values[section.first + "." + value.first] = value.second.data();
+			}
+		}
+	}
+
+	unsigned int IniFileCache::watch(const std::string& path, WatchCallbackType cb)
+	{
+		unsigned int version;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			version = refresh(path).m_version;
+		}
+
+		std::unique_lock<std::recursive_mutex> lock(m_watchMutex);
+
+		m_watchers[++m_nextWatch] = std::make_pair(path, cb);
+		m_watchedVersions.insert(std::make_pair(path, version));
+
+		return m_nextWatch;
+	}
+
+	void IniFileCache::unwatch(unsigned int id)
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_watchMutex);
+
+		m_watchers.erase(id);
+	}
+
+	void IniFileCache::run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (!m_stop)
+		{
+			m_cv.wait_for(lock, g_checkInterval, [this]() { return m_dirty || m_stop; });
+
+			if (!m_stop && m_dirty)
+			{
+				m_cv.wait_for(lock, g_flushDelay, [this]() { return m_stop; });
+
+				if (!flushDirty(lock))
+				{
+					// Pending writes stay dirty; try again later instead of on every pass
+					m_cv.wait_for(lock, g_checkInterval, [this]() { return m_stop; });
+				}
+			}
+
+			if (!m_stop)
+			{
+				lock.unlock();
+				notifyWatchers();
+				lock.lock();
+			}
+		}
+	}
+
+	void IniFileCache::notifyWatchers()
+	{
+		std::unique_lock<std::recursive_mutex> watchLock(m_watchMutex);
+
+		std::vector<std::string> changed;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			for (auto& watched : m_watchedVersions)
+			{
+				auto version = refresh(watched.first).m_version;
+
+				if (version != watched.second)
+				{
+					watched.second = version;
+					changed.push_back(watched.first);
+				}
+			}
+		}
+
+		for (auto& path : changed)
+		{
+			auto watchers = m_watchers;
+
+			for (auto& watcher : watchers)
+			{
+				if (watcher.second.first == path && m_watchers.count(watcher.first))
+				{
+					watcher.second.second();
+				}
+			}
+		}
+	}
+
+	bool IniFileCache::flushDirty(std::unique_lock<std::mutex>& lock)
+	{
+		struct File
+		{
+			std::string							m_path;
+			std::string							m_content;
+			std::map<std::string, std::string>	m_written;
+			bool								m_saved;
+		};
+
+		std::vector<File> files;
+
+		for (auto& item : m_entries)
+		{
+			auto& entry = item.second;
+
+			if (!entry.m_pending.empty())
+			{
+				std::ostringstream oss;
+				boost::property_tree::ini_parser::write_ini(oss, entry.m_tree);
+
+				files.push_back({item.first, oss.str(), entry.m_pending, false});
+			}
+		}
+
+		m_dirty = false;
+
+		if (files.empty())
+		{
+			return true;
+		}
+
+		lock.unlock();
+
+		BLING_TRACE_SPAN("ini", "flush");
+
+		for (auto& file : files)
+		{
+			auto temporary = file.m_path + ".tmp";
+
+			if (m_fileIOService->save(temporary, file.m_content))
+			{
+				boost::system::error_code ec;
+				boost::filesystem::rename(temporary, file.m_path, ec);
+
+				file.m_saved = !ec;
+
+				if (ec)
+				{
+					boost::filesystem::remove(temporary, ec);
+				}
+			}
+		}
+
+		lock.lock();
+
+		bool saved = true;
+
+		for (auto& file : files)
+		{
+			auto& entry = m_entries[file.m_path];
+
+			if (file.m_saved)
+			{
+				// Only what was written; keys stored again while the file was saved stay pending
+				for (auto& written : file.m_written)
+				{
+					auto it = entry.m_pending.find(written.first);
+
+					if (it != entry.m_pending.end() && it->second == written.second)
+					{
+						entry.m_pending.erase(it);
+					}
+				}
+
+				if (entry.m_failed)
+				{
+					BLING_LOG_INFO("IniFileCache", "Saved " << file.m_path << " again");
+				}
+
+				entry.m_failed = false;
+			}
+			else
+			{
+				if (!entry.m_failed)
+				{
+					BLING_LOG_ERROR("IniFileCache", "Could not save " << file.m_path << ", " << file.m_written.size() << " values are kept in memory until it can be saved");
+				}
+
+				entry.m_failed = true;
+				saved = false;
+			}
+
+			if (!entry.m_pending.empty())
+			{
+				m_dirty = true;
+			}
+
+			entry.m_exists = stat(file.m_path, entry.m_mtime, entry.m_size);
+			entry.m_checked = std::chrono::steady_clock::now();
+		}
+
+		return saved;
+	}
+}}}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "FileIOService.h"
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include <unordered_map>
+#include <boost/property_tree/ptree.hpp>
+
+namespace desktop { namespace core { namespace service {
+
+	// Process-wide store of parsed INI files. Reads are served from memory and only
+	// go back to disk when the file mtime or size changes; writes are applied to memory
+	// and flushed by a background thread in batches, replacing the file atomically.
+	class IniFileCache
+	{
+	public:
+		typedef std::function<void()> WatchCallbackType;
+
+		static IniFileCache& get();
+
+		template<typename T>
+		T read(const std::string& path, const std::string& key, const T& defaultValue)
+		{
+			std::string raw;
+
+			if (find(path, key, raw))
+			{
+				typename boost::property_tree::translator_between<std::string, T>::type translator;
+
+				auto value = translator.get_value(raw);
+
+				if (value)
+				{
+					return *value;
+				}
+			}
+
+			return defaultValue;
+		}
+
+		// The value is read back at once and saved by the writer thread. Returns false when it
+		// cannot be converted, or when the last save of the file failed; the value is then kept
+		// in memory and saved again until it succeeds.
+		template<typename T>
+		bool write(const std::string& path, const std::string& key, const T& value)
+		{
+			typename boost::property_tree::translator_between<std::string, T>::type translator;
+
+			auto raw = translator.put_value(value);
+
+			if (raw)
+			{
+				return store(path, key, *raw);
+			}
+
+			return false;
+		}
+
+		// Saves every pending write now; false when a file could not be replaced
+		bool flush();
+
+		unsigned int watch(const std::string& path, WatchCallbackType cb);
+		void unwatch(unsigned int id);
+	private:
+		struct Entry
+		{
+			boost::property_tree::ptree						m_tree;
+			std::unordered_map<std::string, std::string>	m_values;
+			std::map<std::string, std::string>				m_pending;
+			std::time_t										m_mtime = 0;
+			std::uintmax_t									m_size = 0;
+			std::chrono::steady_clock::time_point			m_checked;
+			bool											m_exists = false;
+			bool											m_failed = false;
+			unsigned int									m_version = 0;
+		};
+
+		IniFileCache(std::unique_ptr<FileIOService> fileIOService = std::make_unique<FileIOService>());
+		~IniFileCache();
+		IniFileCache(const IniFileCache&) = delete;
+		IniFileCache& operator=(const IniFileCache&) = delete;
+
+		bool find(const std::string& path, const std::string& key, std::string& value);
+		bool store(const std::string& path, const std::string& key, const std::string& value);
+
+		Entry& refresh(const std::string& path);
+		void reload(const std::string& path, Entry& entry);
+		void run();
+		bool flushDirty(std::unique_lock<std::mutex>& lock);
+		void notifyWatchers();
+	private:
+		std::unique_ptr<FileIOService>					m_fileIOService;
+		std::unordered_map<std::string, Entry>			m_entries;
+		std::mutex										m_mutex;
+		std::condition_variable							m_cv;
+		std::thread										m_writer;
+		bool											m_dirty = false;
+		bool											m_stop = false;
+
+		std::map<unsigned int, std::pair<std::string, WatchCallbackType>>	m_watchers;
+		std::map<std::string, unsigned int>			m_watchedVersions;
+		std::recursive_mutex							m_watchMutex;
+		unsigned int									m_nextWatch = 0;
+	};
+}}}
\ No newline at end of file
@@ -2,8 +2,8 @@
 
 namespace desktop { namespace core { namespace service {
 
-	IniFileService::IniFileService(std::unique_ptr<service::FileIOService> fileIOService)
-	: m_fileIOService(std::move(fileIOService))
+	IniFileService::IniFileService(IniFileCache& cache)
+	: m_cache(cache)
 	{
 		
 	}
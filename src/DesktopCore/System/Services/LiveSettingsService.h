@@ -0,0 +1,61 @@
+#pragma once
+
+#include "IniFileCache.h"
+#include "../../Utils/Logging/Logger.h"
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+namespace desktop { namespace core { namespace service {
+
+	// Holds an immutable snapshot of typed settings built by the loader. The snapshot is
+	// rebuilt and swapped atomically whenever the watched INI file changes on disk.
+	template<typename T>
+	class LiveSettingsService
+	{
+	public:
+		typedef std::function<T()> LoaderType;
+
+		LiveSettingsService(const std::string& path, LoaderType loader, IniFileCache& cache = IniFileCache::get())
+		: m_loader(loader)
+		, m_cache(cache)
+		{
+			reload();
+
+			m_watch = m_cache.watch(path, [this]()
+			{
+				try
+				{
+					reload();
+				}
+				catch (...)
+				{
+					BLING_LOG_ERROR("LiveSettingsService", "Settings were not reloaded: " << utils::logging::currentException());
+				}
+			});
+		}
+
+		~LiveSettingsService()
+		{
+			m_cache.unwatch(m_watch);
+		}
+
+		std::shared_ptr<const T> get() const
+		{
+			return std::atomic_load(&m_snapshot);
+		}
+	private:
+		void reload()
+		{
+			std::shared_ptr<const T> snapshot = std::make_shared<const T>(m_loader());
+			std::atomic_store(&m_snapshot, snapshot);
+		}
+	private:
+		LoaderType				m_loader;
+		IniFileCache&			m_cache;
+		unsigned int			m_watch;
+		std::shared_ptr<const T> m_snapshot;
+	};
+}}}
\ No newline at end of file
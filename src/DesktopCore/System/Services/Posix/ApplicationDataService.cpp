@@ -0,0 +1,77 @@
+#include "../ApplicationDataService.h"
+
+#include <boost/filesystem.hpp>
+#include <cstdlib>
+
+namespace desktop { namespace core { namespace service {
+
+	namespace
+	{
+		boost::filesystem::path getExecutable()
+		{
+			boost::system::error_code error;
+			auto path = boost::filesystem::read_symlink("/proc/self/exe", error);
+
+			return error ? boost::filesystem::path() : path;
+		}
+	}
+
+	ApplicationDataService::ApplicationDataService() = default;
+	ApplicationDataService::~ApplicationDataService() = default;
+
+	// BLING_HOME, then $XDG_DATA_HOME/<name>/, then ~/.local/share/<name>/, so the same
+	// Bling.ini, Blink.ini and Download layout as on Windows lives in one folder
+	std::string ApplicationDataService::getMyDocuments() const
+	{
+		static const std::string documents = [this]()
+		{
+			if (auto home = std::getenv("BLING_HOME"))
+			{
+				auto folder = std::string(home);
+				return folder.empty() || *folder.rbegin() == '/' ? folder : folder + "/";
+			}
+
+			boost::filesystem::path base;
+
+			if (auto data = std::getenv("XDG_DATA_HOME"))
+			{
+				base = data;
+			}
+			else if (auto home = std::getenv("HOME"))
+			{
+				base = boost::filesystem::path(home) / ".local" / "share";
+			}
+			else
+			{
+				return std::string();
+			}
+
+			return (base / getApplicationName()).string() + "/";
+		}();
+
+		return documents;
+	}
+
+	std::string ApplicationDataService::getApplicationFolder() const
+	{
+		return getExecutable().parent_path().string();
+	}
+
+	std::string ApplicationDataService::getViewerFolder() const
+	{
+		auto path = boost::filesystem::path(getMyDocuments()) / "Html" / "viewer";
+
+		return path.string();
+	}
+
+	std::string ApplicationDataService::getApplicationName() const
+	{
+		return getExecutable().filename().string();
+	}
+
+	std::string ApplicationDataService::getApplicationVersion() const
+	{
+		// No version resource on Linux
+		return "xxx";
+	}
+}}}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "../SecretFileService.h"
+
+#include "Utils/Logging/Logger.h"
+
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace desktop { namespace core { namespace service {
+
+	namespace
+	{
+		const std::size_t g_secretBytes = 32;
+
+		bool create(const std::string& path)
+		{
+			std::array<unsigned char, g_secretBytes> bytes;
+
+			int random = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+
+			if (random < 0 || ::read(random, bytes.data(), bytes.size()) != static_cast<ssize_t>(bytes.size()))
+			{
+				if (random >= 0)
+				{
+					::close(random);
+				}
+
+				return false;
+			}
+
+			::close(random);
+
+			std::stringstream hex;
+
+			for (auto byte : bytes)
+			{
+				hex << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned int>(byte);
+			}
+
+			auto secret = hex.str();
+
+			// O_EXCL: a file created by someone else in the meantime is not taken over
+			int file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+			if (file < 0)
+			{
+				return errno == EEXIST;
+			}
+
+			bool written = ::write(file, secret.data(), secret.size()) == static_cast<ssize_t>(secret.size());
+
+			::close(file);
+
+			return written;
+		}
+	}
+
+	SecretFileService::SecretFileService() = default;
+	SecretFileService::~SecretFileService() = default;
+
+	bool SecretFileService::read(const std::string& path, std::string& secret) const
+	{
+		int file = ::open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+
+		if (file < 0 && errno == ENOENT)
+		{
+			if (!create(path))
+			{
+				BLING_LOG_ERROR("SecretFileService", "Could not create " << path);
+				return false;
+			}
+
+			file = ::open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+		}
+
+		if (file < 0)
+		{
+			BLING_LOG_ERROR("SecretFileService", "Could not open " << path);
+			return false;
+		}
+
+		struct stat info;
+
+		if (::fstat(file, &info) != 0 || !S_ISREG(info.st_mode) || info.st_uid != ::geteuid() || (info.st_mode & (S_IRWXG | S_IRWXO)) != 0)
+		{
+			::close(file);
+
+			BLING_LOG_ERROR("SecretFileService", path << " must be a file only its owner can read, chmod 600 it");
+			return false;
+		}
+
+		std::array<char, 256> buffer;
+		ssize_t size;
+
+		secret.clear();
+
+		while ((size = ::read(file, buffer.data(), buffer.size())) > 0)
+		{
+			secret.append(buffer.data(), static_cast<std::size_t>(size));
+		}
+
+		::close(file);
+
+		while (!secret.empty() && std::isspace(static_cast<unsigned char>(secret.back())))
+		{
+			secret.pop_back();
+		}
+
+		return size == 0 && !secret.empty();
+	}
+}}}
\ No newline at end of file
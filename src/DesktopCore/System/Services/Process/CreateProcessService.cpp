@@ -1,12 +1,62 @@
 #include "CreateProcessService.h"
 
-#include "System\Model\ProcessInformation.h"
-#include "System\Model\ExecutableFile.h"
+#include "System/Model/ProcessInformation.h"
+#include "System/Model/ExecutableFile.h"
 
 #include <windows.h>
 
 namespace desktop { namespace core { namespace service { namespace system {
 
+	namespace
+	{
+		// Quotes an argument so CommandLineToArgvW, which the C runtime of the child follows, gives it back unchanged
+		void appendArgument(std::string& commandLine, const std::string& argument)
+		{
+			if (!commandLine.empty())
+			{
+				commandLine += ' ';
+			}
+
+			if (!argument.empty() && argument.find_first_of(" \t\n\v\"") == std::string::npos)
+			{
+				commandLine += argument;
+				return;
+			}
+
+			commandLine += '"';
+
+			for (auto it = argument.begin(); ; ++it)
+			{
+				size_t backslashes = 0;
+
+				while (it != argument.end() && *it == '\\')
+				{
+					++it;
+					++backslashes;
+				}
+
+				if (it == argument.end())
+				{
+					// Doubled so the closing quote is not escaped
+					commandLine.append(backslashes * 2, '\\');
+					break;
+				}
+				else if (*it == '"')
+				{
+					commandLine.append(backslashes * 2 + 1, '\\');
+					commandLine += '"';
+				}
+				else
+				{
+					commandLine.append(backslashes, '\\');
+					commandLine += *it;
+				}
+			}
+
+			commandLine += '"';
+		}
+	}
+
 	std::unique_ptr<model::system::ProcessInformation> CreateProcessService::create(const model::system::ExecutableFile& file, const std::string& currentDirectory) const
 	{
 		PROCESS_INFORMATION processInfo;
@@ -18,7 +68,13 @@ namespace desktop { namespace core { namespace service { namespace system {
 		startUpInfo.dwFlags = STARTF_USESHOWWINDOW;
 		startUpInfo.wShowWindow = SW_HIDE;
 
-		std::string path = file.m_path.get().string() + " " + file.m_arguments.get();
+		std::string path;
+		appendArgument(path, file.m_path.get().string());
+
+		for (auto& argument : file.m_arguments.get())
+		{
+			appendArgument(path, argument);
+		}
 
 		if (!CreateProcess(NULL, (char*)path.c_str(), NULL, NULL, FALSE, CREATE_NEW_CONSOLE | CREATE_NEW_PROCESS_GROUP, NULL, currentDirectory.c_str(), &startUpInfo, &processInfo))
 		{
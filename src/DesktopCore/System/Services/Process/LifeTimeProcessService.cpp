@@ -1,6 +1,6 @@
 #include "LifeTimeProcessService.h"
 
-#include "System\Model\ProcessInformation.h"
+#include "System/Model/ProcessInformation.h"
 
 #include <windows.h>
 #include <fstream>
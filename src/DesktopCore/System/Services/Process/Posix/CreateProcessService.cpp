@@ -0,0 +1,61 @@
+#include "../CreateProcessService.h"
+
+#include "System/Model/ProcessInformation.h"
+#include "System/Model/ExecutableFile.h"
+
+#include <cerrno>
+#include <csignal>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace desktop { namespace core { namespace service { namespace system {
+
+	std::unique_ptr<model::system::ProcessInformation> CreateProcessService::create(const model::system::ExecutableFile& file, const std::string& currentDirectory) const
+	{
+		std::string path = file.m_path.get().string();
+
+		// Built before fork, the child only calls async-signal-safe functions
+		std::vector<char*> argv;
+		argv.push_back(const_cast<char*>(path.c_str()));
+
+		for (auto& argument : file.m_arguments.get())
+		{
+			argv.push_back(const_cast<char*>(argument.c_str()));
+		}
+
+		argv.push_back(nullptr);
+
+		pid_t pid = fork();
+
+		if (pid == 0)
+		{
+			// Own process group, like CREATE_NEW_PROCESS_GROUP, so our signals do not reach it
+			setpgid(0, 0);
+
+			// exec keeps the mask and ignored signals; the daemon blocks SIGINT and SIGTERM for its
+			// sigwait, which would leave ffmpeg deaf to TerminateProcessService::sigint
+			sigset_t signals;
+			sigemptyset(&signals);
+			sigaddset(&signals, SIGINT);
+			sigaddset(&signals, SIGTERM);
+			pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+
+			signal(SIGCHLD, SIG_DFL);
+
+			if (chdir(currentDirectory.c_str()) == 0)
+			{
+				// No shell, so nothing in the arguments is ever interpreted; a bare name is looked up on the PATH
+				execvp(argv[0], argv.data());
+			}
+
+			_exit(127);
+		}
+		else if (pid < 0)
+		{
+			throw CreateProcessServiceException() << CreateProcessServiceException::pathInfo(path) << CreateProcessServiceException::errorCodeInfo(errno);
+		}
+
+		return std::make_unique<model::system::ProcessInformation>(static_cast<unsigned long>(pid));
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "../LifeTimeProcessService.h"
+
+#include "System/Model/ProcessInformation.h"
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+namespace desktop { namespace core { namespace service { namespace system {
+
+	bool LifeTimeProcessService::isAlive(model::system::ProcessInformation& processInfo) const
+	{
+		auto pid = static_cast<pid_t>(processInfo.m_processID);
+
+		// Reaps the child if it already exited, so it does not linger as a zombie
+		int status = 0;
+		if (waitpid(pid, &status, WNOHANG) == pid)
+		{
+			return false;
+		}
+
+		return kill(pid, 0) == 0;
+	}
+}}}}
\ No newline at end of file
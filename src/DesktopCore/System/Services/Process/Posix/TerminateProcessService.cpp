@@ -0,0 +1,20 @@
+#include "../TerminateProcessService.h"
+
+#include "System/Model/ProcessInformation.h"
+
+#include <signal.h>
+#include <sys/types.h>
+
+namespace desktop { namespace core { namespace service { namespace system {
+
+	bool TerminateProcessService::terminate(const model::system::ProcessInformation& processInfo) const
+	{
+		return kill(static_cast<pid_t>(processInfo.m_processID), SIGKILL) == 0;
+	}
+
+	bool TerminateProcessService::sigint(const model::system::ProcessInformation& processInfo) const
+	{
+		// Lets ffmpeg finish the file it is writing, as taskkill does on Windows
+		return kill(static_cast<pid_t>(processInfo.m_processID), SIGINT) == 0;
+	}
+}}}}
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "TerminateProcessService.h"
 
-#include "System\Model\ProcessInformation.h"
+#include "System/Model/ProcessInformation.h"
 
 #include <windows.h>
 #include <tlhelp32.h>
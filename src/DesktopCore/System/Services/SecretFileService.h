@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+namespace desktop { namespace core { namespace service {
+
+	// Secret that local clients prove they may act for the user with, kept in a file only the
+	// owner of the process can read. Only implemented for the daemon, see Posix/.
+	class SecretFileService
+	{
+	public:
+		SecretFileService();
+		~SecretFileService();
+
+		// Creates the file with a random secret when it is missing. Fails when the file is not
+		// a regular file of the current user or anyone else may read or write it.
+		bool read(const std::string& path, std::string& secret) const;
+	};
+}}}
\ No newline at end of file
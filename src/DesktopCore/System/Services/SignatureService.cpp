@@ -0,0 +1,103 @@
+#include "SignatureService.h"
+
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+namespace desktop { namespace core { namespace service {
+
+	namespace
+	{
+		typedef std::unique_ptr<EVP_MD_CTX, void(*)(EVP_MD_CTX*)> ContextType;
+
+		ContextType createContext()
+		{
+			return ContextType(EVP_MD_CTX_create(), [](EVP_MD_CTX* c) { EVP_MD_CTX_destroy(c); });
+		}
+
+		std::string toHex(const unsigned char* digest, unsigned int length)
+		{
+			std::stringstream ss;
+
+			for (unsigned int i = 0; i < length; ++i)
+			{
+				ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned int>(digest[i]);
+			}
+
+			return ss.str();
+		}
+
+		std::string finish(EVP_MD_CTX* context)
+		{
+			unsigned char digest[EVP_MAX_MD_SIZE];
+			unsigned int length = 0;
+
+			EVP_DigestFinal_ex(context, digest, &length);
+
+			return toHex(digest, length);
+		}
+	}
+
+	SignatureService::SignatureService() = default;
+	SignatureService::~SignatureService() = default;
+
+	std::string SignatureService::sha256(const std::string& data) const
+	{
+		auto context = createContext();
+
+		EVP_DigestInit_ex(context.get(), EVP_sha256(), nullptr);
+		EVP_DigestUpdate(context.get(), data.data(), data.size());
+
+		return finish(context.get());
+	}
+
+	std::string SignatureService::sha256File(const std::string& path) const
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+
+		if (!file.is_open())
+		{
+			return "";
+		}
+
+		auto context = createContext();
+
+		EVP_DigestInit_ex(context.get(), EVP_sha256(), nullptr);
+
+		std::array<char, 65536> buffer;
+
+		while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+		{
+			EVP_DigestUpdate(context.get(), buffer.data(), static_cast<std::size_t>(file.gcount()));
+		}
+
+		return finish(context.get());
+	}
+
+	bool SignatureService::verify(const std::string& publicKey, const std::string& data, const std::string& signature) const
+	{
+		std::unique_ptr<BIO, int(*)(BIO*)> bio(BIO_new_mem_buf(publicKey.data(), static_cast<int>(publicKey.size())), BIO_free);
+
+		if (!bio)
+		{
+			return false;
+		}
+
+		std::unique_ptr<EVP_PKEY, void(*)(EVP_PKEY*)> key(PEM_read_bio_PUBKEY(bio.get(), nullptr, nullptr, nullptr), EVP_PKEY_free);
+
+		if (!key)
+		{
+			return false;
+		}
+
+		auto context = createContext();
+
+		return EVP_DigestVerifyInit(context.get(), nullptr, EVP_sha256(), nullptr, key.get()) == 1 &&
+			   EVP_DigestVerifyUpdate(context.get(), data.data(), data.size()) == 1 &&
+			   EVP_DigestVerifyFinal(context.get(), reinterpret_cast<const unsigned char*>(signature.data()), signature.size()) == 1;
+	}
+}}}
\ No newline at end of file
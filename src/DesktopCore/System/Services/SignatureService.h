@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+namespace desktop { namespace core { namespace service {
+
+	// SHA-256 digests and signature checks for downloaded releases
+	class SignatureService
+	{
+	public:
+		SignatureService();
+		~SignatureService();
+
+		// Lowercase hex
+		std::string sha256(const std::string& data) const;
+		std::string sha256File(const std::string& path) const;
+
+		// signature is the raw output of openssl dgst -sha256 -sign with the private half of publicKey (PEM, RSA or EC)
+		bool verify(const std::string& publicKey, const std::string& data, const std::string& signature) const;
+	};
+}}}
\ No newline at end of file
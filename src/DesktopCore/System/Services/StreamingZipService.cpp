@@ -0,0 +1,798 @@
+#include "StreamingZipService.h"
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Tracing/Tracer.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+namespace desktop { namespace core { namespace service {
+
+	namespace
+	{
+		// Bytes the download may run ahead of the extraction
+		const std::size_t g_pipeLimit = 4 * 1024 * 1024;
+
+		const std::uint32_t g_localHeader = 0x04034b50;
+		const std::uint32_t g_centralHeader = 0x02014b50;
+		const std::uint32_t g_endOfCentralDirectory = 0x06054b50;
+		const std::uint32_t g_dataDescriptor = 0x08074b50;
+
+		class Pipe
+		{
+		public:
+			bool push(const char* data, std::size_t size)
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				m_cv.wait(lock, [this]() { return m_size < g_pipeLimit || m_failed || m_discarding; });
+
+				if (m_failed)
+				{
+					return false;
+				}
+
+				if (m_discarding)
+				{
+					return true;
+				}
+
+				m_chunks.emplace_back(data, size);
+				m_size += size;
+
+				m_cv.notify_all();
+
+				return true;
+			}
+
+			// Returns 0 once the writer closed the pipe and everything was read
+			std::size_t pull(char* data, std::size_t size)
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				m_cv.wait(lock, [this]() { return !m_chunks.empty() || m_closed || m_failed; });
+
+				if (m_failed || m_chunks.empty())
+				{
+					return 0;
+				}
+
+				auto& chunk = m_chunks.front();
+				auto count = chunk.size() - m_offset < size ? chunk.size() - m_offset : size;
+
+				std::memcpy(data, chunk.data() + m_offset, count);
+
+				m_offset += count;
+				m_size -= count;
+
+				if (m_offset == chunk.size())
+				{
+					m_chunks.pop_front();
+					m_offset = 0;
+				}
+
+				m_cv.notify_all();
+
+				return count;
+			}
+
+			void close()
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				m_closed = true;
+				m_cv.notify_all();
+			}
+
+			// The reader is done; whatever is still written is accepted and dropped
+			void discard()
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				m_discarding = true;
+				m_chunks.clear();
+				m_size = 0;
+				m_offset = 0;
+				m_cv.notify_all();
+			}
+
+			void fail()
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				m_failed = true;
+				m_cv.notify_all();
+			}
+		private:
+			std::mutex				m_mutex;
+			std::condition_variable	m_cv;
+			std::deque<std::string>	m_chunks;
+			std::size_t				m_offset = 0;
+			std::size_t				m_size = 0;
+			bool					m_closed = false;
+			bool					m_failed = false;
+			bool					m_discarding = false;
+		};
+
+		class Source
+		{
+		public:
+			explicit Source(Pipe& pipe) : m_pipe(pipe) {}
+
+			unsigned char byte()
+			{
+				if (m_position == m_available)
+				{
+					m_available = m_pipe.pull(m_buffer.data(), m_buffer.size());
+					m_position = 0;
+
+					if (m_available == 0)
+					{
+						throw std::runtime_error("archive ends unexpectedly");
+					}
+				}
+
+				return static_cast<unsigned char>(m_buffer[m_position++]);
+			}
+
+			std::uint16_t u16()
+			{
+				std::uint16_t value = byte();
+				return static_cast<std::uint16_t>(value | (byte() << 8));
+			}
+
+			std::uint32_t u32()
+			{
+				std::uint32_t value = u16();
+				return value | (static_cast<std::uint32_t>(u16()) << 16);
+			}
+
+			template<typename F>
+			void read(std::size_t size, F&& f)
+			{
+				while (size > 0)
+				{
+					if (m_position == m_available)
+					{
+						byte();
+						--m_position;
+					}
+
+					auto count = m_available - m_position < size ? m_available - m_position : size;
+
+					f(m_buffer.data() + m_position, count);
+
+					m_position += count;
+					size -= count;
+				}
+			}
+		private:
+			Pipe&						m_pipe;
+			std::array<char, 65536>		m_buffer;
+			std::size_t					m_position = 0;
+			std::size_t					m_available = 0;
+		};
+
+		class Crc32
+		{
+		public:
+			void update(const char* data, std::size_t size)
+			{
+				static const auto table = makeTable();
+
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					m_value = table[(m_value ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (m_value >> 8);
+				}
+			}
+
+			std::uint32_t value() const
+			{
+				return m_value ^ 0xffffffff;
+			}
+		private:
+			static std::array<std::uint32_t, 256> makeTable()
+			{
+				std::array<std::uint32_t, 256> table;
+
+				for (std::uint32_t i = 0; i < 256; ++i)
+				{
+					std::uint32_t c = i;
+
+					for (int k = 0; k < 8; ++k)
+					{
+						c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+					}
+
+					table[i] = c;
+				}
+
+				return table;
+			}
+		private:
+			std::uint32_t	m_value = 0xffffffff;
+		};
+
+		// Output of an entry: written to disk in blocks while its CRC and size are computed
+		class Output
+		{
+		public:
+			// Only checks the data, for entries that have no file
+			Output() = default;
+
+			explicit Output(const boost::filesystem::path& path)
+			: m_file(path.string(), std::ios::out | std::ios::binary | std::ios::trunc)
+			{
+				if (!m_file.is_open())
+				{
+					throw std::runtime_error("cannot write " + path.string());
+				}
+			}
+
+			void write(const char* data, std::size_t size)
+			{
+				m_crc.update(data, size);
+				m_size += size;
+
+				if (m_file.is_open() && !m_file.write(data, size))
+				{
+					throw std::runtime_error("write failed");
+				}
+			}
+
+			std::uint32_t crc() const { return m_crc.value(); }
+			std::uint64_t size() const { return m_size; }
+		private:
+			std::ofstream	m_file;
+			Crc32			m_crc;
+			std::uint64_t	m_size = 0;
+		};
+
+		// RFC 1951 decoder reading one bit at a time from the source, so it never consumes
+		// a byte past the end of the stream. Canonical Huffman decoding as in zlib's puff.
+		class Inflater
+		{
+		public:
+			Inflater(Source& source, Output& output)
+			: m_source(source)
+			, m_output(output)
+			{
+				m_pending.reserve(PENDING);
+			}
+
+			void run()
+			{
+				bool last;
+
+				do
+				{
+					last = bits(1) == 1;
+
+					switch (bits(2))
+					{
+						case 0: stored(); break;
+						case 1: fixed(); break;
+						case 2: dynamic(); break;
+						default: throw std::runtime_error("invalid deflate block");
+					}
+				} while (!last);
+
+				flush();
+			}
+		private:
+			static const int MAXBITS = 15;
+			static const std::size_t WINDOW = 32768;
+			static const std::size_t PENDING = 65536;
+
+			struct Huffman
+			{
+				std::array<short, MAXBITS + 1>	m_count;
+				std::array<short, 288>			m_symbol;
+			};
+
+			unsigned int bits(int need)
+			{
+				unsigned long value = m_bitBuffer;
+
+				while (m_bitCount < need)
+				{
+					value |= static_cast<unsigned long>(m_source.byte()) << m_bitCount;
+					m_bitCount += 8;
+				}
+
+				m_bitBuffer = value >> need;
+				m_bitCount -= need;
+
+				return static_cast<unsigned int>(value & ((1UL << need) - 1));
+			}
+
+			void put(unsigned char c)
+			{
+				m_window[m_total % WINDOW] = c;
+				++m_total;
+
+				m_pending.push_back(static_cast<char>(c));
+
+				if (m_pending.size() == PENDING)
+				{
+					flush();
+				}
+			}
+
+			void flush()
+			{
+				m_output.write(m_pending.data(), m_pending.size());
+				m_pending.clear();
+			}
+
+			void stored()
+			{
+				m_bitBuffer = 0;
+				m_bitCount = 0;
+
+				unsigned int length = m_source.u16();
+				unsigned int complement = m_source.u16();
+
+				if (length != (~complement & 0xffff))
+				{
+					throw std::runtime_error("invalid stored block");
+				}
+
+				m_source.read(length, [this](const char* data, std::size_t size)
+				{
+					for (std::size_t i = 0; i < size; ++i)
+					{
+						put(static_cast<unsigned char>(data[i]));
+					}
+				});
+			}
+
+			int decode(const Huffman& h)
+			{
+				int code = 0, first = 0, index = 0;
+
+				for (int len = 1; len <= MAXBITS; ++len)
+				{
+					code |= static_cast<int>(bits(1));
+
+					int count = h.m_count[len];
+
+					if (code - count < first)
+					{
+						return h.m_symbol[index + (code - first)];
+					}
+
+					index += count;
+					first += count;
+					first <<= 1;
+					code <<= 1;
+				}
+
+				throw std::runtime_error("invalid Huffman code");
+			}
+
+			// Returns 0 for a complete code, more than 0 for an incomplete one and less for an oversubscribed one
+			static int construct(Huffman& h, const short* length, int n)
+			{
+				h.m_count.fill(0);
+
+				for (int symbol = 0; symbol < n; ++symbol)
+				{
+					h.m_count[length[symbol]]++;
+				}
+
+				if (h.m_count[0] == n)
+				{
+					return 0;
+				}
+
+				int left = 1;
+
+				for (int len = 1; len <= MAXBITS; ++len)
+				{
+					left <<= 1;
+					left -= h.m_count[len];
+
+					if (left < 0)
+					{
+						return left;
+					}
+				}
+
+				std::array<short, MAXBITS + 1> offsets;
+				offsets[1] = 0;
+
+				for (int len = 1; len < MAXBITS; ++len)
+				{
+					offsets[len + 1] = static_cast<short>(offsets[len] + h.m_count[len]);
+				}
+
+				for (int symbol = 0; symbol < n; ++symbol)
+				{
+					if (length[symbol] != 0)
+					{
+						h.m_symbol[offsets[length[symbol]]++] = static_cast<short>(symbol);
+					}
+				}
+
+				return left;
+			}
+
+			void codes(const Huffman& lengths, const Huffman& distances)
+			{
+				static const short base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+				static const short extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+				static const short distanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+				static const short distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+				int symbol;
+
+				do
+				{
+					symbol = decode(lengths);
+
+					if (symbol < 256)
+					{
+						put(static_cast<unsigned char>(symbol));
+					}
+					else if (symbol > 256)
+					{
+						symbol -= 257;
+
+						if (symbol >= 29)
+						{
+							throw std::runtime_error("invalid length code");
+						}
+
+						unsigned int length = base[symbol] + bits(extra[symbol]);
+
+						int code = decode(distances);
+
+						if (code >= 30)
+						{
+							throw std::runtime_error("invalid distance code");
+						}
+
+						std::size_t distance = distanceBase[code] + bits(distanceExtra[code]);
+
+						if (distance > m_total)
+						{
+							throw std::runtime_error("distance too far back");
+						}
+
+						while (length--)
+						{
+							put(m_window[(m_total - distance) % WINDOW]);
+						}
+					}
+				} while (symbol != 256);
+			}
+
+			void fixed()
+			{
+				if (!m_fixedBuilt)
+				{
+					std::array<short, 288> length;
+
+					for (int symbol = 0; symbol < 144; ++symbol) length[symbol] = 8;
+					for (int symbol = 144; symbol < 256; ++symbol) length[symbol] = 9;
+					for (int symbol = 256; symbol < 280; ++symbol) length[symbol] = 7;
+					for (int symbol = 280; symbol < 288; ++symbol) length[symbol] = 8;
+
+					construct(m_fixedLengths, length.data(), 288);
+
+					for (int symbol = 0; symbol < 30; ++symbol) length[symbol] = 5;
+
+					construct(m_fixedDistances, length.data(), 30);
+
+					m_fixedBuilt = true;
+				}
+
+				codes(m_fixedLengths, m_fixedDistances);
+			}
+
+			void dynamic()
+			{
+				static const short order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+				int nlen = static_cast<int>(bits(5)) + 257;
+				int ndist = static_cast<int>(bits(5)) + 1;
+				int ncode = static_cast<int>(bits(4)) + 4;
+
+				if (nlen > 286 || ndist > 30)
+				{
+					throw std::runtime_error("invalid dynamic block");
+				}
+
+				std::array<short, 316> length;
+				length.fill(0);
+
+				for (int index = 0; index < ncode; ++index)
+				{
+					length[order[index]] = static_cast<short>(bits(3));
+				}
+
+				Huffman lengths, distances;
+
+				if (construct(lengths, length.data(), 19) != 0)
+				{
+					throw std::runtime_error("invalid code lengths");
+				}
+
+				int index = 0;
+
+				while (index < nlen + ndist)
+				{
+					int symbol = decode(lengths);
+
+					if (symbol < 16)
+					{
+						length[index++] = static_cast<short>(symbol);
+					}
+					else
+					{
+						short repeated = 0;
+
+						if (symbol == 16)
+						{
+							if (index == 0)
+							{
+								throw std::runtime_error("repeat without a length");
+							}
+
+							repeated = length[index - 1];
+							symbol = 3 + static_cast<int>(bits(2));
+						}
+						else if (symbol == 17)
+						{
+							symbol = 3 + static_cast<int>(bits(3));
+						}
+						else
+						{
+							symbol = 11 + static_cast<int>(bits(7));
+						}
+
+						if (index + symbol > nlen + ndist)
+						{
+							throw std::runtime_error("too many lengths");
+						}
+
+						while (symbol--)
+						{
+							length[index++] = repeated;
+						}
+					}
+				}
+
+				if (length[256] == 0)
+				{
+					throw std::runtime_error("missing end of block code");
+				}
+
+				// Incomplete codes are only allowed when they have a single length
+				int error = construct(lengths, length.data(), nlen);
+
+				if (error < 0 || (error > 0 && nlen - lengths.m_count[0] != 1))
+				{
+					throw std::runtime_error("invalid literal lengths");
+				}
+
+				error = construct(distances, length.data() + nlen, ndist);
+
+				if (error < 0 || (error > 0 && ndist - distances.m_count[0] != 1))
+				{
+					throw std::runtime_error("invalid distance lengths");
+				}
+
+				codes(lengths, distances);
+			}
+		private:
+			Source&								m_source;
+			Output&								m_output;
+			unsigned long						m_bitBuffer = 0;
+			int									m_bitCount = 0;
+			std::array<unsigned char, WINDOW>	m_window;
+			std::size_t							m_total = 0;
+			std::vector<char>					m_pending;
+			Huffman								m_fixedLengths;
+			Huffman								m_fixedDistances;
+			bool								m_fixedBuilt = false;
+		};
+
+		// Rejects absolute names and names climbing out of the output folder
+		boost::filesystem::path target(const boost::filesystem::path& output, const std::string& name)
+		{
+			boost::filesystem::path relative(name);
+
+			if (name.empty() || relative.has_root_path())
+			{
+				throw std::runtime_error("invalid entry name " + name);
+			}
+
+			for (auto& part : relative)
+			{
+				if (part == "..")
+				{
+					throw std::runtime_error("invalid entry name " + name);
+				}
+			}
+
+			return output / relative;
+		}
+
+		void entry(Source& source, const boost::filesystem::path& output)
+		{
+			source.u16();
+			auto flags = source.u16();
+			auto method = source.u16();
+			source.u32();
+			auto crc = source.u32();
+			auto compressedSize = source.u32();
+			auto size = source.u32();
+			auto nameLength = source.u16();
+			auto extraLength = source.u16();
+
+			std::string name;
+
+			source.read(nameLength, [&name](const char* data, std::size_t count)
+			{
+				name.append(data, count);
+			});
+
+			source.read(extraLength, [](const char*, std::size_t) {});
+
+			if (flags & 1)
+			{
+				throw std::runtime_error(name + " is encrypted");
+			}
+
+			if (compressedSize == 0xffffffff || size == 0xffffffff)
+			{
+				throw std::runtime_error(name + " needs zip64");
+			}
+
+			bool descriptor = (flags & 8) != 0;
+			auto path = target(output, name);
+
+			bool directory = *name.rbegin() == '/';
+
+			boost::filesystem::create_directories(directory ? path : path.parent_path());
+
+			// A directory has no data, but its empty payload and data descriptor still come
+			// before the next header
+			Output file = directory ? Output() : Output(path);
+
+			if (method == 8)
+			{
+				Inflater(source, file).run();
+			}
+			else if (method == 0 && (!descriptor || directory))
+			{
+				source.read(compressedSize, [&file](const char* data, std::size_t count)
+				{
+					file.write(data, count);
+				});
+			}
+			else
+			{
+				throw std::runtime_error(name + " uses an unsupported compression method");
+			}
+
+			if (descriptor)
+			{
+				// The signature is optional
+				crc = source.u32();
+
+				if (crc == g_dataDescriptor)
+				{
+					crc = source.u32();
+				}
+
+				source.u32();
+				size = source.u32();
+			}
+
+			if (file.crc() != crc || static_cast<std::uint32_t>(file.size()) != size)
+			{
+				throw std::runtime_error(name + " is corrupt");
+			}
+		}
+
+		void extractAll(Source& source, const boost::filesystem::path& output)
+		{
+			BLING_TRACE_SPAN("zip", "extract");
+
+			while (true)
+			{
+				auto signature = source.u32();
+
+				if (signature == g_localHeader)
+				{
+					entry(source, output);
+				}
+				else if (signature == g_centralHeader || signature == g_endOfCentralDirectory)
+				{
+					// Everything after repeats what the local headers said
+					return;
+				}
+				else
+				{
+					throw std::runtime_error("not a zip archive");
+				}
+			}
+		}
+	}
+
+	StreamingZipService::StreamingZipService() = default;
+	StreamingZipService::~StreamingZipService() = default;
+
+	bool StreamingZipService::extract(const SourceType& source, const std::string& output) const
+	{
+		Pipe pipe;
+		bool extracted = false;
+
+		std::thread extractor([&pipe, &extracted, &output]()
+		{
+			Source input(pipe);
+
+			try
+			{
+				boost::filesystem::create_directories(output);
+
+				extractAll(input, output);
+
+				extracted = true;
+			}
+			catch (...)
+			{
+				BLING_LOG_ERROR("StreamingZipService", "Extraction into " << output << " failed: " << utils::logging::currentException());
+			}
+
+			// The central directory left to download is not needed; after a failure, nothing is
+			if (extracted)
+			{
+				pipe.discard();
+			}
+			else
+			{
+				pipe.fail();
+			}
+		});
+
+		bool downloaded = false;
+
+		try
+		{
+			downloaded = source([&pipe](const char* data, std::size_t size)
+			{
+				return pipe.push(data, size);
+			});
+		}
+		catch (...)
+		{
+			BLING_LOG_ERROR("StreamingZipService", "Download failed: " << utils::logging::currentException());
+		}
+
+		if (downloaded)
+		{
+			pipe.close();
+		}
+		else
+		{
+			pipe.fail();
+		}
+
+		extractor.join();
+
+		return downloaded && extracted;
+	}
+}}}
\ No newline at end of file
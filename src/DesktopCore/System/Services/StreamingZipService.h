@@ -0,0 +1,24 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace desktop { namespace core { namespace service {
+
+	// Extracts a zip while it is being downloaded: entries are inflated and written as the
+	// bytes arrive, so nothing is saved before it is read. Only what a forward read can
+	// handle is supported: stored and deflated entries, no encryption and no zip64.
+	class StreamingZipService
+	{
+	public:
+		typedef std::function<bool(const char* data, std::size_t size)> SinkType;
+		typedef std::function<bool(SinkType sink)> SourceType;
+
+		StreamingZipService();
+		~StreamingZipService();
+
+		// Runs source on the calling thread while a second thread extracts into output. True
+		// when source succeeded and every entry was written and matched its CRC.
+		bool extract(const SourceType& source, const std::string& output) const;
+	};
+}}}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "TimestampFolderService.h"
 
-#include <sstream>
+#include "Utils/Timestamp/Timestamp.h"
+
+#include <algorithm>
 
 namespace desktop { namespace core { namespace service {
 
@@ -9,27 +11,44 @@ namespace desktop { namespace core { namespace service {
 
 	std::string TimestampFolderService::get(const std::string& timestamp) const
 	{
-		std::stringstream ss(timestamp);
+		// Split on the separators only, live views pass times with _ instead of :
+		const char* begin = timestamp.data();
+		const char* end = begin + timestamp.size();
+
+		const char* yearEnd = std::find(begin, end, '-');
+		const char* monthBegin = yearEnd == end ? end : yearEnd + 1;
+		const char* monthEnd = std::find(monthBegin, end, '-');
+		const char* dayBegin = monthEnd == end ? end : monthEnd + 1;
+		const char* dayEnd = std::find(dayBegin, end, 'T');
+
+		int monthNumber = 0;
+
+		for (const char* p = monthBegin; p != monthEnd && monthNumber <= 12; ++p)
+		{
+			monthNumber = *p >= '0' && *p <= '9' ? monthNumber * 10 + (*p - '0') : 13;
+		}
 
-		std::string year, month, day;
-		getline(ss, year, '-'); getline(ss, month, '-'); getline(ss, day, 'T');
+		std::string result;
+		result.reserve(timestamp.size() + 16);
 
-		int monthNumber = std::stoi(month);
+		result.append(begin, yearEnd).append(1, '/');
 
-		if (monthNumber <= 12)
+		if (monthNumber >= 1 && monthNumber <= 12)
+		{
+			result.append(months[monthNumber - 1]);
+		}
+		else
 		{
-			month = months[monthNumber - 1];
+			result.append(monthBegin, monthEnd);
 		}
 
-		return year + "\\" + month + "\\" + day + "\\";
+		result.append(1, '/').append(dayBegin, dayEnd).append(1, '/');
+
+		return result;
 	}
 
 	std::string TimestampFolderService::get(time_t timestamp) const
 	{
-		std::stringstream ss;
-		ss << timestamp;
-
-		std::string raw = ss.str();
-		return get(raw);
+		return get(utils::timestamp::toString(utils::timestamp::fromUniversal(timestamp)));
 	}
 }}}
\ No newline at end of file
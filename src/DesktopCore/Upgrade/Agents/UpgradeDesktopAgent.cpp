@@ -1,11 +1,15 @@
 #include "UpgradeDesktopAgent.h"
 
-#include "Utils\Patterns\PublisherSubscriber\Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Logging/Logger.h"
+#include "Utils/Tracing/Tracer.h"
 #include "../Events.h"
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/filesystem.hpp>
+#include <fstream>
+#include <iterator>
 
 namespace desktop { namespace core { namespace agent {
 
@@ -14,49 +18,76 @@ namespace desktop { namespace core { namespace agent {
 											std::unique_ptr<service::ApplicationDataService> applicationService,
 											std::unique_ptr<service::HTTPClientService> clientService,
 											std::unique_ptr<service::CompressionService> compressionService,
-											std::unique_ptr<service::ReplaceFolderService> replaceFolderService)
-	: m_ioService()
-	, m_timer(m_ioService, boost::posix_time::seconds(60 * 10))
-	, m_downloadService(std::move(downloadService))
+											std::unique_ptr<service::ReplaceFolderService> replaceFolderService,
+											std::unique_ptr<service::BinaryPatchService> patchService,
+											std::unique_ptr<service::SignatureService> signatureService,
+											std::unique_ptr<service::ParseURIService> uriService,
+											utils::runtime::Runtime& runtime)
+	: m_downloadService(std::move(downloadService))
 	, m_clientService(std::move(clientService))
 	, m_compressionService(std::move(compressionService))
 	, m_replaceFolderService(std::move(replaceFolderService))
+	, m_patchService(std::move(patchService))
+	, m_signatureService(std::move(signatureService))
+	, m_uriService(std::move(uriService))
 	, m_applicationService(std::move(applicationService))
 	, m_iniFileService(std::move(iniFileService))
-	, m_enabled(true)
+	, m_lifecycle(runtime)
+	, m_metrics("UpgradeDesktopAgent")
 	{
-		armTimer(1);
+		auto documents = m_applicationService->getMyDocuments();
 
-		boost::thread t(boost::bind(&boost::asio::io_service::run, &m_ioService));
-		m_backgroundThread.swap(t);
+		m_settings = std::make_unique<service::LiveSettingsService<model::UpgradeSettings>>(documents + "Bling.ini", [this, documents]()
+		{
+			model::UpgradeSettings settings;
 
-		auto documents = m_applicationService->getMyDocuments();
-		
-		m_host = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "Host", "api.github.com");
-		m_repository = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "Repository", "/repos/lurume84/bling-desktop/releases/latest");
-		m_inFolder = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "Input", documents + "Download\\Versions\\Desktop\\");
-		m_outFolder = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "Output", m_applicationService->getViewerFolder());
+			settings.m_host = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "Host", "api.github.com");
+			settings.m_repository = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "Repository", "/repos/lurume84/bling-desktop/releases/latest");
+			settings.m_input = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "Input", documents + "Download/Versions/Desktop/");
+			settings.m_output = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "Output", m_applicationService->getViewerFolder());
+			settings.m_publicKey = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeDesktop", "PublicKey", m_applicationService->getApplicationFolder() + "/update.pem");
 
-		boost::filesystem::create_directories(m_inFolder);
+			boost::filesystem::create_directories(settings.m_input);
+
+			return settings;
+		});
 	}
 
 	UpgradeDesktopAgent::~UpgradeDesktopAgent()
 	{
-		m_enabled = false;
-		m_timer.cancel();
-		m_backgroundThread.join();
-		m_ioService.reset();
+		m_lifecycle.stop();
+		m_lifecycle.wait();
+	}
+
+	void UpgradeDesktopAgent::start()
+	{
+		m_lifecycle.start();
+
+		armTimer(1);
+	}
+
+	void UpgradeDesktopAgent::stop()
+	{
+		m_lifecycle.stop();
+	}
+
+	bool UpgradeDesktopAgent::drain(std::chrono::milliseconds timeout)
+	{
+		return m_lifecycle.drain(timeout);
 	}
 
 	void UpgradeDesktopAgent::execute()
 	{
-		if (m_enabled)
+		if (m_lifecycle.running())
 		{
+			auto settings = m_settings->get();
+			auto token = m_lifecycle.token();
+
 			std::map<std::string, std::string> requestHeaders, responseHeaders;
 			std::string content;
 			unsigned int status;
 
-			if (m_clientService->get(m_host, "443", m_repository, requestHeaders, responseHeaders, content, status))
+			if (m_clientService->get(settings->m_host, "443", settings->m_repository, requestHeaders, responseHeaders, content, status, token))
 			{
 				try
 				{
@@ -66,32 +97,50 @@ namespace desktop { namespace core { namespace agent {
 
 					auto version = tree.get_child("tag_name").get_value<std::string>();
 
-					if (!boost::filesystem::exists(m_inFolder + version + ".exe"))
+					if (!boost::filesystem::exists(settings->m_input + version + ".exe"))
 					{
-						auto url = tree.get_child("browser_download_url").get_value<std::string>();
-
-						events::DownloadUpgradeEvent evt(version, [this, url, version]()
+						// Streaming services download in the background, without a round trip through the browser
+						if (m_downloadService->canStream())
 						{
-							std::map<std::string, std::string> requestHeaders;
-							auto path = m_downloadService->download(m_host, url, requestHeaders, m_inFolder + version + ".exe");
-
-							if (path != "")
+							if (update(*settings, tree, version, token))
 							{
 								events::UpgradeDesktopCompletedEvent evt(version);
 								utils::patterns::Broker::get().publish(evt);
 							}
+							else if (!token.cancelled())
+							{
+								m_metrics.failed();
+							}
+						}
+						else
+						{
+							auto url = tree.get_child("browser_download_url").get_value<std::string>();
+
+							events::DownloadUpgradeEvent evt(version, [this, settings, url, version]()
+							{
+								std::map<std::string, std::string> requestHeaders;
+								auto path = m_downloadService->download(settings->m_host, url, requestHeaders, settings->m_input + version + ".exe", m_lifecycle.token());
+
+								if (path != "")
+								{
+									events::UpgradeDesktopCompletedEvent evt(version);
+									utils::patterns::Broker::get().publish(evt);
+								}
 
-							armTimer();
+								armTimer();
 
-							return true;
-						});
+								return true;
+							});
 
-						utils::patterns::Broker::get().publish(evt);
+							utils::patterns::Broker::get().publish(evt);
+						}
 					}
 				}
-				catch (std::exception& /*e*/)
+				catch (std::exception& e)
 				{
+					m_metrics.failed();
 
+					BLING_LOG_ERROR("UpgradeDesktopAgent", "Upgrade failed: " << e.what());
 				}
 			}
 
@@ -99,16 +148,186 @@ namespace desktop { namespace core { namespace agent {
 		}
 	}
 
+	bool UpgradeDesktopAgent::update(const model::UpgradeSettings& settings, const boost::property_tree::ptree& release, const std::string& version,
+									const utils::runtime::CancellationToken& token)
+	{
+		BLING_TRACE_SPAN("upgrade", "desktop");
+
+		std::map<std::string, std::string> assets;
+
+		for (auto& asset : release.get_child("assets"))
+		{
+			assets[asset.second.get<std::string>("name")] = asset.second.get<std::string>("browser_download_url");
+		}
+
+		std::ifstream keyFile(settings.m_publicKey, std::ios::in | std::ios::binary);
+		std::string key((std::istreambuf_iterator<char>(keyFile)), std::istreambuf_iterator<char>());
+
+		// Only builds shipped without a key take installers unchecked
+		if (key.empty())
+		{
+			BLING_LOG_WARNING("UpgradeDesktopAgent", "No update key in " << settings.m_publicKey << ", downloading the full installer of " << version << " unchecked");
+
+			std::map<std::string, std::string> requestHeaders;
+
+			return !m_downloadService->download(settings.m_host, release.get<std::string>("browser_download_url"), requestHeaders, settings.m_input + version + ".exe", token).empty();
+		}
+
+		std::string content, signature;
+
+		// Once a key ships, a release without a manifest that can be checked is never installed; the next check tries again
+		if (!fetch(assets, "update.json", content, token) || !fetch(assets, "update.json.sig", signature, token))
+		{
+			if (!token.cancelled())
+			{
+				BLING_LOG_ERROR("UpgradeDesktopAgent", "Update manifest of " << version << " or its signature could not be downloaded");
+			}
+
+			return false;
+		}
+
+		if (!m_signatureService->verify(key, content, signature))
+		{
+			BLING_LOG_ERROR("UpgradeDesktopAgent", "Signature of the update manifest of " << version << " does not match");
+			return false;
+		}
+
+		std::stringstream ss(content);
+		boost::property_tree::ptree manifest;
+		boost::property_tree::json_parser::read_json(ss, manifest);
+
+		// A manifest signed for an older release must not be replayed for this one
+		if (manifest.get<std::string>("version") != version)
+		{
+			BLING_LOG_ERROR("UpgradeDesktopAgent", "Update manifest of " << version << " describes " << manifest.get<std::string>("version"));
+			return false;
+		}
+
+		auto digest = manifest.get<std::string>("sha256");
+		auto target = settings.m_input + version + ".exe";
+		auto partial = target + ".partial";
+
+		bool done = false;
+
+		// Versions contain dots, which get_child would take for a path
+		auto patches = manifest.get_child_optional("patches");
+
+		for (auto& item : boost::filesystem::directory_iterator(settings.m_input))
+		{
+			if (done || !patches || item.path().extension() != ".exe")
+			{
+				continue;
+			}
+
+			auto from = item.path().stem().string();
+
+			for (auto& patch : *patches)
+			{
+				if (patch.first != from)
+				{
+					continue;
+				}
+
+				std::ifstream sourceFile(item.path().string(), std::ios::in | std::ios::binary);
+				std::string source((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
+
+				std::string delta, result;
+
+				if (fetch(assets, patch.second.get_value<std::string>(), delta, token) && m_patchService->apply(source, delta, result) &&
+					m_signatureService->sha256(result) == digest)
+				{
+					std::ofstream file(partial, std::ios::out | std::ios::binary | std::ios::trunc);
+					done = static_cast<bool>(file.write(result.data(), result.size()));
+
+					BLING_LOG_INFO("UpgradeDesktopAgent", "Patched " << from << " to " << version << " with " << delta.size() << " bytes instead of " << result.size());
+				}
+				else if (!token.cancelled())
+				{
+					BLING_LOG_WARNING("UpgradeDesktopAgent", "Patch from " << from << " to " << version << " could not be applied");
+				}
+
+				break;
+			}
+		}
+
+		if (!done && !token.cancelled())
+		{
+			{
+				std::ofstream file(partial, std::ios::out | std::ios::binary | std::ios::trunc);
+
+				done = fetch(assets, manifest.get<std::string>("installer"), [&file](const char* data, std::size_t size)
+				{
+					return static_cast<bool>(file.write(data, size));
+				}, token);
+			}
+
+			if (done && m_signatureService->sha256File(partial) != digest)
+			{
+				BLING_LOG_ERROR("UpgradeDesktopAgent", "Installer of " << version << " does not match the update manifest");
+				done = false;
+			}
+		}
+
+		boost::system::error_code ec;
+
+		if (!done)
+		{
+			boost::filesystem::remove(partial, ec);
+			return false;
+		}
+
+		boost::filesystem::rename(partial, target);
+
+		// The new installer is the base of the next patch
+		for (auto& item : boost::filesystem::directory_iterator(settings.m_input))
+		{
+			if (item.path().extension() == ".exe" && item.path() != boost::filesystem::path(target))
+			{
+				boost::filesystem::remove(item.path(), ec);
+			}
+		}
+
+		return true;
+	}
+
+	bool UpgradeDesktopAgent::fetch(const std::map<std::string, std::string>& assets, const std::string& name, service::IDownloadFileService::SinkType sink,
+									const utils::runtime::CancellationToken& token) const
+	{
+		auto asset = assets.find(name);
+		std::string protocol, domain, port, path, query, fragment;
+
+		if (asset == assets.end() || !m_uriService->parse(asset->second, protocol, domain, port, path, query, fragment))
+		{
+			return false;
+		}
+
+		std::map<std::string, std::string> requestHeaders;
+
+		return m_downloadService->stream(domain, path, requestHeaders, sink, token);
+	}
+
+	bool UpgradeDesktopAgent::fetch(const std::map<std::string, std::string>& assets, const std::string& name, std::string& content,
+									const utils::runtime::CancellationToken& token) const
+	{
+		content.clear();
+
+		return fetch(assets, name, [&content](const char* data, std::size_t size)
+		{
+			content.append(data, size);
+			return true;
+		}, token);
+	}
+
 	void UpgradeDesktopAgent::armTimer(unsigned int seconds)
 	{
-		if (m_enabled)
+		m_lifecycle.schedule(std::chrono::seconds(seconds), [this]()
 		{
-			m_timer.expires_from_now(boost::posix_time::seconds(seconds));
+			BLING_TRACE_SPAN("agent", "UpgradeDesktopAgent");
 
-			m_timer.async_wait([&](const boost::system::error_code& ec)
+			m_metrics.run([this]()
 			{
 				execute();
 			});
-		}
+		});
 	}
 }}}
\ No newline at end of file
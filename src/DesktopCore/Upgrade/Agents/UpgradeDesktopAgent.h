@@ -2,16 +2,22 @@
 
 #include <malloc.h>
 
-#include <boost/thread.hpp>
-#include <boost/asio.hpp>
-
 #include "../../Network/Services/HTTPClientService.h"
 #include "../../Network/Services/DownloadFileService.h"
+#include "../../Network/Services/ParseURIService.h"
+#include "../../System/Services/BinaryPatchService.h"
 #include "../../System/Services/CompressionService.h"
 #include "../../System/Services/ReplaceFolderService.h"
 #include "../../System/Services/IniFileService.h"
 #include "../../System/Services/ApplicationDataService.h"
+#include "../../System/Services/LiveSettingsService.h"
+#include "../../System/Services/SignatureService.h"
+#include "../Model/UpgradeSettings.h"
 #include "../../Model/IAgent.h"
+#include "../../Utils/Metrics/AgentMetrics.h"
+#include "../../Utils/Runtime/Lifecycle.h"
+
+#include <boost/property_tree/ptree.hpp>
 
 namespace desktop { namespace core { namespace agent {
 	class UpgradeDesktopAgent : public model::IAgent
@@ -22,27 +28,42 @@ namespace desktop { namespace core { namespace agent {
 							std::unique_ptr<service::ApplicationDataService> applicationService = std::make_unique<service::ApplicationDataService>(),
 							std::unique_ptr<service::HTTPClientService> clientService = std::make_unique<service::HTTPClientService>(),
 							std::unique_ptr<service::CompressionService> compressionService = std::make_unique<service::CompressionService>(),
-							std::unique_ptr<service::ReplaceFolderService> replaceFolderService = std::make_unique<service::ReplaceFolderService>());
+							std::unique_ptr<service::ReplaceFolderService> replaceFolderService = std::make_unique<service::ReplaceFolderService>(),
+							std::unique_ptr<service::BinaryPatchService> patchService = std::make_unique<service::BinaryPatchService>(),
+							std::unique_ptr<service::SignatureService> signatureService = std::make_unique<service::SignatureService>(),
+							std::unique_ptr<service::ParseURIService> uriService = std::make_unique<service::ParseURIService>(),
+							utils::runtime::Runtime& runtime = utils::runtime::Runtime::get());
 		~UpgradeDesktopAgent();
 
+		void start() override;
+		void stop() override;
+		bool drain(std::chrono::milliseconds timeout) override;
+
 		void execute();
 	private:
 		void armTimer(unsigned int seconds = 60 * 60 * 12);
-	private:
-		boost::asio::io_service		m_ioService;
-		boost::asio::deadline_timer	m_timer;
-		boost::thread				m_backgroundThread;
-		std::string					m_host;
-		std::string					m_repository;
-		std::string					m_inFolder;
-		std::string					m_outFolder;
-		bool						m_enabled = false;
 
+		// Downloads the release described by the signed update manifest, as a patch of an installer
+		// already in input when there is one. Nothing is kept unless its hash matches the manifest.
+		bool update(const model::UpgradeSettings& settings, const boost::property_tree::ptree& release, const std::string& version,
+					const utils::runtime::CancellationToken& token);
+		bool fetch(const std::map<std::string, std::string>& assets, const std::string& name, service::IDownloadFileService::SinkType sink,
+					const utils::runtime::CancellationToken& token) const;
+		bool fetch(const std::map<std::string, std::string>& assets, const std::string& name, std::string& content,
+					const utils::runtime::CancellationToken& token) const;
+	private:
 		std::unique_ptr<service::IDownloadFileService> m_downloadService;
 		std::unique_ptr<service::HTTPClientService> m_clientService;
 		std::unique_ptr<service::CompressionService> m_compressionService;
 		std::unique_ptr<service::ReplaceFolderService> m_replaceFolderService;
+		std::unique_ptr<service::BinaryPatchService> m_patchService;
+		std::unique_ptr<service::SignatureService> m_signatureService;
+		std::unique_ptr<service::ParseURIService> m_uriService;
 		std::unique_ptr<service::ApplicationDataService> m_applicationService;
 		std::unique_ptr<service::IniFileService> m_iniFileService;
+		std::unique_ptr<service::LiveSettingsService<model::UpgradeSettings>> m_settings;
+
+		utils::runtime::Lifecycle					m_lifecycle;
+		utils::metrics::AgentMetrics				m_metrics;
 	};
 }}}
\ No newline at end of file
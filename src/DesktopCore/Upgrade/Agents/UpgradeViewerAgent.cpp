@@ -1,11 +1,15 @@
 #include "UpgradeViewerAgent.h"
 
-#include "Utils\Patterns\PublisherSubscriber\Broker.h"
+#include "System/Services/AssetCache.h"
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Logging/Logger.h"
+#include "Utils/Tracing/Tracer.h"
 #include "../Events.h"
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/filesystem.hpp>
+#include <fstream>
 
 namespace desktop { namespace core { namespace agent {
 
@@ -14,49 +18,74 @@ namespace desktop { namespace core { namespace agent {
 											std::unique_ptr<service::ApplicationDataService> applicationService,
 											std::unique_ptr<service::HTTPClientService> clientService,
 											std::unique_ptr<service::CompressionService> compressionService,
-											std::unique_ptr<service::ReplaceFolderService> replaceFolderService)
-	: m_ioService()
-	, m_timer(m_ioService, boost::posix_time::seconds(60 * 10))
-	, m_downloadService(std::move(downloadService))
+											std::unique_ptr<service::DeltaFolderService> deltaFolderService,
+											std::unique_ptr<service::StreamingZipService> zipService,
+											utils::runtime::Runtime& runtime)
+	: m_downloadService(std::move(downloadService))
 	, m_clientService(std::move(clientService))
 	, m_compressionService(std::move(compressionService))
-	, m_replaceFolderService(std::move(replaceFolderService))
+	, m_deltaFolderService(std::move(deltaFolderService))
+	, m_zipService(std::move(zipService))
 	, m_applicationService(std::move(applicationService))
 	, m_iniFileService(std::move(iniFileService))
-	, m_enabled(true)
+	, m_lifecycle(runtime)
+	, m_metrics("UpgradeViewerAgent")
 	{
-		armTimer(1);
+		auto documents = m_applicationService->getMyDocuments();
 
-		boost::thread t(boost::bind(&boost::asio::io_service::run, &m_ioService));
-		m_backgroundThread.swap(t);
+		m_settings = std::make_unique<service::LiveSettingsService<model::UpgradeSettings>>(documents + "Bling.ini", [this, documents]()
+		{
+			model::UpgradeSettings settings;
 
-		auto documents = m_applicationService->getMyDocuments();
-		
-		m_host = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeViewer", "Host", "api.github.com");
-		m_repository = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeViewer", "Repository", "/repos/lurume84/bling-viewer/releases/latest");
-		m_inFolder = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeViewer", "Input", documents + "Download\\Versions\\Viewer\\");
-		m_outFolder = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeViewer", "Output", m_applicationService->getViewerFolder());
+			settings.m_host = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeViewer", "Host", "api.github.com");
+			settings.m_repository = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeViewer", "Repository", "/repos/lurume84/bling-viewer/releases/latest");
+			settings.m_input = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeViewer", "Input", documents + "Download/Versions/Viewer/");
+			settings.m_output = m_iniFileService->get<std::string>(documents + "Bling.ini", "UpgradeViewer", "Output", m_applicationService->getViewerFolder());
 
-		boost::filesystem::create_directories(m_inFolder);
+			boost::filesystem::create_directories(settings.m_input);
+
+			return settings;
+		});
+
+		// Before the viewer is loaded from it
+		m_deltaFolderService->recover(m_settings->get()->m_output);
 	}
 
 	UpgradeViewerAgent::~UpgradeViewerAgent()
 	{
-		m_enabled = false;
-		m_timer.cancel();
-		m_backgroundThread.join();
-		m_ioService.reset();
+		m_lifecycle.stop();
+		m_lifecycle.wait();
+	}
+
+	void UpgradeViewerAgent::start()
+	{
+		m_lifecycle.start();
+
+		armTimer(1);
+	}
+
+	void UpgradeViewerAgent::stop()
+	{
+		m_lifecycle.stop();
+	}
+
+	bool UpgradeViewerAgent::drain(std::chrono::milliseconds timeout)
+	{
+		return m_lifecycle.drain(timeout);
 	}
 
 	void UpgradeViewerAgent::execute()
 	{
-		if (m_enabled)
+		if (m_lifecycle.running())
 		{
+			auto settings = m_settings->get();
+			auto token = m_lifecycle.token();
+
 			std::map<std::string, std::string> requestHeaders, responseHeaders;
 			std::string content;
 			unsigned int status;
 
-			if (m_clientService->get(m_host, "443", m_repository, requestHeaders, responseHeaders, content, status))
+			if (m_clientService->get(settings->m_host, "443", settings->m_repository, requestHeaders, responseHeaders, content, status, token))
 			{
 				try
 				{
@@ -66,44 +95,61 @@ namespace desktop { namespace core { namespace agent {
 
 					auto version = tree.get_child("tag_name").get_value<std::string>();
 
-					if (!boost::filesystem::exists(m_inFolder + version + ".zip"))
+					// Versions extracted while downloading leave a marker instead of the archive
+					if (!boost::filesystem::exists(settings->m_input + version + ".zip") && !boost::filesystem::exists(settings->m_input + version + ".installed"))
 					{
 						auto url = tree.get_child("zipball_url").get_value<std::string>();
 
-						std::map<std::string, std::string> requestHeaders;
-						auto path = m_downloadService->download(m_host, url, requestHeaders, m_inFolder + version + ".zip");
-
-						if (path != "")
+						if (m_downloadService->canStream())
 						{
-							events::ExtractUpgradeEvent evt(path);
-							utils::patterns::Broker::get().publish(evt);
+							upgrade(*settings, version, url, token);
+						}
+						else
+						{
+							std::map<std::string, std::string> requestHeaders;
+							auto path = m_downloadService->download(settings->m_host, url, requestHeaders, settings->m_input + version + ".zip", token);
 
-							if (m_compressionService->extract("zip", path, m_inFolder))
+							if (path != "")
 							{
-								auto target = boost::filesystem::path(m_inFolder);
+								events::ExtractUpgradeEvent evt(path);
+								utils::patterns::Broker::get().publish(evt);
 
-								for (auto &it : boost::filesystem::directory_iterator(target))
+								if (m_compressionService->extract("zip", path, settings->m_input))
 								{
-									if (boost::filesystem::is_directory(it.path()))
-									{
-										bool fresh = !boost::filesystem::exists(m_outFolder + "/index.html");
+									auto target = boost::filesystem::path(settings->m_input);
 
-										m_replaceFolderService->replace(it.path().string(), m_outFolder);
-
-										boost::filesystem::rename(path, m_inFolder + version + ".zip");
-
-										events::UpgradeViewerCompletedEvent evt(version, fresh);
-										utils::patterns::Broker::get().publish(evt);
-										break;
+									for (auto &it : boost::filesystem::directory_iterator(target))
+									{
+										if (boost::filesystem::is_directory(it.path()))
+										{
+											bool fresh = !boost::filesystem::exists(settings->m_output + "/index.html");
+
+											if (m_deltaFolderService->replace(it.path().string(), settings->m_output))
+											{
+												service::AssetCache::get().preload(settings->m_output, m_deltaFolderService->load(settings->m_output));
+
+												events::UpgradeViewerCompletedEvent evt(version, fresh);
+												utils::patterns::Broker::get().publish(evt);
+											}
+											else
+											{
+												// Without the archive, the next check downloads this version again
+												boost::filesystem::remove(path);
+											}
+
+											break;
+										}
 									}
 								}
 							}
 						}
 					}
 				}
-				catch (std::exception& /*e*/)
+				catch (std::exception& e)
 				{
+					m_metrics.failed();
 
+					BLING_LOG_ERROR("UpgradeViewerAgent", "Upgrade failed: " << e.what());
 				}
 			}
 
@@ -111,16 +157,63 @@ namespace desktop { namespace core { namespace agent {
 		}
 	}
 
+	void UpgradeViewerAgent::upgrade(const model::UpgradeSettings& settings, const std::string& version, const std::string& url, const utils::runtime::CancellationToken& token)
+	{
+		auto staging = settings.m_input + version + "/";
+
+		boost::filesystem::remove_all(staging);
+
+		events::ExtractUpgradeEvent evt(staging);
+		utils::patterns::Broker::get().publish(evt);
+
+		bool extracted = m_zipService->extract([this, &settings, &url, &token](service::StreamingZipService::SinkType sink)
+		{
+			std::map<std::string, std::string> requestHeaders;
+
+			return m_downloadService->stream(settings.m_host, url, requestHeaders, sink, token);
+		}, staging);
+
+		if (extracted)
+		{
+			for (auto &it : boost::filesystem::directory_iterator(staging))
+			{
+				if (boost::filesystem::is_directory(it.path()))
+				{
+					bool fresh = !boost::filesystem::exists(settings.m_output + "/index.html");
+
+					if (m_deltaFolderService->replace(it.path().string(), settings.m_output))
+					{
+						std::ofstream marker(settings.m_input + version + ".installed");
+
+						// The viewer reloads right after the event, serve it from memory
+						service::AssetCache::get().preload(settings.m_output, m_deltaFolderService->load(settings.m_output));
+
+						events::UpgradeViewerCompletedEvent evt(version, fresh);
+						utils::patterns::Broker::get().publish(evt);
+					}
+
+					break;
+				}
+			}
+		}
+		else if (!token.cancelled())
+		{
+			m_metrics.failed();
+		}
+
+		boost::filesystem::remove_all(staging);
+	}
+
 	void UpgradeViewerAgent::armTimer(unsigned int seconds)
 	{
-		if (m_enabled)
+		m_lifecycle.schedule(std::chrono::seconds(seconds), [this]()
 		{
-			m_timer.expires_from_now(boost::posix_time::seconds(seconds));
+			BLING_TRACE_SPAN("agent", "UpgradeViewerAgent");
 
-			m_timer.async_wait([&](const boost::system::error_code& ec)
+			m_metrics.run([this]()
 			{
 				execute();
 			});
-		}
+		});
 	}
 }}}
\ No newline at end of file
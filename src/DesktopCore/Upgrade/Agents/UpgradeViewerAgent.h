@@ -2,16 +2,18 @@
 
 #include <malloc.h>
 
-#include <boost/thread.hpp>
-#include <boost/asio.hpp>
-
 #include "../../Network/Services/HTTPClientService.h"
 #include "../../Network/Services/DownloadFileService.h"
 #include "../../System/Services/CompressionService.h"
-#include "../../System/Services/ReplaceFolderService.h"
+#include "../../System/Services/DeltaFolderService.h"
+#include "../../System/Services/StreamingZipService.h"
 #include "../../System/Services/IniFileService.h"
 #include "../../System/Services/ApplicationDataService.h"
+#include "../../System/Services/LiveSettingsService.h"
+#include "../Model/UpgradeSettings.h"
 #include "../../Model/IAgent.h"
+#include "../../Utils/Metrics/AgentMetrics.h"
+#include "../../Utils/Runtime/Lifecycle.h"
 
 namespace desktop { namespace core { namespace agent {
 	class UpgradeViewerAgent : public model::IAgent
@@ -22,27 +24,31 @@ namespace desktop { namespace core { namespace agent {
 							std::unique_ptr<service::ApplicationDataService> applicationService = std::make_unique<service::ApplicationDataService>(),
 							std::unique_ptr<service::HTTPClientService> clientService = std::make_unique<service::HTTPClientService>(),
 							std::unique_ptr<service::CompressionService> compressionService = std::make_unique<service::CompressionService>(),
-							std::unique_ptr<service::ReplaceFolderService> replaceFolderService = std::make_unique<service::ReplaceFolderService>());
+							std::unique_ptr<service::DeltaFolderService> deltaFolderService = std::make_unique<service::DeltaFolderService>(),
+							std::unique_ptr<service::StreamingZipService> zipService = std::make_unique<service::StreamingZipService>(),
+							utils::runtime::Runtime& runtime = utils::runtime::Runtime::get());
 		~UpgradeViewerAgent();
 
+		void start() override;
+		void stop() override;
+		bool drain(std::chrono::milliseconds timeout) override;
+
 		void execute();
 	private:
+		// Extracts the zipball while it downloads, so no archive is written
+		void upgrade(const model::UpgradeSettings& settings, const std::string& version, const std::string& url, const utils::runtime::CancellationToken& token);
 		void armTimer(unsigned int seconds = 60 * 60 * 12);
 	private:
-		boost::asio::io_service		m_ioService;
-		boost::asio::deadline_timer	m_timer;
-		boost::thread				m_backgroundThread;
-		std::string					m_host;
-		std::string					m_repository;
-		std::string					m_inFolder;
-		std::string					m_outFolder;
-		bool						m_enabled = false;
-
 		std::unique_ptr<service::IDownloadFileService> m_downloadService;
 		std::unique_ptr<service::HTTPClientService> m_clientService;
 		std::unique_ptr<service::CompressionService> m_compressionService;
-		std::unique_ptr<service::ReplaceFolderService> m_replaceFolderService;
+		std::unique_ptr<service::DeltaFolderService> m_deltaFolderService;
+		std::unique_ptr<service::StreamingZipService> m_zipService;
 		std::unique_ptr<service::ApplicationDataService> m_applicationService;
 		std::unique_ptr<service::IniFileService> m_iniFileService;
+		std::unique_ptr<service::LiveSettingsService<model::UpgradeSettings>> m_settings;
+
+		utils::runtime::Lifecycle					m_lifecycle;
+		utils::metrics::AgentMetrics				m_metrics;
 	};
 }}}
\ No newline at end of file
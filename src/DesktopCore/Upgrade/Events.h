@@ -1,12 +1,12 @@
 #pragma once
 
-#include "..\Utils\Patterns\PublisherSubscriber\Event.h"
+#include "../Utils/Patterns/PublisherSubscriber/Event.h"
 
 namespace desktop { namespace core { namespace events {
 	
 	namespace sup = utils::patterns;
 	
-	const sup::EventType DOWNLOAD_UPGRADE_EVENT = "DOWNLOAD_UPGRADE_EVENT";
+	constexpr sup::EventType DOWNLOAD_UPGRADE_EVENT = sup::makeEventType("DOWNLOAD_UPGRADE_EVENT");
 	struct DownloadUpgradeEvent : public sup::Event
 	{
 		DownloadUpgradeEvent(const std::string& version, std::function<bool()> callback)
@@ -20,7 +20,7 @@ namespace desktop { namespace core { namespace events {
 		std::function<bool()> m_callback;
 	};
 
-	const sup::EventType EXTRACT_UPGRADE_EVENT = "EXTRACT_UPGRADE_EVENT";
+	constexpr sup::EventType EXTRACT_UPGRADE_EVENT = sup::makeEventType("EXTRACT_UPGRADE_EVENT");
 	struct ExtractUpgradeEvent : public sup::Event
 	{
 		ExtractUpgradeEvent(const std::string& version)
@@ -32,7 +32,7 @@ namespace desktop { namespace core { namespace events {
 		std::string m_version;
 	};
 
-	const sup::EventType UPGRADE_VIEWER_COMPLETED_EVENT = "UPGRADE_VIEWER_COMPLETED_EVENT";
+	constexpr sup::EventType UPGRADE_VIEWER_COMPLETED_EVENT = sup::makeEventType("UPGRADE_VIEWER_COMPLETED_EVENT");
 	struct UpgradeViewerCompletedEvent : public sup::Event
 	{
 		UpgradeViewerCompletedEvent(const std::string& version, bool fresh)
@@ -46,7 +46,7 @@ namespace desktop { namespace core { namespace events {
 		bool m_fresh;
 	};
 
-	const sup::EventType UPGRADE_DESKTOP_COMPLETED_EVENT = "UPGRADE_DESKTOP_COMPLETED_EVENT";
+	constexpr sup::EventType UPGRADE_DESKTOP_COMPLETED_EVENT = sup::makeEventType("UPGRADE_DESKTOP_COMPLETED_EVENT");
 	struct UpgradeDesktopCompletedEvent : public sup::Event
 	{
 		UpgradeDesktopCompletedEvent(const std::string& version)
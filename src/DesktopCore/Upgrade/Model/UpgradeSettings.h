@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+namespace desktop { namespace core { namespace model { 
+	struct UpgradeSettings
+	{
+		std::string m_host;
+		std::string m_repository;
+		std::string m_input;
+		std::string m_output;
+		// PEM file checking releases of the desktop
+		std::string m_publicKey;
+	};
+}}}
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+namespace desktop { namespace core { namespace utils { namespace logging {
+
+	namespace
+	{
+		const std::chrono::milliseconds g_writeInterval(200);
+
+		const char* name(Level level)
+		{
+			switch (level)
+			{
+				case Level::DEBUG: return "DEBUG";
+				case Level::INFO: return "INFO";
+				case Level::WARNING: return "WARNING";
+				default: return "ERROR";
+			}
+		}
+
+		void format(std::ostream& os, long long time)
+		{
+			std::time_t seconds = static_cast<std::time_t>(time / 1000000);
+
+			struct tm timeinfo;
+
+#ifdef _WIN32
+			gmtime_s(&timeinfo, &seconds);
+#else
+			gmtime_r(&seconds, &timeinfo);
+#endif
+
+			os << timeinfo.tm_year + 1900 << "-" << std::setfill('0') << std::setw(2) << timeinfo.tm_mon + 1 << "-"
+				<< std::setw(2) << timeinfo.tm_mday << "T" << std::setw(2) << timeinfo.tm_hour << ":"
+				<< std::setw(2) << timeinfo.tm_min << ":" << std::setw(2) << timeinfo.tm_sec << "."
+				<< std::setw(6) << time % 1000000 << "Z";
+		}
+	}
+
+	Logger& Logger::get()
+	{
+		// Leaked so that threads still running after main can log without a dangling reference
+		static Logger* S = new Logger();
+		return *S;
+	}
+
+	Logger::Logger()
+	: m_level(static_cast<int>(Level::INFO))
+	{
+		m_writer = std::thread(&Logger::run, this);
+	}
+
+	Logger::Holder::~Holder()
+	{
+		if (m_buffer)
+		{
+			m_buffer->m_retired.store(true, std::memory_order_release);
+		}
+	}
+
+	bool Logger::open(const std::string& path, std::uintmax_t maxSize, unsigned int files)
+	{
+		std::unique_lock<std::mutex> lock(m_fileMutex);
+
+		try
+		{
+			boost::filesystem::create_directories(boost::filesystem::path(path).parent_path());
+		}
+		catch (...)
+		{
+
+		}
+
+		m_path = path;
+		m_maxSize = maxSize;
+		m_files = files;
+
+		m_file.open(path, std::ios::out | std::ios::app);
+
+		boost::system::error_code ec;
+		auto size = boost::filesystem::file_size(path, ec);
+		m_size = ec ? 0 : size;
+
+		return m_file.is_open();
+	}
+
+	void Logger::close()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (m_stop)
+			{
+				return;
+			}
+
+			m_stop = true;
+		}
+
+		m_cv.notify_one();
+		m_writer.join();
+
+		std::unique_lock<std::mutex> lock(m_fileMutex);
+
+		m_file.close();
+	}
+
+	Logger::Buffer& Logger::local()
+	{
+		thread_local Holder t_holder;
+
+		if (!t_holder.m_buffer)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			t_holder.m_buffer = std::make_shared<Buffer>(++m_nextThread);
+			m_buffers.push_back(t_holder.m_buffer);
+		}
+
+		return *t_holder.m_buffer;
+	}
+
+	void Logger::write(Level level, const char* component, const std::string& message)
+	{
+		auto& buffer = local();
+
+		auto tail = buffer.m_tail.load(std::memory_order_relaxed);
+
+		if (tail - buffer.m_head.load(std::memory_order_acquire) >= CAPACITY)
+		{
+			buffer.m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		auto& record = buffer.m_records[tail % CAPACITY];
+
+		record.m_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		record.m_level = level;
+		record.m_thread = buffer.m_thread;
+		record.m_component = component;
+		record.m_length = message.size() < MESSAGE ? message.size() : MESSAGE;
+		std::memcpy(record.m_message, message.data(), record.m_length);
+
+		buffer.m_tail.store(tail + 1, std::memory_order_release);
+	}
+
+	void Logger::run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (!m_stop)
+		{
+			m_cv.wait_for(lock, g_writeInterval, [this]() { return m_stop; });
+
+			lock.unlock();
+			drain();
+			lock.lock();
+		}
+	}
+
+	void Logger::drain()
+	{
+		std::unique_lock<std::mutex> fileLock(m_fileMutex);
+
+		if (!m_file.is_open())
+		{
+			return;
+		}
+
+		std::vector<std::shared_ptr<Buffer>> buffers;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			// A retired ring has no producer left, so once it is read it can go
+			buffers = m_buffers;
+
+			m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), [](const std::shared_ptr<Buffer>& buffer)
+			{
+				return buffer->m_retired.load(std::memory_order_acquire);
+			}), m_buffers.end());
+		}
+
+		std::vector<Record> records;
+		std::vector<std::pair<unsigned int, unsigned long long>> dropped;
+
+		for (auto& buffer : buffers)
+		{
+			auto head = buffer->m_head.load(std::memory_order_relaxed);
+			auto tail = buffer->m_tail.load(std::memory_order_acquire);
+
+			for (auto i = head; i < tail; ++i)
+			{
+				records.push_back(buffer->m_records[i % CAPACITY]);
+			}
+
+			buffer->m_head.store(tail, std::memory_order_release);
+
+			auto lost = buffer->m_dropped.exchange(0, std::memory_order_relaxed);
+
+			if (lost > 0)
+			{
+				dropped.emplace_back(buffer->m_thread, lost);
+			}
+		}
+
+		std::stable_sort(records.begin(), records.end(), [](const Record& a, const Record& b)
+		{
+			return a.m_time < b.m_time;
+		});
+
+		std::stringstream ss;
+
+		for (auto& record : records)
+		{
+			format(ss, record.m_time);
+			ss << "\t" << name(record.m_level) << "\t" << record.m_thread << "\t" << record.m_component << "\t";
+			ss.write(record.m_message, record.m_length);
+			ss << "\n";
+		}
+
+		for (auto& lost : dropped)
+		{
+			format(ss, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+			ss << "\tWARNING\t" << lost.first << "\tLogger\tDropped " << lost.second << " records, the ring was full\n";
+		}
+
+		auto text = ss.str();
+
+		if (!text.empty())
+		{
+			m_file << text;
+			m_file.flush();
+
+			m_size += text.size();
+
+			if (m_maxSize > 0 && m_size >= m_maxSize)
+			{
+				rotate();
+			}
+		}
+	}
+
+	// Bling.log becomes Bling.log.1, Bling.log.1 becomes Bling.log.2 and the oldest goes
+	void Logger::rotate()
+	{
+		m_file.close();
+
+		boost::system::error_code ec;
+
+		if (m_files > 0)
+		{
+			boost::filesystem::remove(m_path + "." + std::to_string(m_files), ec);
+
+			for (auto i = m_files; i > 1; --i)
+			{
+				boost::filesystem::rename(m_path + "." + std::to_string(i - 1), m_path + "." + std::to_string(i), ec);
+			}
+
+			boost::filesystem::rename(m_path, m_path + ".1", ec);
+		}
+		else
+		{
+			boost::filesystem::remove(m_path, ec);
+		}
+
+		m_file.open(m_path, std::ios::out | std::ios::trunc);
+		m_size = 0;
+	}
+
+	Level parseLevel(const std::string& name, Level defaultLevel)
+	{
+		auto level = boost::algorithm::to_lower_copy(name);
+
+		if (level == "debug") return Level::DEBUG;
+		if (level == "info") return Level::INFO;
+		if (level == "warning") return Level::WARNING;
+		if (level == "error") return Level::FAILURE;
+
+		return defaultLevel;
+	}
+
+	std::string currentException()
+	{
+		try
+		{
+			throw;
+		}
+		catch (const std::exception& e)
+		{
+			return e.what();
+		}
+		catch (...)
+		{
+			return "unknown exception";
+		}
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Statements below this level are compiled out: 0 debug, 1 info, 2 warning, 3 error
+#ifndef BLING_LOG_LEVEL
+#define BLING_LOG_LEVEL 1
+#endif
+
+namespace desktop { namespace core { namespace utils { namespace logging {
+
+	// FAILURE rather than ERROR, which windows.h defines as a macro
+	enum class Level
+	{
+		DEBUG,
+		INFO,
+		WARNING,
+		FAILURE
+	};
+
+	// Each thread appends to its own ring without locking; a background thread drains the
+	// rings, orders the records by time and writes them, rotating the file by size. A full
+	// ring drops the record and the writer reports how many were lost.
+	class Logger
+	{
+	public:
+		static const std::size_t CAPACITY = 256;
+		static const std::size_t MESSAGE = 224;
+
+		static Logger& get();
+
+		// Records written before open are kept in the rings until they fill up
+		bool open(const std::string& path, std::uintmax_t maxSize, unsigned int files);
+		void close();
+
+		void setLevel(Level level)
+		{
+			m_level.store(static_cast<int>(level), std::memory_order_relaxed);
+		}
+
+		bool enabled(Level level) const
+		{
+			return static_cast<int>(level) >= m_level.load(std::memory_order_relaxed);
+		}
+
+		// Component must be a string literal, it is kept as a pointer. Longer messages are cut.
+		void write(Level level, const char* component, const std::string& message);
+	private:
+		struct Record
+		{
+			long long		m_time;
+			Level			m_level;
+			unsigned int	m_thread;
+			const char*		m_component;
+			std::size_t		m_length;
+			char			m_message[MESSAGE];
+		};
+
+		// Single producer, the owning thread, and single consumer, the writer
+		struct Buffer
+		{
+			explicit Buffer(unsigned int thread) : m_thread(thread) {}
+
+			const unsigned int					m_thread;
+			std::array<Record, CAPACITY>		m_records;
+			std::atomic<std::size_t>			m_head{0};
+			std::atomic<std::size_t>			m_tail{0};
+			std::atomic<unsigned long long>		m_dropped{0};
+			std::atomic<bool>					m_retired{false};
+		};
+
+		struct Holder
+		{
+			~Holder();
+
+			std::shared_ptr<Buffer>	m_buffer;
+		};
+
+		Logger();
+		Logger(const Logger&) = delete;
+		Logger& operator=(const Logger&) = delete;
+
+		Buffer& local();
+		void run();
+		void drain();
+		void rotate();
+	private:
+		std::atomic<int>						m_level;
+		std::mutex								m_mutex;
+		std::condition_variable					m_cv;
+		std::thread								m_writer;
+		bool									m_stop = false;
+		std::vector<std::shared_ptr<Buffer>>	m_buffers;
+		unsigned int							m_nextThread = 0;
+
+		std::mutex								m_fileMutex;
+		std::ofstream							m_file;
+		std::string								m_path;
+		std::uintmax_t							m_size = 0;
+		std::uintmax_t							m_maxSize = 0;
+		unsigned int							m_files = 0;
+	};
+
+	Level parseLevel(const std::string& name, Level defaultLevel);
+
+	// Message of the exception being handled; call it only inside a catch block
+	std::string currentException();
+}}}}
+
+#define BLING_LOG(level, component, message) \
+	do \
+	{ \
+		auto& bling_logger = ::desktop::core::utils::logging::Logger::get(); \
+		if (bling_logger.enabled(level)) \
+		{ \
+			std::ostringstream bling_log_stream; \
+			bling_log_stream << message; \
+			bling_logger.write(level, component, bling_log_stream.str()); \
+		} \
+	} while (false)
+
+#if BLING_LOG_LEVEL <= 0
+#define BLING_LOG_DEBUG(component, message) BLING_LOG(::desktop::core::utils::logging::Level::DEBUG, component, message)
+#else
+#define BLING_LOG_DEBUG(component, message) ((void)0)
+#endif
+
+#if BLING_LOG_LEVEL <= 1
+#define BLING_LOG_INFO(component, message) BLING_LOG(::desktop::core::utils::logging::Level::INFO, component, message)
+#else
+#define BLING_LOG_INFO(component, message) ((void)0)
+#endif
+
+#if BLING_LOG_LEVEL <= 2
+#define BLING_LOG_WARNING(component, message) BLING_LOG(::desktop::core::utils::logging::Level::WARNING, component, message)
+#else
+#define BLING_LOG_WARNING(component, message) ((void)0)
+#endif
+
+#if BLING_LOG_LEVEL <= 3
+#define BLING_LOG_ERROR(component, message) BLING_LOG(::desktop::core::utils::logging::Level::FAILURE, component, message)
+#else
+#define BLING_LOG_ERROR(component, message) ((void)0)
+#endif
\ No newline at end of file
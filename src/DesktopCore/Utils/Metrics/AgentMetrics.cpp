@@ -0,0 +1,12 @@
+#include "AgentMetrics.h"
+
+namespace desktop { namespace core { namespace utils { namespace metrics {
+
+	AgentMetrics::AgentMetrics(const std::string& agent, Registry& registry)
+	: m_runs(registry.counter("bling_agent_runs_total", "Periodic runs started by each agent", {{"agent", agent}}))
+	, m_failures(registry.counter("bling_agent_failures_total", "Errors caught by each agent, including the ones it recovered from", {{"agent", agent}}))
+	, m_duration(registry.histogram("bling_agent_run_duration_seconds", "Time taken by each periodic run", Histogram::Unit::MICROSECONDS, {{"agent", agent}}))
+	{
+
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Metrics.h"
+
+#include <string>
+
+namespace desktop { namespace core { namespace utils { namespace metrics {
+
+	// Runs, failures and run time of the periodic work of one agent. Failures count what
+	// the agent recovers from as well, so work given up in a catch (...) still shows.
+	class AgentMetrics
+	{
+	public:
+		explicit AgentMetrics(const std::string& agent, Registry& registry = Registry::get());
+
+		template<typename F>
+		void run(F&& f) const
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			m_runs.increment();
+
+			try
+			{
+				f();
+			}
+			catch (...)
+			{
+				m_failures.increment();
+				m_duration.observe(std::chrono::steady_clock::now() - start);
+				throw;
+			}
+
+			m_duration.observe(std::chrono::steady_clock::now() - start);
+		}
+
+		void failed() const
+		{
+			m_failures.increment();
+		}
+	private:
+		Counter&	m_runs;
+		Counter&	m_failures;
+		Histogram&	m_duration;
+	};
+}}}}
\ No newline at end of file
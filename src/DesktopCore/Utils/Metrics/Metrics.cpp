@@ -0,0 +1,269 @@
+#include "Metrics.h"
+
+#include "../Logging/Logger.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace desktop { namespace core { namespace utils { namespace metrics {
+
+	namespace
+	{
+		// 128us to 71 minutes, and 1KB to 4GB
+		const std::size_t g_firstMicroseconds = 7;
+		const std::size_t g_lastMicroseconds = 32;
+		const std::size_t g_firstBytes = 10;
+		const std::size_t g_lastBytes = 32;
+
+		std::string escape(const std::string& value)
+		{
+			std::string escaped;
+
+			for (auto c : value)
+			{
+				switch (c)
+				{
+					case '\\': escaped += "\\\\"; break;
+					case '"': escaped += "\\\""; break;
+					case '\n': escaped += "\\n"; break;
+					default: escaped += c;
+				}
+			}
+
+			return escaped;
+		}
+
+		std::string format(const Registry::LabelsType& labels, const std::string& extraName = "", const std::string& extraValue = "")
+		{
+			if (labels.empty() && extraName.empty())
+			{
+				return "";
+			}
+
+			std::stringstream ss;
+			ss << "{";
+
+			bool first = true;
+
+			for (auto& label : labels)
+			{
+				ss << (first ? "" : ",") << label.first << "=\"" << escape(label.second) << "\"";
+				first = false;
+			}
+
+			if (!extraName.empty())
+			{
+				ss << (first ? "" : ",") << extraName << "=\"" << extraValue << "\"";
+			}
+
+			ss << "}";
+
+			return ss.str();
+		}
+
+		std::string scaled(unsigned long long value, Histogram::Unit unit)
+		{
+			std::stringstream ss;
+
+			if (unit == Histogram::Unit::MICROSECONDS)
+			{
+				ss << value / 1000000 << "." << std::string(6 - std::to_string(value % 1000000).size(), '0') << value % 1000000;
+			}
+			else
+			{
+				ss << value;
+			}
+
+			return ss.str();
+		}
+	}
+
+	Histogram::Histogram(Unit unit)
+	: m_unit(unit)
+	{
+		for (auto& bucket : m_buckets)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void Histogram::observe(unsigned long long value)
+	{
+		std::size_t bucket = 0;
+
+		while (bucket < BUCKETS - 1 && value > (1ULL << bucket))
+		{
+			++bucket;
+		}
+
+		m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+		m_sum.fetch_add(value, std::memory_order_relaxed);
+		m_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Registry& Registry::get()
+	{
+		static Registry S;
+		return S;
+	}
+
+	Registry::Family& Registry::family(const std::string& name, const std::string& help, Type type)
+	{
+		auto found = m_families.find(name);
+
+		if (found == m_families.end())
+		{
+			found = m_families.emplace(name, Family()).first;
+			found->second.m_type = type;
+			found->second.m_help = help;
+		}
+		else if (found->second.m_type != type)
+		{
+			throw std::logic_error("Metric " + name + " already registered with another type");
+		}
+
+		return found->second;
+	}
+
+	Counter& Registry::counter(const std::string& name, const std::string& help, const LabelsType& labels)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto& counter = family(name, help, Type::COUNTER).m_counters[labels];
+
+		if (!counter)
+		{
+			counter = std::make_unique<Counter>();
+		}
+
+		return *counter;
+	}
+
+	Gauge& Registry::gauge(const std::string& name, const std::string& help, const LabelsType& labels)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto& gauge = family(name, help, Type::GAUGE).m_gauges[labels];
+
+		if (!gauge)
+		{
+			gauge = std::make_unique<Gauge>();
+		}
+
+		return *gauge;
+	}
+
+	Histogram& Registry::histogram(const std::string& name, const std::string& help, Histogram::Unit unit, const LabelsType& labels)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto& histogram = family(name, help, Type::HISTOGRAM).m_histograms[labels];
+
+		if (!histogram)
+		{
+			histogram = std::make_unique<Histogram>(unit);
+		}
+
+		return *histogram;
+	}
+
+	void Registry::sample(const std::string& name, const std::string& help, SampleType sample, const LabelsType& labels)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		family(name, help, Type::GAUGE).m_samples[labels] = std::move(sample);
+	}
+
+	std::string Registry::render() const
+	{
+		std::stringstream ss;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		for (auto& pair : m_families)
+		{
+			auto& name = pair.first;
+			auto& family = pair.second;
+
+			ss << "# HELP " << name << " " << family.m_help << "\n";
+
+			switch (family.m_type)
+			{
+				case Type::COUNTER:
+				{
+					ss << "# TYPE " << name << " counter\n";
+
+					for (auto& counter : family.m_counters)
+					{
+						ss << name << format(counter.first) << " " << counter.second->value() << "\n";
+					}
+
+					break;
+				}
+				case Type::GAUGE:
+				{
+					ss << "# TYPE " << name << " gauge\n";
+
+					for (auto& gauge : family.m_gauges)
+					{
+						ss << name << format(gauge.first) << " " << gauge.second->value() << "\n";
+					}
+
+					for (auto& sample : family.m_samples)
+					{
+						double value = 0;
+
+						try
+						{
+							value = sample.second();
+						}
+						catch (...)
+						{
+							BLING_LOG_WARNING("Metrics", "Sample " << name << " failed: " << logging::currentException());
+						}
+
+						ss << name << format(sample.first) << " " << value << "\n";
+					}
+
+					break;
+				}
+				case Type::HISTOGRAM:
+				{
+					ss << "# TYPE " << name << " histogram\n";
+
+					for (auto& pair : family.m_histograms)
+					{
+						auto& histogram = *pair.second;
+						bool seconds = histogram.unit() == Histogram::Unit::MICROSECONDS;
+
+						auto first = seconds ? g_firstMicroseconds : g_firstBytes;
+						auto last = seconds ? g_lastMicroseconds : g_lastBytes;
+
+						unsigned long long cumulative = 0;
+
+						for (std::size_t i = 0; i <= last; ++i)
+						{
+							cumulative += histogram.bucket(i);
+
+							if (i >= first)
+							{
+								ss << name << "_bucket" << format(pair.first, "le", scaled(1ULL << i, histogram.unit())) << " " << cumulative << "\n";
+							}
+						}
+
+						// Read last, so +Inf is never below a bucket that was counted earlier
+						auto count = histogram.count();
+
+						ss << name << "_bucket" << format(pair.first, "le", "+Inf") << " " << (count > cumulative ? count : cumulative) << "\n";
+						ss << name << "_sum" << format(pair.first) << " " << scaled(histogram.sum(), histogram.unit()) << "\n";
+						ss << name << "_count" << format(pair.first) << " " << (count > cumulative ? count : cumulative) << "\n";
+					}
+
+					break;
+				}
+			}
+		}
+
+		return ss.str();
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace desktop { namespace core { namespace utils { namespace metrics {
+
+	class Counter
+	{
+	public:
+		void increment(unsigned long long value = 1)
+		{
+			m_value.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		unsigned long long value() const
+		{
+			return m_value.load(std::memory_order_relaxed);
+		}
+	private:
+		std::atomic<unsigned long long>	m_value{0};
+	};
+
+	class Gauge
+	{
+	public:
+		void set(long long value)
+		{
+			m_value.store(value, std::memory_order_relaxed);
+		}
+
+		void increment(long long value = 1)
+		{
+			m_value.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		void decrement(long long value = 1)
+		{
+			m_value.fetch_sub(value, std::memory_order_relaxed);
+		}
+
+		long long value() const
+		{
+			return m_value.load(std::memory_order_relaxed);
+		}
+	private:
+		std::atomic<long long>	m_value{0};
+	};
+
+	// Bucket i counts values up to 2^i units, so the relative error stays the same from
+	// microseconds to hours. Only the buckets between m_first and m_last are exported.
+	class Histogram
+	{
+	public:
+		static const std::size_t BUCKETS = 42;
+
+		enum class Unit
+		{
+			MICROSECONDS,	// exported in seconds
+			BYTES
+		};
+
+		explicit Histogram(Unit unit);
+
+		void observe(unsigned long long value);
+
+		void observe(std::chrono::steady_clock::duration elapsed)
+		{
+			observe(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+		}
+
+		Unit unit() const { return m_unit; }
+		unsigned long long count() const { return m_count.load(std::memory_order_relaxed); }
+		unsigned long long sum() const { return m_sum.load(std::memory_order_relaxed); }
+		unsigned long long bucket(std::size_t index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+	private:
+		const Unit												m_unit;
+		std::array<std::atomic<unsigned long long>, BUCKETS>	m_buckets;
+		std::atomic<unsigned long long>							m_count{0};
+		std::atomic<unsigned long long>							m_sum{0};
+	};
+
+	// Process wide metrics in the Prometheus text format. Looking a metric up takes a lock,
+	// updating it is a relaxed atomic; metrics live as long as the process, so callers keep
+	// the reference instead of looking it up again.
+	class Registry
+	{
+	public:
+		typedef std::map<std::string, std::string> LabelsType;
+		typedef std::function<double()> SampleType;
+
+		static Registry& get();
+
+		// Throw std::logic_error when the name is already used by another kind of metric
+		Counter& counter(const std::string& name, const std::string& help, const LabelsType& labels = {});
+		Gauge& gauge(const std::string& name, const std::string& help, const LabelsType& labels = {});
+		Histogram& histogram(const std::string& name, const std::string& help, Histogram::Unit unit, const LabelsType& labels = {});
+
+		// A gauge read when the metrics are rendered, for values owned by someone else. It runs
+		// under the registry lock, so it must not look metrics up.
+		void sample(const std::string& name, const std::string& help, SampleType sample, const LabelsType& labels = {});
+
+		std::string render() const;
+	private:
+		enum class Type
+		{
+			COUNTER,
+			GAUGE,
+			HISTOGRAM
+		};
+
+		struct Family
+		{
+			Type										m_type;
+			std::string									m_help;
+			std::map<LabelsType, std::unique_ptr<Counter>>		m_counters;
+			std::map<LabelsType, std::unique_ptr<Gauge>>		m_gauges;
+			std::map<LabelsType, SampleType>					m_samples;
+			std::map<LabelsType, std::unique_ptr<Histogram>>	m_histograms;
+		};
+
+		Registry() = default;
+		Registry(const Registry&) = delete;
+		Registry& operator=(const Registry&) = delete;
+
+		Family& family(const std::string& name, const std::string& help, Type type);
+	private:
+		std::map<std::string, Family>	m_families;
+		mutable std::mutex				m_mutex;
+	};
+}}}}
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include "Event.h"
 
+#include <sstream>
+#include <stdexcept>
+
 namespace desktop { namespace core { namespace utils { namespace patterns {
 
 	Broker& Broker::get()
@@ -10,47 +13,172 @@ namespace desktop { namespace core { namespace utils { namespace patterns {
         return S;
     }
     
-	Broker::Broker() = default;
+	Broker::Broker()
+	: m_untyped(std::make_shared<std::atomic<unsigned int>>(0))
+	{
+		for (auto& slot : m_table)
+		{
+			slot.store(nullptr, std::memory_order_relaxed);
+		}
+	}
 
 	Broker::~Broker()
 	{
 		std::unique_lock<std::mutex> lock(m_mutexSubscriptions);
 
-		TStrSubscriberMap::iterator it = m_subscriptions.begin();
-		while(it != m_subscriptions.end())
+		for (auto& slot : m_table)
 		{
-			it->second.reset();
-			++it;
+			slot.store(nullptr, std::memory_order_relaxed);
 		}
-        
-		m_subscriptions.clear();
+
+		m_slots.clear();
+	}
+
+	Broker::SignalType* Broker::findSignal(const EventType& evtName) const
+	{
+		for (std::size_t i = 0, index = evtName % TABLE_SIZE; i < TABLE_SIZE; ++i, index = (index + 1) % TABLE_SIZE)
+		{
+			Slot* slot = m_table[index].load(std::memory_order_acquire);
+
+			if (!slot)
+			{
+				return nullptr;
+			}
+			else if (slot->m_name == evtName)
+			{
+				return &slot->m_signal;
+			}
+		}
+
+		return nullptr;
 	}
 
 	Broker::SignalType& Broker::getSignal(const EventType& evtName)
 	{
 		std::unique_lock<std::mutex> lock(m_mutexSubscriptions);
 		
-		TStrSubscriberMap::iterator it = m_subscriptions.find(evtName);
+		if (auto signal = findSignal(evtName))
+		{
+			return *signal;
+		}
 
-		if(it == m_subscriptions.end())
+		for (std::size_t i = 0, index = evtName % TABLE_SIZE; i < TABLE_SIZE; ++i, index = (index + 1) % TABLE_SIZE)
 		{
-			m_subscriptions[evtName] = std::make_unique<SignalType>();
-            return *m_subscriptions[evtName];
+			if (!m_table[index].load(std::memory_order_relaxed))
+			{
+				m_slots.push_back(std::make_unique<Slot>(evtName));
+				m_table[index].store(m_slots.back().get(), std::memory_order_release);
+
+				return m_slots.back()->m_signal;
+			}
 		}
-		else
+
+		throw std::runtime_error("Broker subscription table is full");
+	}
+
+	Broker::ConnectionType::ConnectionType(boost::signals2::connection connection, std::shared_ptr<Guard> guard, std::shared_ptr<std::atomic<unsigned int>> connected)
+	: m_connection(connection)
+	, m_guard(guard)
+	, m_connected(connected)
+	{
+		m_connected->fetch_add(1);
+	}
+
+	Broker::ConnectionType::~ConnectionType()
+	{
+		disconnect();
+	}
+
+	void Broker::ConnectionType::disconnect()
+	{
+		m_connection.disconnect();
+
+		std::unique_lock<std::recursive_mutex> lock(m_guard->m_mutex);
+
+		if (m_guard->m_connected)
 		{
-			return *it->second;
+			m_guard->m_connected = false;
+			m_connected->fetch_sub(1);
 		}
 	}
 
-	std::unique_ptr<Broker::ConnectionType> Broker::subscribe(CallbackType cb, const EventType& evtName)
+	std::unique_ptr<Broker::ConnectionType> Broker::subscribe(const std::string& name, CallbackType cb, const EventType& evtName, const DeliveryPolicy& policy)
 	{
 		SignalType& signal = getSignal(evtName);
-		return std::make_unique<ConnectionType>(signal.connect(cb));
+
+		auto guard = std::make_shared<ConnectionType::Guard>();
+
+		std::stringstream event;
+		event << "0x" << std::hex << evtName;
+
+		auto stats = &Instrumentation::get().handlerStats(event.str(), name);
+
+		auto deliver = [cb, guard, stats](const Event& evt)
+		{
+			std::unique_lock<std::recursive_mutex> lock(guard->m_mutex);
+
+			if (guard->m_connected)
+			{
+				Instrumentation::get().time(*stats, [&cb, &evt]()
+				{
+					cb(evt);
+				});
+			}
+		};
+
+		auto executor = policy.m_mode == DeliveryPolicy::Mode::Executor ? findExecutor(policy.m_executor) : nullptr;
+
+		if (executor)
+		{
+			auto overflow = policy.m_overflow;
+
+			return std::make_unique<ConnectionType>(signal.connect([deliver, executor, overflow](const Event&, const CopyType& copy)
+			{
+				auto evt = copy();
+
+				executor->post([deliver, evt]()
+				{
+					deliver(*evt);
+				}, overflow);
+			}), guard, m_untyped);
+		}
+		else
+		{
+			return std::make_unique<ConnectionType>(signal.connect([deliver](const Event& evt, const CopyType&)
+			{
+				deliver(evt);
+			}), guard, m_untyped);
+		}
 	}
 
-	void Broker::publish(const Event& evt)
+	void Broker::publish(const Event& evt, const CopyType& copy)
 	{
-		getSignal(evt.m_name)(evt);
+		if (auto signal = findSignal(evt.m_name))
+		{
+			(*signal)(evt, copy);
+		}
+	}
+
+	void Broker::registerExecutor(const std::string& name, std::shared_ptr<IExecutor> executor)
+	{
+		std::unique_lock<std::mutex> lock(m_mutexExecutors);
+
+		m_executors[name] = executor;
+	}
+
+	void Broker::unregisterExecutor(const std::string& name)
+	{
+		std::unique_lock<std::mutex> lock(m_mutexExecutors);
+
+		m_executors.erase(name);
+	}
+
+	std::shared_ptr<IExecutor> Broker::findExecutor(const std::string& name)
+	{
+		std::unique_lock<std::mutex> lock(m_mutexExecutors);
+
+		auto it = m_executors.find(name);
+
+		return it != m_executors.end() ? it->second : nullptr;
 	}
 }}}}
\ No newline at end of file
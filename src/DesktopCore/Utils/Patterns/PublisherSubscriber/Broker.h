@@ -1,26 +1,107 @@
 #pragma once
 
 #include "Event.h"
+#include "DeliveryPolicy.h"
+#include "Instrumentation.h"
 
 #include <boost/signals2/signal.hpp>
+#include <array>
+#include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
 
 namespace desktop { namespace core { namespace utils { namespace patterns {
 	class Subscriber;
 	struct Event;
 
+	template<typename EventT>
+	class Channel;
+
 	class Broker
 	{
 	public:
-		typedef  boost::signals2::scoped_connection ConnectionType;
 		typedef std::function<void (const Event&)> CallbackType;
+		typedef std::function<std::shared_ptr<const Event>()> CopyType;
+
+		// Disconnects the slot and waits for a running delivery of it to finish, so no
+		// callback runs after the connection is gone, even from an executor queue.
+		class ConnectionType
+		{
+		public:
+			struct Guard
+			{
+				// Held while the handler runs and while disconnecting; publishers only read m_connected
+				std::recursive_mutex	m_mutex;
+				std::atomic<bool>		m_connected{ true };
+			};
+
+			ConnectionType(boost::signals2::connection connection, std::shared_ptr<Guard> guard, std::shared_ptr<std::atomic<unsigned int>> connected);
+			~ConnectionType();
+			void disconnect();
+		private:
+			boost::signals2::scoped_connection			m_connection;
+			std::shared_ptr<Guard>						m_guard;
+			std::shared_ptr<std::atomic<unsigned int>>	m_connected;
+		};
+
 		void unsubscribe(CallbackType cb, const EventType& evtName);
-		std::unique_ptr<ConnectionType> subscribe(CallbackType cb, const EventType& evtName);
-		void publish(const Event& evt);
+		std::unique_ptr<ConnectionType> subscribe(const std::string& name, CallbackType cb, const EventType& evtName, const DeliveryPolicy& policy = DeliveryPolicy::inlined());
+
+		// Delivers to the typed Channel<EventT> first, then to untyped subscriptions by id.
+		// Events are copied only when a subscription delivers them on an executor
+		template<typename EventT>
+		void publish(const EventT& evt)
+		{
+			static_assert(!std::is_same<EventT, Event>::value, "publish the concrete event type so it reaches its Channel");
+
+			static auto& stats = Instrumentation::get().eventStats(typeid(EventT).name());
+			Instrumentation::get().countPublish(stats);
+
+			Channel<EventT>::get().publish(evt);
+
+			// Untyped subscriptions are rare; without one the signals are not even looked up
+			if (m_untyped->load(std::memory_order_acquire) == 0)
+			{
+				return;
+			}
+
+			std::shared_ptr<const Event> copy;
+
+			publish(evt, [&evt, &copy]()
+			{
+				if (!copy)
+				{
+					copy = std::make_shared<const EventT>(evt);
+				}
+
+				return copy;
+			});
+		}
+
+		void publish(const Event& evt, const CopyType& copy);
+
+		void registerExecutor(const std::string& name, std::shared_ptr<IExecutor> executor);
+		void unregisterExecutor(const std::string& name);
+		std::shared_ptr<IExecutor> findExecutor(const std::string& name);
+
         static Broker& get();
 	private:
-		typedef boost::signals2::signal<void (const Event&)> SignalType;
+		typedef boost::signals2::signal<void (const Event&, const CopyType&)> SignalType;
+
+		struct Slot
+		{
+			Slot(EventType evtName) : m_name(evtName) {}
+
+			EventType	m_name;
+			SignalType	m_signal;
+		};
+
+		static const std::size_t TABLE_SIZE = 256;
+
 		Broker();
 		Broker(const Broker &);
 		~Broker();
@@ -28,10 +109,20 @@ namespace desktop { namespace core { namespace utils { namespace patterns {
 		Broker * operator&() = delete;
         
 		SignalType& getSignal(const EventType& evtName);
+		SignalType* findSignal(const EventType& evtName) const;
 	private:
-		typedef std::map<EventType, std::unique_ptr<SignalType>> TStrSubscriberMap;
-		
-        TStrSubscriberMap m_subscriptions;
-		std::mutex m_mutexSubscriptions;
+		// Open addressing table indexed by event id. Slots are only ever added (under
+		// m_mutexSubscriptions) and never moved, so publish() can probe it without locking.
+		std::array<std::atomic<Slot*>, TABLE_SIZE>	m_table;
+		std::vector<std::unique_ptr<Slot>>			m_slots;
+		std::mutex									m_mutexSubscriptions;
+
+		// Live connections made by subscribe(); shared with them because they can outlive the Broker
+		std::shared_ptr<std::atomic<unsigned int>>	m_untyped;
+
+		std::map<std::string, std::shared_ptr<IExecutor>>	m_executors;
+		std::mutex											m_mutexExecutors;
 	};
-}}}}
\ No newline at end of file
+}}}}
+
+#include "Channel.h"
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	template<typename Signature, std::size_t Capacity = 4 * sizeof(void*)>
+	class Callable;
+
+	// Move-only std::function replacement. Callables up to Capacity bytes (the usual
+	// [this] or [this, value] lambdas) are stored inline, so no heap allocation is made
+	// per subscription and invoking costs one indirect call.
+	template<typename R, typename... Args, std::size_t Capacity>
+	class Callable<R (Args...), Capacity>
+	{
+	public:
+		Callable() = default;
+
+		template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Callable>::value>::type>
+		Callable(F&& f)
+		{
+			construct<typename std::decay<F>::type>(std::forward<F>(f));
+		}
+
+		Callable(Callable&& other)
+		{
+			moveFrom(other);
+		}
+
+		Callable& operator=(Callable&& other)
+		{
+			if (this != &other)
+			{
+				reset();
+				moveFrom(other);
+			}
+
+			return *this;
+		}
+
+		Callable(const Callable&) = delete;
+		Callable& operator=(const Callable&) = delete;
+
+		~Callable()
+		{
+			reset();
+		}
+
+		R operator()(Args... args) const
+		{
+			return m_ops->m_invoke(const_cast<void*>(static_cast<const void*>(&m_storage)), std::forward<Args>(args)...);
+		}
+
+		explicit operator bool() const
+		{
+			return m_ops != nullptr;
+		}
+	private:
+		struct Ops
+		{
+			R (*m_invoke)(void*, Args&&...);
+			void (*m_move)(void*, void*);
+			void (*m_destroy)(void*);
+		};
+
+		template<typename F>
+		struct Inline
+		{
+			static F& target(void* storage) { return *static_cast<F*>(storage); }
+			static R invoke(void* storage, Args&&... args) { return target(storage)(std::forward<Args>(args)...); }
+			static void move(void* dst, void* src) { new (dst) F(std::move(target(src))); target(src).~F(); }
+			static void destroy(void* storage) { target(storage).~F(); }
+		};
+
+		template<typename F>
+		struct Heap
+		{
+			static F*& target(void* storage) { return *static_cast<F**>(storage); }
+			static R invoke(void* storage, Args&&... args) { return (*target(storage))(std::forward<Args>(args)...); }
+			static void move(void* dst, void* src) { new (dst) F*(target(src)); }
+			static void destroy(void* storage) { delete target(storage); }
+		};
+
+		template<typename F>
+		struct Fits : std::integral_constant<bool, sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<F>::value>
+		{
+		};
+
+		template<typename F, typename G>
+		typename std::enable_if<Fits<F>::value>::type construct(G&& f)
+		{
+			static const Ops ops = { &Inline<F>::invoke, &Inline<F>::move, &Inline<F>::destroy };
+
+			new (&m_storage) F(std::forward<G>(f));
+			m_ops = &ops;
+		}
+
+		template<typename F, typename G>
+		typename std::enable_if<!Fits<F>::value>::type construct(G&& f)
+		{
+			static const Ops ops = { &Heap<F>::invoke, &Heap<F>::move, &Heap<F>::destroy };
+
+			new (&m_storage) F*(new F(std::forward<G>(f)));
+			m_ops = &ops;
+		}
+
+		void moveFrom(Callable& other)
+		{
+			if (other.m_ops)
+			{
+				other.m_ops->m_move(&m_storage, &other.m_storage);
+				m_ops = other.m_ops;
+				other.m_ops = nullptr;
+			}
+		}
+
+		void reset()
+		{
+			if (m_ops)
+			{
+				m_ops->m_destroy(&m_storage);
+				m_ops = nullptr;
+			}
+		}
+	private:
+		typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type	m_storage;
+		const Ops*																	m_ops = nullptr;
+	};
+}}}}
\ No newline at end of file
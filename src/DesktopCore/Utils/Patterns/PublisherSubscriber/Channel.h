@@ -0,0 +1,252 @@
+#pragma once
+
+#include "Broker.h"
+#include "Callable.h"
+#include "DeliveryPolicy.h"
+#include "Instrumentation.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <vector>
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	class ChannelConnection
+	{
+	public:
+		virtual ~ChannelConnection() = default;
+		virtual void disconnect() = 0;
+	};
+
+	// Statically typed event channel, one per event type. Handlers receive the concrete
+	// event so no downcast is needed. Slots hold a small buffer callable and are published
+	// from an immutable snapshot, so publishing neither locks the channel nor allocates for
+	// inline handlers.
+	template<typename EventT>
+	class Channel
+	{
+	public:
+		// Handed to each slot of one publish; the event is copied at most once, and only
+		// when a slot delivers it on an executor.
+		class Delivery
+		{
+		public:
+			explicit Delivery(const EventT& evt)
+			: m_event(evt)
+			{
+
+			}
+
+			const EventT& event() const
+			{
+				return m_event;
+			}
+
+			std::shared_ptr<const EventT> copy()
+			{
+				if (!m_copy)
+				{
+					m_copy = std::make_shared<const EventT>(m_event);
+				}
+
+				return m_copy;
+			}
+		private:
+			const EventT&					m_event;
+			std::shared_ptr<const EventT>	m_copy;
+		};
+
+		typedef Callable<void (Delivery&)> SlotType;
+		typedef Broker::ConnectionType::Guard GuardType;
+	private:
+		struct Node
+		{
+			Node(SlotType slot, std::shared_ptr<GuardType> guard)
+			: m_slot(std::move(slot))
+			, m_guard(guard)
+			{
+
+			}
+
+			SlotType					m_slot;
+			std::shared_ptr<GuardType>	m_guard;
+		};
+
+		typedef std::vector<std::shared_ptr<Node>> SnapshotType;
+	public:
+		// Disconnects on destruction. Once disconnect() returns the handler is not running
+		// and will not run again, including deliveries still queued on an executor.
+		class ConnectionType : public ChannelConnection
+		{
+		public:
+			ConnectionType(Channel& channel, std::shared_ptr<Node> node)
+			: m_channel(channel)
+			, m_node(std::move(node))
+			{
+
+			}
+
+			~ConnectionType()
+			{
+				disconnect();
+			}
+
+			void disconnect() override
+			{
+				if (m_node)
+				{
+					m_channel.disconnect(m_node);
+					m_node.reset();
+				}
+			}
+		private:
+			Channel&				m_channel;
+			std::shared_ptr<Node>	m_node;
+		};
+
+		// Never destroyed, so connections held by other singletons can still disconnect
+		// during static destruction
+		static Channel& get()
+		{
+			static Channel* S = new Channel();
+			return *S;
+		}
+
+		// name identifies the handler in the statistics and the slow handler warnings
+		template<typename CallbackT>
+		std::unique_ptr<ConnectionType> subscribe(const std::string& name, CallbackT cb, const DeliveryPolicy& policy = DeliveryPolicy::inlined())
+		{
+			auto guard = std::make_shared<GuardType>();
+			auto stats = &Instrumentation::get().handlerStats(typeid(EventT).name(), name);
+			auto executor = policy.m_mode == DeliveryPolicy::Mode::Executor ? Broker::get().findExecutor(policy.m_executor) : nullptr;
+
+			if (executor)
+			{
+				auto overflow = policy.m_overflow;
+
+				return connect(SlotType([cb, guard, stats, executor, overflow](Delivery& delivery)
+				{
+					auto evt = delivery.copy();
+
+					executor->post([cb, guard, stats, evt]()
+					{
+						std::unique_lock<std::recursive_mutex> lock(guard->m_mutex);
+
+						if (guard->m_connected)
+						{
+							Instrumentation::get().time(*stats, [&cb, &evt]()
+							{
+								cb(*evt);
+							});
+						}
+					}, overflow);
+				}), guard);
+			}
+			else
+			{
+				return connect(SlotType([cb, guard, stats](Delivery& delivery)
+				{
+					std::unique_lock<std::recursive_mutex> lock(guard->m_mutex);
+
+					if (guard->m_connected)
+					{
+						Instrumentation::get().time(*stats, [&cb, &delivery]()
+						{
+							cb(delivery.event());
+						});
+					}
+				}), guard);
+			}
+		}
+
+		void publish(const EventT& evt)
+		{
+			// Most events have no subscriber, which costs them this load and nothing else
+			if (m_count.load(std::memory_order_acquire) == 0)
+			{
+				return;
+			}
+
+			// Connections made during the publish get the next event; a disconnected node
+			// is skipped by its guard and lives until the snapshot goes away. Only the slot
+			// that runs the handler takes the guard mutex, so posting to an executor never
+			// waits for a handler running there.
+			auto snapshot = std::atomic_load(&m_snapshot);
+			Delivery delivery(evt);
+
+			for (auto& node : *snapshot)
+			{
+				if (node->m_guard->m_connected.load(std::memory_order_acquire))
+				{
+					node->m_slot(delivery);
+				}
+			}
+		}
+
+		bool empty() const
+		{
+			return m_count.load(std::memory_order_acquire) == 0;
+		}
+	private:
+		Channel()
+		: m_snapshot(std::make_shared<const SnapshotType>())
+		{
+
+		}
+
+		Channel(const Channel&) = delete;
+		Channel& operator=(const Channel&) = delete;
+
+		std::unique_ptr<ConnectionType> connect(SlotType slot, std::shared_ptr<GuardType> guard)
+		{
+			auto node = std::make_shared<Node>(std::move(slot), guard);
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			auto snapshot = std::make_shared<SnapshotType>(*m_snapshot);
+			snapshot->push_back(node);
+
+			replace(snapshot);
+
+			return std::make_unique<ConnectionType>(*this, node);
+		}
+
+		void disconnect(const std::shared_ptr<Node>& node)
+		{
+			{
+				std::unique_lock<std::recursive_mutex> guard(node->m_guard->m_mutex);
+				node->m_guard->m_connected = false;
+			}
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			auto snapshot = std::make_shared<SnapshotType>();
+			snapshot->reserve(m_snapshot->size());
+
+			for (auto& other : *m_snapshot)
+			{
+				if (other != node)
+				{
+					snapshot->push_back(other);
+				}
+			}
+
+			replace(snapshot);
+		}
+
+		// m_mutex must be held
+		void replace(std::shared_ptr<const SnapshotType> snapshot)
+		{
+			m_count.store(snapshot->size(), std::memory_order_release);
+			std::atomic_store(&m_snapshot, snapshot);
+		}
+	private:
+		// Only connect and disconnect take m_mutex, to build the next snapshot; publish reads
+		// the current one without locking
+		std::shared_ptr<const SnapshotType>	m_snapshot;
+		std::atomic<std::size_t>			m_count{ 0 };
+		std::mutex							m_mutex;
+	};
+}}}}
\ No newline at end of file
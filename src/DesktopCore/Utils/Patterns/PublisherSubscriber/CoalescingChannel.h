@@ -0,0 +1,176 @@
+#pragma once
+
+#include "Broker.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <condition_variable>
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	// Keeps only the latest event per key and publishes it at most once per interval.
+	// update() edits the pending event in place under a lock, so an intermediate update
+	// costs a map lookup and a few field writes; the Broker only sees the coalesced value.
+	// Events reach inline subscribers on the worker thread of the channel, or on the
+	// thread calling flush(); handlers must not call flush() themselves.
+	template<typename EventT, typename KeyT = unsigned int>
+	class CoalescingChannel
+	{
+	public:
+		CoalescingChannel(std::chrono::milliseconds interval, Broker& broker = Broker::get())
+		: m_interval(interval)
+		, m_broker(broker)
+		{
+			m_worker = std::thread(&CoalescingChannel::run, this);
+		}
+
+		~CoalescingChannel()
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+
+			m_cv.notify_one();
+
+			if (m_worker.joinable())
+			{
+				m_worker.join();
+			}
+		}
+
+		// Applies fill(EventT&) to the pending event of key. The event keeps the fields of
+		// the previous update, so fill only needs to write what changed.
+		template<typename FillT>
+		void update(const KeyT& key, FillT fill)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			auto& entry = m_entries[key];
+
+			fill(entry.m_event);
+
+			if (!entry.m_dirty)
+			{
+				entry.m_dirty = true;
+				m_cv.notify_one();
+			}
+		}
+
+		// Publishes the pending event of key right away and forgets the key. Used for
+		// terminal states which must not be delayed or merged with later updates.
+		void flush(const KeyT& key)
+		{
+			// An event the worker is about to publish goes out before this one
+			std::unique_lock<std::mutex> publishing(m_publishing);
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			auto it = m_entries.find(key);
+
+			if (it != m_entries.end())
+			{
+				bool dirty = it->second.m_dirty;
+				EventT evt = std::move(it->second.m_event);
+				m_entries.erase(it);
+
+				lock.unlock();
+
+				// The worker may just have published this same state
+				if (dirty)
+				{
+					m_broker.publish(evt);
+				}
+			}
+		}
+	private:
+		struct Entry
+		{
+			EventT									m_event;
+			bool									m_dirty = false;
+			std::chrono::steady_clock::time_point	m_published;
+		};
+
+		void run()
+		{
+			std::unique_lock<std::mutex> publishing(m_publishing, std::defer_lock);
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			while (!m_stop)
+			{
+				auto now = std::chrono::steady_clock::now();
+				auto next = now + m_interval;
+				bool pending = false;
+				auto due = m_entries.end();
+
+				for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+				{
+					auto& entry = it->second;
+
+					if (!entry.m_dirty)
+					{
+						continue;
+					}
+
+					if (now - entry.m_published >= m_interval)
+					{
+						due = it;
+						break;
+					}
+					else if (entry.m_published + m_interval < next)
+					{
+						next = entry.m_published + m_interval;
+					}
+
+					pending = true;
+				}
+
+				if (due != m_entries.end())
+				{
+					KeyT key = due->first;
+
+					// m_publishing is taken before m_mutex, like flush() does
+					lock.unlock();
+					publishing.lock();
+					lock.lock();
+
+					// flush() may have published and forgotten the key in the meantime
+					auto it = m_entries.find(key);
+
+					if (it != m_entries.end() && it->second.m_dirty)
+					{
+						EventT evt = it->second.m_event;
+
+						it->second.m_dirty = false;
+						it->second.m_published = now;
+
+						lock.unlock();
+						m_broker.publish(evt);
+						lock.lock();
+					}
+
+					publishing.unlock();
+				}
+				else if (pending)
+				{
+					m_cv.wait_until(lock, next);
+				}
+				else
+				{
+					m_cv.wait(lock);
+				}
+			}
+		}
+	private:
+		std::chrono::milliseconds			m_interval;
+		Broker&								m_broker;
+		std::unordered_map<KeyT, Entry>		m_entries;
+		std::mutex							m_mutex;
+		// Held around every publish, so the events of one key reach the Broker in order
+		std::mutex							m_publishing;
+		std::condition_variable				m_cv;
+		std::thread							m_worker;
+		bool								m_stop = false;
+	};
+}}}}
\ No newline at end of file
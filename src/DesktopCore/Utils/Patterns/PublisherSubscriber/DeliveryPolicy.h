@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Executor.h"
+
+#include <string>
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	const std::string CORE_EXECUTOR = "core";
+	const std::string UI_EXECUTOR = "ui";
+
+	// How a subscription receives events: on the publisher's thread, or copied and
+	// posted to a named executor registered in the Broker. Subscriptions to events
+	// published from CEF threads should keep DropOldest so the publisher never waits.
+	struct DeliveryPolicy
+	{
+		enum class Mode
+		{
+			Inline,
+			Executor
+		};
+
+		static DeliveryPolicy inlined()
+		{
+			return DeliveryPolicy(Mode::Inline, "", OverflowPolicy::DropOldest);
+		}
+
+		static DeliveryPolicy executor(const std::string& name, OverflowPolicy overflow = OverflowPolicy::DropOldest)
+		{
+			return DeliveryPolicy(Mode::Executor, name, overflow);
+		}
+
+		static DeliveryPolicy ui(OverflowPolicy overflow = OverflowPolicy::DropOldest)
+		{
+			return DeliveryPolicy(Mode::Executor, UI_EXECUTOR, overflow);
+		}
+
+		DeliveryPolicy(Mode mode, const std::string& executor, OverflowPolicy overflow)
+		: m_mode(mode)
+		, m_executor(executor)
+		, m_overflow(overflow)
+		{
+
+		}
+
+		Mode			m_mode;
+		std::string		m_executor;
+		OverflowPolicy	m_overflow;
+	};
+}}}}
\ No newline at end of file
@@ -3,7 +3,13 @@
 #include <string>
 
 namespace desktop { namespace core {namespace utils { namespace patterns {
-    typedef std::string EventType;
+    typedef unsigned long long EventType;
+
+    // FNV-1a of the event name, evaluated at compile time so events are dispatched by integer id
+    constexpr EventType makeEventType(const char* name, EventType hash = 14695981039346656037ULL)
+    {
+        return *name == '\0' ? hash : makeEventType(name + 1, (hash ^ static_cast<unsigned char>(*name)) * 1099511628211ULL);
+    }
 
     struct Event
     {
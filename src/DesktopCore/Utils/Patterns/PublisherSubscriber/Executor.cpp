@@ -0,0 +1,157 @@
+#include "Executor.h"
+
+#include "../../Logging/Logger.h"
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	QueueExecutor::QueueExecutor(std::size_t capacity)
+	: m_capacity(capacity)
+	{
+		m_worker = std::thread(&QueueExecutor::run, this);
+	}
+
+	QueueExecutor::~QueueExecutor()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_cv.notify_all();
+		m_worker.join();
+	}
+
+	bool QueueExecutor::post(TaskType task, OverflowPolicy overflow)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (overflow == OverflowPolicy::Backpressure)
+			{
+				m_cv.wait(lock, [this]() { return m_stop || m_tasks.size() < m_capacity; });
+			}
+			else if (m_tasks.size() >= m_capacity)
+			{
+				m_tasks.pop_front();
+			}
+
+			if (m_stop)
+			{
+				return false;
+			}
+
+			m_tasks.push_back(std::move(task));
+		}
+
+		m_cv.notify_all();
+
+		return true;
+	}
+
+	void QueueExecutor::run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (true)
+		{
+			m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+
+			if (m_stop)
+			{
+				break;
+			}
+
+			auto task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+
+			lock.unlock();
+			m_cv.notify_all();
+
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				BLING_LOG_ERROR("Executor", "Task failed: " << logging::currentException());
+			}
+
+			lock.lock();
+		}
+	}
+
+	SerialExecutor::SerialExecutor(std::shared_ptr<IExecutor> target, std::size_t capacity)
+	: m_target(target)
+	, m_capacity(capacity)
+	{
+
+	}
+
+	SerialExecutor::~SerialExecutor() = default;
+
+	bool SerialExecutor::post(TaskType task, OverflowPolicy overflow)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		if (overflow == OverflowPolicy::Backpressure)
+		{
+			m_cv.wait(lock, [this]() { return m_tasks.size() < m_capacity; });
+		}
+		else if (m_tasks.size() >= m_capacity)
+		{
+			m_tasks.pop_front();
+		}
+
+		m_tasks.push_back(std::move(task));
+
+		if (!m_scheduled)
+		{
+			auto self = shared_from_this();
+
+			m_scheduled = m_target->post([self]()
+			{
+				self->drain();
+			}, OverflowPolicy::Backpressure);
+
+			if (!m_scheduled)
+			{
+				m_tasks.pop_back();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void SerialExecutor::drain()
+	{
+		while (true)
+		{
+			TaskType task;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				if (m_tasks.empty())
+				{
+					m_scheduled = false;
+					return;
+				}
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+
+			m_cv.notify_all();
+
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				BLING_LOG_ERROR("Executor", "Task failed: " << logging::currentException());
+			}
+		}
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <memory>
+#include <condition_variable>
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	enum class OverflowPolicy
+	{
+		DropOldest,
+		Backpressure
+	};
+
+	class IExecutor
+	{
+	public:
+		typedef std::function<void()> TaskType;
+
+		virtual ~IExecutor() = default;
+		virtual bool post(TaskType task, OverflowPolicy overflow) = 0;
+	};
+
+	// Runs posted tasks in order on a single worker thread. When the queue is full the
+	// oldest task is dropped, or the poster waits for room if it asked for backpressure.
+	class QueueExecutor : public IExecutor
+	{
+	public:
+		QueueExecutor(std::size_t capacity = 1024);
+		~QueueExecutor();
+
+		bool post(TaskType task, OverflowPolicy overflow) override;
+	private:
+		void run();
+	private:
+		std::size_t					m_capacity;
+		std::deque<TaskType>		m_tasks;
+		std::mutex					m_mutex;
+		std::condition_variable		m_cv;
+		std::thread					m_worker;
+		bool						m_stop = false;
+	};
+
+	// Runs posted tasks one at a time and in order, borrowing a thread of another executor
+	// (usually the runtime pool) only while it has work. Same overflow rules as QueueExecutor.
+	class SerialExecutor : public IExecutor, public std::enable_shared_from_this<SerialExecutor>
+	{
+	public:
+		SerialExecutor(std::shared_ptr<IExecutor> target, std::size_t capacity = 1024);
+		~SerialExecutor();
+
+		bool post(TaskType task, OverflowPolicy overflow) override;
+	private:
+		void drain();
+	private:
+		std::shared_ptr<IExecutor>	m_target;
+		std::size_t					m_capacity;
+		std::deque<TaskType>		m_tasks;
+		std::mutex					m_mutex;
+		std::condition_variable		m_cv;
+		bool						m_scheduled = false;
+	};
+}}}}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "Instrumentation.h"
+
+#include "../../Logging/Logger.h"
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	namespace
+	{
+		const unsigned int g_defaultSampleRate = 16;
+		const unsigned long long g_defaultSlowThreshold = 100000;
+		const std::size_t g_recentSlow = 32;
+	}
+
+	Instrumentation::HandlerStats::HandlerStats(const std::string& event, const std::string& handler)
+	: m_event(event)
+	, m_handler(handler)
+	{
+		for (auto& bucket : m_histogram)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	Instrumentation& Instrumentation::get()
+	{
+		static Instrumentation S;
+		return S;
+	}
+
+	Instrumentation::Instrumentation()
+	: m_enabled(true)
+	, m_sampleRate(g_defaultSampleRate)
+	, m_slowThreshold(g_defaultSlowThreshold)
+	, m_slowCallback([](const SlowHandler& slow)
+	{
+		BLING_LOG_WARNING("Broker", slow.m_handler << " took " << slow.m_microseconds / 1000 << "ms to handle " << slow.m_event);
+	})
+	{
+
+	}
+
+	void Instrumentation::setEnabled(bool enabled)
+	{
+		m_enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	void Instrumentation::setSampleRate(unsigned int rate)
+	{
+		m_sampleRate.store(rate ? rate : 1, std::memory_order_relaxed);
+	}
+
+	void Instrumentation::setSlowThreshold(std::chrono::microseconds threshold)
+	{
+		m_slowThreshold.store(threshold.count(), std::memory_order_relaxed);
+	}
+
+	void Instrumentation::setSlowCallback(SlowCallbackType cb)
+	{
+		std::unique_lock<std::mutex> lock(m_mutexSlow);
+
+		m_slowCallback = cb;
+	}
+
+	Instrumentation::EventStats& Instrumentation::eventStats(const std::string& event)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto& stats = m_events[event];
+
+		if (!stats)
+		{
+			stats = std::make_unique<EventStats>(event);
+		}
+
+		return *stats;
+	}
+
+	Instrumentation::HandlerStats& Instrumentation::handlerStats(const std::string& event, const std::string& handler)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto& stats = m_handlers[std::make_pair(event, handler)];
+
+		if (!stats)
+		{
+			stats = std::make_unique<HandlerStats>(event, handler);
+		}
+
+		return *stats;
+	}
+
+	void Instrumentation::record(HandlerStats& stats, std::chrono::steady_clock::duration elapsed)
+	{
+		unsigned long long microseconds = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+		std::size_t bucket = 0;
+
+		while (bucket < BUCKETS - 1 && microseconds >= (1ULL << bucket))
+		{
+			++bucket;
+		}
+
+		stats.m_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+		stats.m_sampled.fetch_add(1, std::memory_order_relaxed);
+		stats.m_totalMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+
+		auto max = stats.m_maxMicroseconds.load(std::memory_order_relaxed);
+
+		while (microseconds > max && !stats.m_maxMicroseconds.compare_exchange_weak(max, microseconds, std::memory_order_relaxed))
+		{
+		}
+
+		if (microseconds >= m_slowThreshold.load(std::memory_order_relaxed))
+		{
+			stats.m_slow.fetch_add(1, std::memory_order_relaxed);
+
+			SlowHandler slow = { stats.m_event, stats.m_handler, microseconds };
+			SlowCallbackType cb;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutexSlow);
+
+				m_recentSlow.push_back(slow);
+
+				if (m_recentSlow.size() > g_recentSlow)
+				{
+					m_recentSlow.pop_front();
+				}
+
+				cb = m_slowCallback;
+			}
+
+			if (cb)
+			{
+				try
+				{
+					cb(slow);
+				}
+				catch (...)
+				{
+					BLING_LOG_ERROR("Broker", "Slow handler callback failed: " << logging::currentException());
+				}
+			}
+		}
+	}
+
+	Instrumentation::Snapshot Instrumentation::snapshot() const
+	{
+		Snapshot snapshot;
+
+		snapshot.m_enabled = m_enabled.load(std::memory_order_relaxed);
+		snapshot.m_sampleRate = m_sampleRate.load(std::memory_order_relaxed);
+		snapshot.m_slowThresholdMicroseconds = m_slowThreshold.load(std::memory_order_relaxed);
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			for (const auto& pair : m_events)
+			{
+				snapshot.m_events.push_back({ pair.second->m_event, pair.second->m_published.load(std::memory_order_relaxed) });
+			}
+
+			for (const auto& pair : m_handlers)
+			{
+				const auto& stats = *pair.second;
+
+				Snapshot::Handler handler;
+				handler.m_event = stats.m_event;
+				handler.m_handler = stats.m_handler;
+				handler.m_calls = stats.m_calls.load(std::memory_order_relaxed);
+				handler.m_sampled = stats.m_sampled.load(std::memory_order_relaxed);
+				handler.m_maxMicroseconds = stats.m_maxMicroseconds.load(std::memory_order_relaxed);
+				handler.m_slow = stats.m_slow.load(std::memory_order_relaxed);
+				handler.m_meanMicroseconds = handler.m_sampled ? stats.m_totalMicroseconds.load(std::memory_order_relaxed) / handler.m_sampled : 0;
+
+				for (const auto& bucket : stats.m_histogram)
+				{
+					handler.m_histogram.push_back(bucket.load(std::memory_order_relaxed));
+				}
+
+				snapshot.m_handlers.push_back(handler);
+			}
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutexSlow);
+
+			snapshot.m_recentSlow.assign(m_recentSlow.begin(), m_recentSlow.end());
+		}
+
+		return snapshot;
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	// Publish counters and sampled handler timings for the Broker. Counting is one relaxed
+	// atomic increment; only one in every m_sampleRate handler calls reads the clock, so
+	// it is cheap enough to stay enabled in production.
+	class Instrumentation
+	{
+	public:
+		static const std::size_t BUCKETS = 24;
+
+		struct EventStats
+		{
+			EventStats(const std::string& event) : m_event(event) {}
+
+			const std::string				m_event;
+			std::atomic<unsigned long long>	m_published{0};
+		};
+
+		// Histogram bucket i counts sampled calls that took less than 2^i microseconds;
+		// the last bucket also takes everything slower.
+		struct HandlerStats
+		{
+			HandlerStats(const std::string& event, const std::string& handler);
+
+			const std::string										m_event;
+			const std::string										m_handler;
+			std::atomic<unsigned long long>							m_calls{0};
+			std::atomic<unsigned long long>							m_sampled{0};
+			std::atomic<unsigned long long>							m_totalMicroseconds{0};
+			std::atomic<unsigned long long>							m_maxMicroseconds{0};
+			std::atomic<unsigned long long>							m_slow{0};
+			std::array<std::atomic<unsigned long long>, BUCKETS>	m_histogram;
+		};
+
+		struct SlowHandler
+		{
+			std::string			m_event;
+			std::string			m_handler;
+			unsigned long long	m_microseconds;
+		};
+
+		struct Snapshot
+		{
+			struct Event
+			{
+				std::string			m_event;
+				unsigned long long	m_published;
+			};
+
+			struct Handler
+			{
+				std::string						m_event;
+				std::string						m_handler;
+				unsigned long long				m_calls;
+				unsigned long long				m_sampled;
+				unsigned long long				m_meanMicroseconds;
+				unsigned long long				m_maxMicroseconds;
+				unsigned long long				m_slow;
+				std::vector<unsigned long long>	m_histogram;
+			};
+
+			bool						m_enabled;
+			unsigned int				m_sampleRate;
+			unsigned long long			m_slowThresholdMicroseconds;
+			std::vector<Event>			m_events;
+			std::vector<Handler>		m_handlers;
+			std::vector<SlowHandler>	m_recentSlow;
+		};
+
+		typedef std::function<void(const SlowHandler&)> SlowCallbackType;
+
+		static Instrumentation& get();
+
+		void setEnabled(bool enabled);
+		void setSampleRate(unsigned int rate);
+		void setSlowThreshold(std::chrono::microseconds threshold);
+		// Called for every sampled handler slower than the threshold; logs a warning by default
+		void setSlowCallback(SlowCallbackType cb);
+
+		// Stats live as long as the process and are shared by every publisher of an event
+		// or every connection of the same handler, so callers may cache the reference.
+		EventStats& eventStats(const std::string& event);
+		HandlerStats& handlerStats(const std::string& event, const std::string& handler);
+
+		void countPublish(EventStats& stats)
+		{
+			if (m_enabled.load(std::memory_order_relaxed))
+			{
+				stats.m_published.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		template<typename F>
+		void time(HandlerStats& stats, F&& f)
+		{
+			if (!m_enabled.load(std::memory_order_relaxed))
+			{
+				f();
+				return;
+			}
+
+			auto call = stats.m_calls.fetch_add(1, std::memory_order_relaxed);
+
+			if (call % m_sampleRate.load(std::memory_order_relaxed) != 0)
+			{
+				f();
+				return;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+
+			try
+			{
+				f();
+			}
+			catch (...)
+			{
+				record(stats, std::chrono::steady_clock::now() - start);
+				throw;
+			}
+
+			record(stats, std::chrono::steady_clock::now() - start);
+		}
+
+		Snapshot snapshot() const;
+	private:
+		Instrumentation();
+		Instrumentation(const Instrumentation&) = delete;
+		Instrumentation& operator=(const Instrumentation&) = delete;
+
+		void record(HandlerStats& stats, std::chrono::steady_clock::duration elapsed);
+	private:
+		std::atomic<bool>											m_enabled;
+		std::atomic<unsigned int>									m_sampleRate;
+		std::atomic<unsigned long long>								m_slowThreshold;
+
+		std::map<std::string, std::unique_ptr<EventStats>>			m_events;
+		std::map<std::pair<std::string, std::string>, std::unique_ptr<HandlerStats>>	m_handlers;
+		mutable std::mutex											m_mutex;
+
+		SlowCallbackType											m_slowCallback;
+		std::deque<SlowHandler>										m_recentSlow;
+		mutable std::mutex											m_mutexSlow;
+	};
+}}}}
\ No newline at end of file
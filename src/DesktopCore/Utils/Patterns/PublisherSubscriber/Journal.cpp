@@ -0,0 +1,298 @@
+#include "Journal.h"
+
+#include "../../Logging/Logger.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <sddl.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	namespace
+	{
+		// Dropped records are left in the file until this many pile up
+		const std::size_t g_rewriteThreshold = 64;
+
+		// Records hold the auth token, so only the user may read the file. Creates it when it is
+		// missing and takes the access of anyone else away from one written before.
+		bool createOwnerOnly(const std::string& path)
+		{
+#ifdef _WIN32
+			// Protected DACL with a single entry for the owner, nothing inherited from Documents
+			PSECURITY_DESCRIPTOR descriptor = nullptr;
+
+			if (!ConvertStringSecurityDescriptorToSecurityDescriptorA("D:P(A;;FA;;;OW)", SDDL_REVISION_1, &descriptor, nullptr))
+			{
+				return false;
+			}
+
+			SECURITY_ATTRIBUTES attributes = { sizeof(attributes), descriptor, FALSE };
+
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &attributes, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			bool restricted = file != INVALID_HANDLE_VALUE;
+
+			if (restricted)
+			{
+				CloseHandle(file);
+				restricted = SetFileSecurityA(path.c_str(), DACL_SECURITY_INFORMATION, descriptor) != FALSE;
+			}
+
+			LocalFree(descriptor);
+
+			return restricted;
+#else
+			int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			bool restricted = fchmod(fd, S_IRUSR | S_IWUSR) == 0;
+			::close(fd);
+
+			return restricted;
+#endif
+		}
+	}
+
+	Journal& Journal::get()
+	{
+		static Journal S;
+		return S;
+	}
+
+	Journal::Journal() = default;
+
+	Journal::~Journal()
+	{
+		close();
+	}
+
+	bool Journal::open(const std::string& path)
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+		close();
+
+		try
+		{
+			boost::filesystem::create_directories(boost::filesystem::path(path).parent_path());
+
+			if (!createOwnerOnly(path))
+			{
+				BLING_LOG_ERROR("Journal", "Could not make " << path << " private to the user, the journal is off");
+				return false;
+			}
+
+			std::ifstream in(path);
+			std::string line;
+
+			// A crash can leave the last line incomplete; anything unparsable is skipped
+			while (std::getline(in, line))
+			{
+				std::istringstream ss(line);
+				Record record;
+
+				if (ss >> record.m_sequence >> record.m_event && ss.get() == ' ' && std::getline(ss, record.m_payload) && !record.m_payload.empty())
+				{
+					m_sequence = std::max(m_sequence, record.m_sequence);
+					m_records.push_back(record);
+				}
+			}
+
+			m_file.open(path, std::ios::out | std::ios::app);
+		}
+		catch (...)
+		{
+			BLING_LOG_ERROR("Journal", "Could not open " << path << ": " << logging::currentException());
+		}
+
+		if (!m_file.is_open())
+		{
+			m_records.clear();
+			m_sequence = 0;
+
+			return false;
+		}
+
+		m_path = path;
+		m_subscriber = std::make_unique<Subscriber>();
+
+		return true;
+	}
+
+	void Journal::close()
+	{
+		std::unique_ptr<Subscriber> subscriber;
+
+		{
+			std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+			subscriber.swap(m_subscriber);
+
+			if (m_file.is_open())
+			{
+				m_file.close();
+			}
+
+			m_path.clear();
+			m_records.clear();
+			m_options.clear();
+			m_sequence = 0;
+			m_obsolete = 0;
+		}
+
+		// Disconnect outside the lock so a running append can finish
+		subscriber.reset();
+	}
+
+	bool Journal::isOpen() const
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+		return m_file.is_open();
+	}
+
+	void Journal::configure(EventType event, const Options& options)
+	{
+		m_options[event] = options;
+
+		trim(event);
+
+		if (m_obsolete)
+		{
+			rewrite();
+		}
+	}
+
+	void Journal::append(EventType event, const std::string& payload)
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+		if (!m_file.is_open())
+		{
+			return;
+		}
+
+		const auto& options = m_options[event];
+
+		if (options.m_onlyChanges)
+		{
+			auto last = std::find_if(m_records.rbegin(), m_records.rend(), [event](const Record& record)
+			{
+				return record.m_event == event;
+			});
+
+			if (last != m_records.rend() && last->m_payload == payload)
+			{
+				return;
+			}
+		}
+
+		Record record = { ++m_sequence, event, payload };
+
+		m_file << record.m_sequence << ' ' << record.m_event << ' ' << record.m_payload << '\n';
+		m_file.flush();
+
+		m_records.push_back(record);
+
+		trim(event);
+
+		if (m_obsolete >= g_rewriteThreshold)
+		{
+			rewrite();
+		}
+	}
+
+	std::vector<Journal::Record> Journal::records(EventType event) const
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+		std::vector<Record> records;
+
+		for (const auto& record : m_records)
+		{
+			if (record.m_event == event)
+			{
+				records.push_back(record);
+			}
+		}
+
+		return records;
+	}
+
+	void Journal::trim(EventType event)
+	{
+		auto keepLast = m_options[event].m_keepLast;
+
+		if (!keepLast)
+		{
+			return;
+		}
+
+		auto count = std::count_if(m_records.begin(), m_records.end(), [event](const Record& record)
+		{
+			return record.m_event == event;
+		});
+
+		for (auto it = m_records.begin(); it != m_records.end() && static_cast<std::size_t>(count) > keepLast; )
+		{
+			if (it->m_event == event)
+			{
+				it = m_records.erase(it);
+				--count;
+				++m_obsolete;
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	void Journal::rewrite()
+	{
+		try
+		{
+			std::string tmp = m_path + ".tmp";
+
+			// Renamed over the journal, so it must be as private
+			if (!createOwnerOnly(tmp))
+			{
+				return;
+			}
+
+			{
+				std::ofstream out(tmp, std::ios::out | std::ios::trunc);
+
+				for (const auto& record : m_records)
+				{
+					out << record.m_sequence << ' ' << record.m_event << ' ' << record.m_payload << '\n';
+				}
+			}
+
+			m_file.close();
+			boost::filesystem::rename(tmp, m_path);
+			m_obsolete = 0;
+		}
+		catch (...)
+		{
+			BLING_LOG_WARNING("Journal", "Could not rewrite " << m_path << ": " << logging::currentException());
+		}
+
+		if (!m_file.is_open())
+		{
+			m_file.open(m_path, std::ios::out | std::ios::app);
+		}
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Event.h"
+#include "Subscriber.h"
+#include "../../Logging/Logger.h"
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace desktop { namespace core { namespace utils { namespace patterns {
+
+	// Specialised next to each journaled event:
+	//	static EventType id();
+	//	static void encode(const EventT&, boost::property_tree::ptree&);
+	//	static EventT decode(const boost::property_tree::ptree&);
+	template<typename EventT>
+	struct JournalCodec;
+
+	// Append-only log of selected Broker events, so after a restart or a crash consumers can
+	// replay the last ones, such as the latest login, instead of waiting for them to happen
+	// again. One record per line: "<sequence> <event id> <json payload>".
+	class Journal
+	{
+	public:
+		typedef unsigned long long SequenceType;
+
+		struct Options
+		{
+			Options(bool onlyChanges = false, std::size_t keepLast = 0)
+			: m_onlyChanges(onlyChanges)
+			, m_keepLast(keepLast)
+			{
+
+			}
+
+			bool		m_onlyChanges;	// skip records equal to the previous one of the same event
+			std::size_t	m_keepLast;		// keep only the latest records of the event, 0 keeps all
+		};
+
+		static Journal& get();
+
+		bool open(const std::string& path);
+		void close();
+		bool isOpen() const;
+
+		template<typename EventT>
+		void enable(const Options& options = Options())
+		{
+			std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+			if (!m_subscriber)
+			{
+				return;
+			}
+
+			configure(JournalCodec<EventT>::id(), options);
+
+			m_subscriber->subscribe<EventT>("Journal", [this](const EventT& evt)
+			{
+				boost::property_tree::ptree pt;
+				JournalCodec<EventT>::encode(evt, pt);
+
+				std::stringstream ss;
+				boost::property_tree::write_json(ss, pt, false);
+
+				auto payload = ss.str();
+
+				if (!payload.empty() && payload.back() == '\n')
+				{
+					payload.pop_back();
+				}
+
+				append(JournalCodec<EventT>::id(), payload);
+			});
+		}
+
+		// Calls cb(const EventT&) for every kept record of EventT, oldest first. Records that no
+		// longer decode are skipped.
+		template<typename EventT, typename CallbackT>
+		std::size_t replay(CallbackT cb) const
+		{
+			std::size_t count = 0;
+
+			for (const auto& record : records(JournalCodec<EventT>::id()))
+			{
+				try
+				{
+					boost::property_tree::ptree pt;
+					std::stringstream ss(record.m_payload);
+					boost::property_tree::read_json(ss, pt);
+
+					cb(JournalCodec<EventT>::decode(pt));
+
+					++count;
+				}
+				catch (...)
+				{
+					BLING_LOG_WARNING("Journal", "Record " << record.m_sequence << " could not be replayed: " << logging::currentException());
+				}
+			}
+
+			return count;
+		}
+	private:
+		struct Record
+		{
+			SequenceType	m_sequence;
+			EventType		m_event;
+			std::string		m_payload;
+		};
+
+		Journal();
+		~Journal();
+		Journal(const Journal&) = delete;
+		Journal& operator=(const Journal&) = delete;
+
+		void configure(EventType event, const Options& options);
+		void append(EventType event, const std::string& payload);
+		std::vector<Record> records(EventType event) const;
+
+		void trim(EventType event);
+		void rewrite();
+	private:
+		std::string								m_path;
+		std::ofstream							m_file;
+		std::vector<Record>						m_records;
+		std::map<EventType, Options>			m_options;
+		SequenceType							m_sequence = 0;
+		std::size_t								m_obsolete = 0;
+		std::unique_ptr<Subscriber>				m_subscriber;
+		mutable std::recursive_mutex			m_mutex;
+	};
+}}}}
\ No newline at end of file
@@ -19,13 +19,14 @@ namespace desktop { namespace core { namespace utils { namespace patterns {
 		}
 
 		m_subscriptions.clear();
+		m_channels.clear();
 	}
 
-	void Subscriber::subscribe(CallbackType cb, const EventType& evtName)
+	void Subscriber::subscribe(const std::string& name, CallbackType cb, const EventType& evtName, const DeliveryPolicy& policy)
 	{
 		if(!m_subscriptions[evtName])
 		{
-			m_subscriptions[evtName] = Broker::get().subscribe(cb, evtName);
+			m_subscriptions[evtName] = Broker::get().subscribe(name, cb, evtName, policy);
 		}
 	}
 
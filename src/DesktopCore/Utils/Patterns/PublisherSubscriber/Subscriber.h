@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Event.h"
+#include "Broker.h"
+#include "Channel.h"
 
 #include <map>
 #include <memory>
@@ -14,12 +16,38 @@ namespace desktop { namespace core { namespace utils { namespace patterns {
 		typedef std::function<void (const Event&)> CallbackType;
 		Subscriber();
 		~Subscriber();
-		void subscribe(CallbackType cb, const EventType& evtName);
+		// name identifies the handler in the statistics and the slow handler warnings
+		void subscribe(const std::string& name, CallbackType cb, const EventType& evtName, const DeliveryPolicy& policy = DeliveryPolicy::inlined());
 		void unsubscribe(const EventType& evtName);
+
+		// Typed subscription through Channel<EventT>; the callback takes const EventT&
+		template<typename EventT, typename CallbackT>
+		void subscribe(const std::string& name, CallbackT cb, const DeliveryPolicy& policy = DeliveryPolicy::inlined())
+		{
+			auto& connection = m_channels[&Channel<EventT>::get()];
+
+			if (!connection)
+			{
+				connection = Channel<EventT>::get().subscribe(name, std::move(cb), policy);
+			}
+		}
+
+		template<typename EventT>
+		void unsubscribe()
+		{
+			auto it = m_channels.find(&Channel<EventT>::get());
+
+			if (it != m_channels.end())
+			{
+				it->second->disconnect();
+				m_channels.erase(it);
+			}
+		}
 	private:
-		typedef  std::unique_ptr<boost::signals2::scoped_connection> ConnectionType;
+		typedef  std::unique_ptr<Broker::ConnectionType> ConnectionType;
 		typedef  std::map<EventType, ConnectionType> SubscriptionsMapType;
 
         SubscriptionsMapType m_subscriptions;
+		std::map<const void*, std::unique_ptr<ChannelConnection>> m_channels;
 	};
 }}}}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "CancellationToken.h"
+
+#include "../Logging/Logger.h"
+#include "../Tracing/Tracer.h"
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	struct CancellationToken::Registration::State
+	{
+		std::mutex							m_mutex;
+		std::condition_variable				m_cv;
+		bool								m_cancelled = false;
+		std::map<std::size_t, CallbackType>	m_callbacks;
+		std::size_t							m_next = 1;
+		std::size_t							m_running = 0;
+		std::thread::id						m_runner;
+	};
+
+	CancellationToken::Registration::Registration(std::weak_ptr<State> state, std::size_t id)
+	: m_state(std::move(state))
+	, m_id(id)
+	{
+
+	}
+
+	CancellationToken::Registration::Registration(Registration&& other)
+	: m_state(std::move(other.m_state))
+	, m_id(other.m_id)
+	{
+		other.m_id = 0;
+	}
+
+	CancellationToken::Registration& CancellationToken::Registration::operator=(Registration&& other)
+	{
+		if (this != &other)
+		{
+			reset();
+
+			m_state = std::move(other.m_state);
+			m_id = other.m_id;
+			other.m_id = 0;
+		}
+
+		return *this;
+	}
+
+	CancellationToken::Registration::~Registration()
+	{
+		reset();
+	}
+
+	void CancellationToken::Registration::reset()
+	{
+		auto state = m_state.lock();
+
+		if (state && m_id != 0)
+		{
+			std::unique_lock<std::mutex> lock(state->m_mutex);
+
+			state->m_callbacks.erase(m_id);
+
+			state->m_cv.wait(lock, [this, &state]()
+			{
+				return state->m_running != m_id || state->m_runner == std::this_thread::get_id();
+			});
+		}
+
+		m_state.reset();
+		m_id = 0;
+	}
+
+	CancellationToken::CancellationToken()
+	: m_state(std::make_shared<Registration::State>())
+	{
+
+	}
+
+	void CancellationToken::cancel()
+	{
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		if (m_state->m_cancelled)
+		{
+			return;
+		}
+
+		m_state->m_cancelled = true;
+		m_state->m_runner = std::this_thread::get_id();
+
+		// Callbacks run unlocked so they may take their own locks; a Registration being
+		// destroyed meanwhile waits on m_running
+		while (!m_state->m_callbacks.empty())
+		{
+			auto it = m_state->m_callbacks.begin();
+			auto id = it->first;
+			auto callback = std::move(it->second);
+
+			m_state->m_callbacks.erase(it);
+			m_state->m_running = id;
+
+			lock.unlock();
+
+			try
+			{
+				callback();
+			}
+			catch (...)
+			{
+				BLING_LOG_ERROR("CancellationToken", "Cancellation callback failed: " << logging::currentException());
+			}
+
+			lock.lock();
+
+			m_state->m_running = 0;
+			m_state->m_cv.notify_all();
+		}
+
+		m_state->m_cv.notify_all();
+	}
+
+	bool CancellationToken::cancelled() const
+	{
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		return m_state->m_cancelled;
+	}
+
+	bool CancellationToken::sleepFor(std::chrono::milliseconds duration) const
+	{
+		BLING_TRACE_SPAN("runtime", "sleep");
+
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		return !m_state->m_cv.wait_for(lock, duration, [this]()
+		{
+			return m_state->m_cancelled;
+		});
+	}
+
+	CancellationToken::Registration CancellationToken::onCancel(CallbackType callback) const
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+			if (!m_state->m_cancelled)
+			{
+				auto id = m_state->m_next++;
+				m_state->m_callbacks[id] = std::move(callback);
+
+				return Registration(m_state, id);
+			}
+		}
+
+		callback();
+
+		return Registration();
+	}
+}}}}
\ No newline at end of file
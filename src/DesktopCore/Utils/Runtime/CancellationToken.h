@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	// Shared cancellation flag. Copies observe the same state, so an agent hands copies to the
+	// work it starts and cancels all of it at once. Blocking calls either wait through sleepFor
+	// or register a callback that interrupts them (closing a socket, waking a condition).
+	class CancellationToken
+	{
+	public:
+		typedef std::function<void()> CallbackType;
+
+		// Unregisters its callback when destroyed. Waits for the callback if it is running on
+		// another thread, so whatever it captured can be released right after.
+		class Registration
+		{
+		public:
+			Registration() = default;
+			Registration(Registration&& other);
+			Registration& operator=(Registration&& other);
+			~Registration();
+
+			void reset();
+		private:
+			friend class CancellationToken;
+
+			struct State;
+
+			Registration(std::weak_ptr<State> state, std::size_t id);
+			Registration(const Registration&) = delete;
+			Registration& operator=(const Registration&) = delete;
+		private:
+			std::weak_ptr<State>	m_state;
+			std::size_t				m_id = 0;
+		};
+
+		CancellationToken();
+
+		void cancel();
+		bool cancelled() const;
+
+		// Returns false, possibly early, once the token is cancelled
+		bool sleepFor(std::chrono::milliseconds duration) const;
+
+		// The callback runs on the cancelling thread, or right away when already cancelled
+		Registration onCancel(CallbackType callback) const;
+	private:
+		std::shared_ptr<Registration::State> m_state;
+	};
+}}}}
\ No newline at end of file
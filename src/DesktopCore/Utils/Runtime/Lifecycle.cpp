@@ -0,0 +1,162 @@
+#include "Lifecycle.h"
+
+#include "../Logging/Logger.h"
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	Lifecycle::Lifecycle(Runtime& runtime)
+	: m_runtime(runtime)
+	, m_state(std::make_shared<State>())
+	{
+
+	}
+
+	Lifecycle::~Lifecycle()
+	{
+		stop();
+		wait();
+	}
+
+	void Lifecycle::start()
+	{
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		if (!m_state->m_running)
+		{
+			m_state->m_running = true;
+			m_state->m_token = CancellationToken();
+		}
+	}
+
+	void Lifecycle::stop()
+	{
+		std::shared_ptr<Timer> timer;
+		CancellationToken token;
+
+		{
+			std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+			if (!m_state->m_running)
+			{
+				return;
+			}
+
+			m_state->m_running = false;
+
+			timer = std::move(m_state->m_timer);
+			token = m_state->m_token;
+		}
+
+		if (timer)
+		{
+			timer->cancel(false);
+		}
+
+		token.cancel();
+	}
+
+	bool Lifecycle::drain(std::chrono::milliseconds timeout)
+	{
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		return m_state->m_cv.wait_for(lock, timeout, [this]()
+		{
+			return m_state->m_inflight == 0;
+		});
+	}
+
+	void Lifecycle::wait()
+	{
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		m_state->m_cv.wait(lock, [this]()
+		{
+			return m_state->m_inflight == 0;
+		});
+	}
+
+	bool Lifecycle::running() const
+	{
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		return m_state->m_running;
+	}
+
+	CancellationToken Lifecycle::token() const
+	{
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		return m_state->m_token;
+	}
+
+	void Lifecycle::schedule(std::chrono::milliseconds delay, TaskType task)
+	{
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+
+		if (!m_state->m_running)
+		{
+			return;
+		}
+
+		if (m_state->m_timer)
+		{
+			m_state->m_timer->cancel(false);
+		}
+
+		// A timer firing after the lifecycle is gone finds no state and does nothing
+		std::weak_ptr<State> weak = m_state;
+		Runtime* runtime = &m_runtime;
+
+		m_state->m_timer = m_runtime.schedule(delay, [weak, task, runtime]()
+		{
+			auto state = weak.lock();
+
+			if (!state)
+			{
+				return;
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(state->m_mutex);
+
+				if (!state->m_running)
+				{
+					return;
+				}
+
+				++state->m_inflight;
+			}
+
+			auto done = [state]()
+			{
+				{
+					std::unique_lock<std::mutex> lock(state->m_mutex);
+
+					--state->m_inflight;
+				}
+
+				state->m_cv.notify_all();
+			};
+
+			// Agent work blocks on the network, so it leaves the timer thread for the blocking pool
+			bool posted = runtime->postBlocking([task, done]()
+			{
+				try
+				{
+					task();
+				}
+				catch (...)
+				{
+					BLING_LOG_ERROR("Lifecycle", "Task failed: " << logging::currentException());
+				}
+
+				done();
+			});
+
+			if (!posted)
+			{
+				done();
+			}
+		});
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "Runtime.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	// Start/stop state of an agent together with its cancellation token, its pending timer and
+	// the callbacks still running. stop() never blocks; drain() waits for the running callbacks,
+	// which return quickly as long as their blocking calls take token().
+	class Lifecycle
+	{
+	public:
+		typedef std::function<void()> TaskType;
+
+		explicit Lifecycle(Runtime& runtime = Runtime::get());
+		~Lifecycle();
+
+		// A fresh token for every start, so a stopped agent can be started again
+		void start();
+		void stop();
+
+		bool drain(std::chrono::milliseconds timeout);
+		void wait();
+
+		bool running() const;
+		CancellationToken token() const;
+
+		// Runs the task on the blocking pool of the runtime once after delay, unless stopped first.
+		// Replaces a pending schedule.
+		void schedule(std::chrono::milliseconds delay, TaskType task);
+	private:
+		struct State
+		{
+			mutable std::mutex			m_mutex;
+			std::condition_variable		m_cv;
+			bool						m_running = false;
+			std::size_t					m_inflight = 0;
+			CancellationToken			m_token;
+			std::shared_ptr<Timer>		m_timer;
+		};
+	private:
+		Runtime&					m_runtime;
+		std::shared_ptr<State>		m_state;
+	};
+}}}}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "Runtime.h"
+
+#include "../Metrics/Metrics.h"
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	Runtime& Runtime::get()
+	{
+		static Runtime S;
+		return S;
+	}
+
+	Runtime::Runtime()
+	: m_pool(std::make_shared<ThreadPool>())
+	, m_blocking(std::make_shared<ThreadPool>(BLOCKING_THREADS))
+	, m_timers(std::make_unique<TimerWheel>(m_pool))
+	{
+		std::weak_ptr<ThreadPool> pool = m_pool;
+
+		auto& registry = metrics::Registry::get();
+
+		registry.sample("bling_runtime_queued_tasks", "Tasks waiting for a runtime thread", [pool]()
+		{
+			auto locked = pool.lock();
+			return locked ? static_cast<double>(locked->pending()) : 0.0;
+		});
+
+		registry.sample("bling_runtime_threads", "Threads of the runtime pool", [pool]()
+		{
+			auto locked = pool.lock();
+			return locked ? static_cast<double>(locked->size()) : 0.0;
+		});
+
+		std::weak_ptr<ThreadPool> blocking = m_blocking;
+
+		registry.sample("bling_runtime_blocking_queued_tasks", "Blocking tasks waiting for a thread", [blocking]()
+		{
+			auto locked = blocking.lock();
+			return locked ? static_cast<double>(locked->pending()) : 0.0;
+		});
+	}
+
+	Runtime::~Runtime()
+	{
+		stop();
+	}
+
+	bool Runtime::post(TaskType task)
+	{
+		return m_pool->post(std::move(task));
+	}
+
+	bool Runtime::postBlocking(TaskType task)
+	{
+		return m_blocking->post(std::move(task));
+	}
+
+	std::shared_ptr<Timer> Runtime::schedule(std::chrono::milliseconds delay, TaskType task)
+	{
+		return m_timers->schedule(delay, std::move(task));
+	}
+
+	std::shared_ptr<cup::IExecutor> Runtime::serial()
+	{
+		return std::make_shared<cup::SerialExecutor>(m_pool);
+	}
+
+	std::shared_ptr<cup::IExecutor> Runtime::executor()
+	{
+		return m_pool;
+	}
+
+	void Runtime::stop()
+	{
+		m_timers->stop();
+		m_blocking->stop();
+		m_pool->stop();
+	}
+
+	bool Runtime::stop(std::chrono::milliseconds timeout)
+	{
+		m_timers->stop();
+
+		auto deadline = std::chrono::steady_clock::now() + timeout;
+		bool stopped = true;
+
+		for (auto pool : { m_blocking, m_pool })
+		{
+			auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+
+			if (!pool->stop(left.count() > 0 ? left : std::chrono::milliseconds(0)))
+			{
+				// Detached workers still use the pool; the caller ends the process with quick_exit
+				// before static destruction, see DesktopCore
+				new std::shared_ptr<ThreadPool>(pool);
+
+				stopped = false;
+			}
+		}
+
+		return stopped;
+	}
+}}}}
\ No newline at end of file
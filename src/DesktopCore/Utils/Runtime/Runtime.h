@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "TimerWheel.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	// Process wide thread pool and timer wheel shared by every agent, so the number of
+	// threads does not grow with the number of agents. Started on first use. Work that blocks,
+	// such as the HTTP exchanges and downloads of the agents, goes to a second pool of
+	// BLOCKING_THREADS, so it never holds up event deliveries, timers or agent builds.
+	class Runtime
+	{
+	public:
+		typedef std::function<void()> TaskType;
+
+		static const std::size_t BLOCKING_THREADS = 4;
+
+		static Runtime& get();
+
+		bool post(TaskType task);
+		bool postBlocking(TaskType task);
+		std::shared_ptr<Timer> schedule(std::chrono::milliseconds delay, TaskType task);
+
+		// A new serial executor running on the pool, for work that must not overlap
+		std::shared_ptr<cup::IExecutor> serial();
+		std::shared_ptr<cup::IExecutor> executor();
+
+		// Stops the timer wheel and the pool; tasks already queued still run
+		void stop();
+
+		// Same, but returns false instead of waiting past the timeout for busy workers, which are
+		// left running; the process must then exit without static destruction
+		bool stop(std::chrono::milliseconds timeout);
+	private:
+		Runtime();
+		~Runtime();
+		Runtime(const Runtime&) = delete;
+		Runtime& operator=(const Runtime&) = delete;
+	private:
+		std::shared_ptr<ThreadPool>		m_pool;
+		std::shared_ptr<ThreadPool>		m_blocking;
+		std::unique_ptr<TimerWheel>		m_timers;
+	};
+}}}}
\ No newline at end of file
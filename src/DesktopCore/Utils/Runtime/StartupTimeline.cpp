@@ -0,0 +1,141 @@
+#include "StartupTimeline.h"
+
+#include "Runtime.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	StartupTimeline& StartupTimeline::get()
+	{
+		static StartupTimeline S;
+		return S;
+	}
+
+	StartupTimeline::StartupTimeline()
+	: m_origin(ClockType::now())
+	, m_required({"agents"})
+	{
+
+	}
+
+	void StartupTimeline::mark(const std::string& phase)
+	{
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(ClockType::now() - m_origin);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto found = std::find_if(m_phases.begin(), m_phases.end(), [&phase](const EntriesType::value_type& entry)
+		{
+			return entry.first == phase;
+		});
+
+		if (found == m_phases.end())
+		{
+			m_phases.emplace_back(phase, elapsed);
+
+			reportIfComplete(lock);
+		}
+	}
+
+	void StartupTimeline::measure(const std::string& step, std::chrono::milliseconds duration)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_steps.emplace_back(step, duration);
+	}
+
+	void StartupTimeline::open(const std::string& path)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_path = path;
+
+		reportIfComplete(lock);
+	}
+
+	void StartupTimeline::reportWhen(std::vector<std::string> phases)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_required = std::move(phases);
+
+		reportIfComplete(lock);
+	}
+
+	StartupTimeline::EntriesType StartupTimeline::phases() const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		return m_phases;
+	}
+
+	StartupTimeline::EntriesType StartupTimeline::steps() const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		return m_steps;
+	}
+
+	void StartupTimeline::reportIfComplete(std::unique_lock<std::mutex>& lock)
+	{
+		if (m_reported || m_path.empty())
+		{
+			return;
+		}
+
+		for (auto& phase : m_required)
+		{
+			auto found = std::find_if(m_phases.begin(), m_phases.end(), [&phase](const EntriesType::value_type& entry)
+			{
+				return entry.first == phase;
+			});
+
+			if (found == m_phases.end())
+			{
+				return;
+			}
+		}
+
+		m_reported = true;
+
+		// 2018-05-01T10:00:00 process=0ms cef=180ms browser=420ms agents=510ms viewer=900ms | FileServerAgent=35ms ...
+		std::stringstream line;
+
+		line << boost::posix_time::to_iso_extended_string(boost::posix_time::second_clock::local_time());
+
+		for (auto& phase : m_phases)
+		{
+			line << " " << phase.first << "=" << phase.second.count() << "ms";
+		}
+
+		line << " |";
+
+		for (auto& step : m_steps)
+		{
+			line << " " << step.first << "=" << step.second.count() << "ms";
+		}
+
+		auto path = m_path;
+		auto report = line.str();
+
+		lock.unlock();
+
+		// Usually reached on the UI thread, which has better things to do than file IO
+		auto write = [path, report]()
+		{
+			std::ofstream file(path, std::ios::app);
+
+			file << report << std::endl;
+		};
+
+		if (!Runtime::get().post(write))
+		{
+			write();
+		}
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	// Time of each startup phase since the process began, plus how long each step took, written
+	// as one line per run once every phase that makes the application usable has been reached
+	class StartupTimeline
+	{
+	public:
+		typedef std::chrono::steady_clock ClockType;
+		typedef std::vector<std::pair<std::string, std::chrono::milliseconds>> EntriesType;
+
+		static StartupTimeline& get();
+
+		// Only the first mark of a phase counts
+		void mark(const std::string& phase);
+		void measure(const std::string& step, std::chrono::milliseconds duration);
+
+		// The report is appended to path once all of the phases are marked
+		void open(const std::string& path);
+		void reportWhen(std::vector<std::string> phases);
+
+		EntriesType phases() const;
+		EntriesType steps() const;
+	private:
+		StartupTimeline();
+		StartupTimeline(const StartupTimeline&) = delete;
+		StartupTimeline& operator=(const StartupTimeline&) = delete;
+
+		void reportIfComplete(std::unique_lock<std::mutex>& lock);
+	private:
+		mutable std::mutex			m_mutex;
+		ClockType::time_point		m_origin;
+		EntriesType					m_phases;
+		EntriesType					m_steps;
+		std::string					m_path;
+		std::vector<std::string>	m_required;
+		bool						m_reported = false;
+	};
+}}}}
\ No newline at end of file
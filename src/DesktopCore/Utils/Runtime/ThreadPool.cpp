@@ -0,0 +1,241 @@
+#include "ThreadPool.h"
+
+#include "../Logging/Logger.h"
+
+#include <algorithm>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	namespace
+	{
+		thread_local const ThreadPool* t_pool = nullptr;
+		thread_local std::size_t t_index = 0;
+	}
+
+	ThreadPool::ThreadPool(std::size_t threads)
+	: m_next(0)
+	, m_pending(0)
+	{
+		threads = std::max<std::size_t>(threads, 2);
+
+		for (std::size_t i = 0; i < threads; ++i)
+		{
+			m_queues.push_back(std::make_unique<Queue>());
+		}
+
+		m_active = threads;
+
+		for (std::size_t i = 0; i < threads; ++i)
+		{
+			m_threads.emplace_back(&ThreadPool::run, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		stop();
+	}
+
+	bool ThreadPool::post(TaskType task, cup::OverflowPolicy /*overflow*/)
+	{
+		return post(std::move(task));
+	}
+
+	bool ThreadPool::post(TaskType task)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (m_stop)
+			{
+				return false;
+			}
+		}
+
+		// Work spawned by a worker stays on its queue, where it is still cache warm
+		std::size_t index = t_pool == this ? t_index : m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+		// Counted under the queue lock, so a worker that sees m_pending > 0 finds the task
+		// unless another worker took it first
+		{
+			std::unique_lock<std::mutex> lock(m_queues[index]->m_mutex);
+			m_queues[index]->m_tasks.push_back(std::move(task));
+			m_pending.fetch_add(1);
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+		}
+
+		m_cv.notify_one();
+
+		return true;
+	}
+
+	void ThreadPool::stop()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (m_stop)
+			{
+				return;
+			}
+
+			m_stop = true;
+		}
+
+		m_cv.notify_all();
+
+		for (auto& thread : m_threads)
+		{
+			if (thread.joinable() && thread.get_id() != std::this_thread::get_id())
+			{
+				thread.join();
+			}
+			else if (thread.joinable())
+			{
+				thread.detach();
+			}
+		}
+	}
+
+	bool ThreadPool::stop(std::chrono::milliseconds timeout)
+	{
+		bool finished;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_stop = true;
+
+			m_cv.notify_all();
+
+			// A worker stopping its own pool cannot wait for itself
+			finished = m_cv.wait_for(lock, timeout, [this]()
+			{
+				return m_active == (t_pool == this ? 1 : 0);
+			});
+		}
+
+		for (auto& thread : m_threads)
+		{
+			if (thread.joinable() && finished && thread.get_id() != std::this_thread::get_id())
+			{
+				thread.join();
+			}
+			else if (thread.joinable())
+			{
+				thread.detach();
+			}
+		}
+
+		return finished;
+	}
+
+	std::size_t ThreadPool::size() const
+	{
+		return m_threads.size();
+	}
+
+	std::size_t ThreadPool::pending() const
+	{
+		auto pending = m_pending.load(std::memory_order_relaxed);
+
+		return pending > 0 ? static_cast<std::size_t>(pending) : 0;
+	}
+
+	bool ThreadPool::pop(std::size_t index, TaskType& task)
+	{
+		{
+			auto& own = *m_queues[index];
+			std::unique_lock<std::mutex> lock(own.m_mutex);
+
+			if (!own.m_tasks.empty())
+			{
+				task = std::move(own.m_tasks.back());
+				own.m_tasks.pop_back();
+				m_pending.fetch_sub(1);
+				return true;
+			}
+		}
+
+		// Steals skip busy queues first and only wait for their locks when nothing else was found,
+		// so a worker never spins on a queue another thread holds
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			bool contended = false;
+
+			for (std::size_t i = 1; i < m_queues.size(); ++i)
+			{
+				auto& other = *m_queues[(index + i) % m_queues.size()];
+				std::unique_lock<std::mutex> lock(other.m_mutex, std::defer_lock);
+
+				if (pass == 0 && !lock.try_lock())
+				{
+					contended = true;
+					continue;
+				}
+				else if (pass == 1)
+				{
+					lock.lock();
+				}
+
+				if (!other.m_tasks.empty())
+				{
+					task = std::move(other.m_tasks.front());
+					other.m_tasks.pop_front();
+					m_pending.fetch_sub(1);
+					return true;
+				}
+			}
+
+			if (!contended)
+			{
+				break;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::run(std::size_t index)
+	{
+		t_pool = this;
+		t_index = index;
+
+		while (true)
+		{
+			TaskType task;
+
+			if (pop(index, task))
+			{
+				try
+				{
+					task();
+				}
+				catch (...)
+				{
+					BLING_LOG_ERROR("ThreadPool", "Task failed: " << logging::currentException());
+				}
+
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (m_stop)
+			{
+				--m_active;
+				m_cv.notify_all();
+				break;
+			}
+
+			// Tasks counted in m_pending were taken by other workers between our scan and now
+			m_cv.wait(lock, [this]()
+			{
+				return m_stop || m_pending.load() > 0;
+			});
+		}
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../Patterns/PublisherSubscriber/Executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	namespace cup = utils::patterns;
+
+	// Fixed size pool with one deque per worker. Workers take their own newest task first
+	// and steal the oldest task of another worker when theirs is empty; tasks posted from
+	// outside the pool are spread round robin. Idle workers block, they never poll.
+	class ThreadPool : public cup::IExecutor
+	{
+	public:
+		ThreadPool(std::size_t threads = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		// The pool is unbounded, so the overflow policy is ignored
+		bool post(TaskType task, cup::OverflowPolicy overflow) override;
+		bool post(TaskType task);
+
+		void stop();
+
+		// Gives workers until the timeout to finish what is queued, then detaches the ones
+		// still busy and returns false. The pool must then outlive them.
+		bool stop(std::chrono::milliseconds timeout);
+
+		std::size_t size() const;
+
+		// Tasks posted and not started yet
+		std::size_t pending() const;
+	private:
+		struct Queue
+		{
+			std::deque<TaskType>	m_tasks;
+			std::mutex				m_mutex;
+		};
+
+		void run(std::size_t index);
+		bool pop(std::size_t index, TaskType& task);
+	private:
+		std::vector<std::unique_ptr<Queue>>	m_queues;
+		std::vector<std::thread>			m_threads;
+		std::atomic<std::size_t>			m_next;
+		std::atomic<long>					m_pending;
+		std::size_t							m_active = 0;
+		std::mutex							m_mutex;
+		std::condition_variable				m_cv;
+		bool								m_stop = false;
+	};
+}}}}
\ No newline at end of file
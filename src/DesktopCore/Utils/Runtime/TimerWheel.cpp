@@ -0,0 +1,275 @@
+#include "TimerWheel.h"
+
+#include "../Logging/Logger.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	Timer::Timer(TaskType task)
+	: m_task(std::move(task))
+	{
+
+	}
+
+	void Timer::cancel(bool wait)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_cancelled = true;
+
+		m_cv.wait(lock, [this, wait]()
+		{
+			return !wait || !m_running || m_runner == std::this_thread::get_id();
+		});
+	}
+
+	bool Timer::cancelled() const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		return m_cancelled;
+	}
+
+	void Timer::run()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (m_cancelled || m_running)
+			{
+				return;
+			}
+
+			m_running = true;
+			m_runner = std::this_thread::get_id();
+		}
+
+		try
+		{
+			m_task();
+		}
+		catch (...)
+		{
+			BLING_LOG_ERROR("TimerWheel", "Timer failed: " << logging::currentException());
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_running = false;
+			m_runner = std::thread::id();
+
+			// One shot; drop captured state as soon as possible
+			m_cancelled = true;
+			m_task = nullptr;
+		}
+
+		m_cv.notify_all();
+	}
+
+	TimerWheel::TimerWheel(std::shared_ptr<cup::IExecutor> executor, std::chrono::milliseconds tick)
+	: m_executor(executor)
+	, m_tick(tick)
+	, m_start(std::chrono::steady_clock::now())
+	{
+		m_thread = std::thread(&TimerWheel::run, this);
+	}
+
+	TimerWheel::~TimerWheel()
+	{
+		stop();
+	}
+
+	void TimerWheel::stop()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (m_stop)
+			{
+				return;
+			}
+
+			m_stop = true;
+		}
+
+		m_cv.notify_one();
+
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+	}
+
+	std::shared_ptr<Timer> TimerWheel::schedule(std::chrono::milliseconds delay, Timer::TaskType task)
+	{
+		auto timer = std::make_shared<Timer>(std::move(task));
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		if (m_stop)
+		{
+			timer->cancel();
+			return timer;
+		}
+
+		// Round up so a timer never fires early
+		TickType delta = std::max<TickType>(1, (delay.count() + m_tick.count() - 1) / m_tick.count());
+
+		insert({ ticks(std::chrono::steady_clock::now()) + delta, timer });
+
+		lock.unlock();
+		m_cv.notify_one();
+
+		return timer;
+	}
+
+	TimerWheel::TickType TimerWheel::ticks(std::chrono::steady_clock::time_point time) const
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(time - m_start).count() / m_tick.count();
+	}
+
+	void TimerWheel::insert(Entry entry)
+	{
+		++m_count;
+
+		TickType expiry = std::max(entry.m_expiry, m_now + 1);
+		TickType delta = expiry - m_now;
+
+		for (std::size_t level = 0; level < LEVELS; ++level)
+		{
+			if (delta < (TickType(1) << (BITS * (level + 1))))
+			{
+				m_wheels[level][(expiry >> (BITS * level)) & (SLOTS - 1)].push_back(entry);
+				return;
+			}
+		}
+
+		m_overflow.push_back(entry);
+	}
+
+	void TimerWheel::advance(TickType now, std::vector<std::shared_ptr<Timer>>& expired)
+	{
+		while (m_now < now)
+		{
+			++m_now;
+
+			// Cascade the higher levels whose slot boundary we just crossed, highest first
+			for (std::size_t level = LEVELS; level-- > 1; )
+			{
+				if (m_now & ((TickType(1) << (BITS * level)) - 1))
+				{
+					continue;
+				}
+
+				SlotType slot;
+				slot.swap(m_wheels[level][(m_now >> (BITS * level)) & (SLOTS - 1)]);
+
+				if (level == LEVELS - 1)
+				{
+					slot.insert(slot.end(), m_overflow.begin(), m_overflow.end());
+					m_overflow.clear();
+				}
+
+				for (auto& entry : slot)
+				{
+					--m_count;
+
+					if (entry.m_timer->cancelled())
+					{
+						continue;
+					}
+					else if (entry.m_expiry <= m_now)
+					{
+						expired.push_back(entry.m_timer);
+					}
+					else
+					{
+						insert(entry);
+					}
+				}
+			}
+
+			auto& slot = m_wheels[0][m_now & (SLOTS - 1)];
+
+			for (auto& entry : slot)
+			{
+				--m_count;
+
+				if (!entry.m_timer->cancelled())
+				{
+					expired.push_back(entry.m_timer);
+				}
+			}
+
+			slot.clear();
+		}
+	}
+
+	TimerWheel::TickType TimerWheel::nextWakeup() const
+	{
+		TickType next = std::numeric_limits<TickType>::max();
+
+		for (std::size_t level = 0; level < LEVELS; ++level)
+		{
+			TickType current = m_now >> (BITS * level);
+
+			for (TickType k = 1; k <= SLOTS; ++k)
+			{
+				if (!m_wheels[level][(current + k) & (SLOTS - 1)].empty())
+				{
+					next = std::min(next, (current + k) << (BITS * level));
+					break;
+				}
+			}
+		}
+
+		if (!m_overflow.empty())
+		{
+			// Overflowed timers are reconsidered whenever the top level cascades
+			TickType span = TickType(1) << (BITS * (LEVELS - 1));
+			next = std::min(next, ((m_now / span) + 1) * span);
+		}
+
+		return next;
+	}
+
+	void TimerWheel::run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (!m_stop)
+		{
+			std::vector<std::shared_ptr<Timer>> expired;
+
+			advance(ticks(std::chrono::steady_clock::now()), expired);
+
+			if (!expired.empty())
+			{
+				lock.unlock();
+
+				for (auto& timer : expired)
+				{
+					m_executor->post([timer]()
+					{
+						timer->run();
+					}, cup::OverflowPolicy::Backpressure);
+				}
+
+				lock.lock();
+				continue;
+			}
+
+			if (m_count == 0)
+			{
+				m_cv.wait(lock);
+			}
+			else
+			{
+				m_cv.wait_until(lock, m_start + m_tick * static_cast<long long>(nextWakeup()));
+			}
+		}
+	}
+}}}}
\ No newline at end of file
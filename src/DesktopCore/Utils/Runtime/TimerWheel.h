@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../Patterns/PublisherSubscriber/Executor.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace desktop { namespace core { namespace utils { namespace runtime {
+
+	namespace cup = utils::patterns;
+
+	// Handle of a scheduled callback
+	class Timer
+	{
+	public:
+		typedef std::function<void()> TaskType;
+
+		explicit Timer(TaskType task);
+
+		// No further runs once this returns. Waits for a callback that is already running,
+		// unless called from that callback or asked not to.
+		void cancel(bool wait = true);
+		bool cancelled() const;
+
+		void run();
+	private:
+		TaskType					m_task;
+		mutable std::mutex			m_mutex;
+		std::condition_variable		m_cv;
+		bool						m_cancelled = false;
+		bool						m_running = false;
+		std::thread::id				m_runner;
+	};
+
+	// Hierarchical timing wheel: LEVELS wheels of SLOTS slots, each slot of a level spanning
+	// a whole turn of the level below. Scheduling and cancelling are O(1). Expired timers are
+	// posted to the executor. The wheel thread sleeps until the next non-empty slot instead
+	// of waking on every tick, so idle timers cost no CPU wakeups.
+	class TimerWheel
+	{
+	public:
+		static const std::size_t BITS = 6;
+		static const std::size_t SLOTS = 1 << BITS;
+		static const std::size_t LEVELS = 4;
+
+		TimerWheel(std::shared_ptr<cup::IExecutor> executor, std::chrono::milliseconds tick = std::chrono::milliseconds(100));
+		~TimerWheel();
+
+		std::shared_ptr<Timer> schedule(std::chrono::milliseconds delay, Timer::TaskType task);
+		void stop();
+	private:
+		typedef unsigned long long TickType;
+
+		struct Entry
+		{
+			TickType				m_expiry;
+			std::shared_ptr<Timer>	m_timer;
+		};
+
+		typedef std::vector<Entry> SlotType;
+
+		void run();
+		void insert(Entry entry);
+		void advance(TickType now, std::vector<std::shared_ptr<Timer>>& expired);
+		TickType nextWakeup() const;
+		TickType ticks(std::chrono::steady_clock::time_point time) const;
+	private:
+		std::shared_ptr<cup::IExecutor>						m_executor;
+		std::chrono::milliseconds							m_tick;
+		std::chrono::steady_clock::time_point				m_start;
+		TickType											m_now = 0;
+		std::size_t											m_count = 0;
+		std::array<std::array<SlotType, SLOTS>, LEVELS>		m_wheels;
+		SlotType											m_overflow;
+		std::mutex											m_mutex;
+		std::condition_variable								m_cv;
+		std::thread											m_thread;
+		bool												m_stop = false;
+	};
+}}}}
\ No newline at end of file
@@ -0,0 +1,537 @@
+#include "TimeZone.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace desktop { namespace core { namespace utils { namespace timestamp {
+
+	namespace
+	{
+		const std::int64_t g_secondsPerDay = 86400;
+
+		// A day of the year in a POSIX rule and the local time the change happens at
+		struct RuleDate
+		{
+			char	m_kind = 'M';
+			int		m_month = 0;
+			int		m_week = 0;
+			int		m_day = 0;
+			int		m_time = 2 * 3600;
+		};
+
+		struct Rule
+		{
+			int			m_standard = 0;
+			int			m_daylight = 0;
+			bool		m_hasDaylight = false;
+			RuleDate	m_start;
+			RuleDate	m_end;
+		};
+
+		bool isDigit(char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		bool readNumber(const char*& p, const char* end, int& value)
+		{
+			if (p == end || !isDigit(*p))
+			{
+				return false;
+			}
+
+			value = 0;
+
+			while (p != end && isDigit(*p))
+			{
+				value = value * 10 + (*p++ - '0');
+			}
+
+			return true;
+		}
+
+		bool readName(const char*& p, const char* end)
+		{
+			const char* begin = p;
+
+			if (p != end && *p == '<')
+			{
+				p = std::find(p, end, '>');
+
+				if (p == end)
+				{
+					return false;
+				}
+
+				++p;
+			}
+			else
+			{
+				while (p != end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')))
+				{
+					++p;
+				}
+			}
+
+			return p != begin;
+		}
+
+		// [+-]hh[:mm[:ss]] in seconds
+		bool readTime(const char*& p, const char* end, int& seconds)
+		{
+			int sign = 1;
+
+			if (p != end && (*p == '+' || *p == '-'))
+			{
+				sign = *p++ == '-' ? -1 : 1;
+			}
+
+			int hours, minutes = 0, rest = 0;
+
+			if (!readNumber(p, end, hours))
+			{
+				return false;
+			}
+
+			if (p != end && *p == ':' && !readNumber(++p, end, minutes))
+			{
+				return false;
+			}
+
+			if (p != end && *p == ':' && !readNumber(++p, end, rest))
+			{
+				return false;
+			}
+
+			seconds = sign * (hours * 3600 + minutes * 60 + rest);
+
+			return true;
+		}
+
+		bool readDate(const char*& p, const char* end, RuleDate& date)
+		{
+			if (p != end && *p == 'M')
+			{
+				date.m_kind = 'M';
+
+				if (!readNumber(++p, end, date.m_month) || p == end || *p != '.' || !readNumber(++p, end, date.m_week) || p == end || *p != '.' ||
+					!readNumber(++p, end, date.m_day) || date.m_month < 1 || date.m_month > 12 || date.m_week < 1 || date.m_week > 5 || date.m_day > 6)
+				{
+					return false;
+				}
+			}
+			else if (p != end && *p == 'J')
+			{
+				date.m_kind = 'J';
+
+				if (!readNumber(++p, end, date.m_day) || date.m_day < 1 || date.m_day > 365)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				date.m_kind = 'N';
+
+				if (!readNumber(p, end, date.m_day) || date.m_day > 365)
+				{
+					return false;
+				}
+			}
+
+			if (p != end && *p == '/')
+			{
+				return readTime(++p, end, date.m_time);
+			}
+
+			return true;
+		}
+
+		bool readRule(const std::string& text, Rule& rule)
+		{
+			const char* p = text.data();
+			const char* end = p + text.size();
+
+			// Offsets in rules are west of UTC
+			if (!readName(p, end) || !readTime(p, end, rule.m_standard))
+			{
+				return false;
+			}
+
+			rule.m_standard = -rule.m_standard;
+
+			if (p == end)
+			{
+				return true;
+			}
+
+			if (!readName(p, end))
+			{
+				return false;
+			}
+
+			rule.m_hasDaylight = true;
+			rule.m_daylight = rule.m_standard + 3600;
+
+			if (p != end && *p != ',')
+			{
+				if (!readTime(p, end, rule.m_daylight))
+				{
+					return false;
+				}
+
+				rule.m_daylight = -rule.m_daylight;
+			}
+
+			// The POSIX default, United States rules
+			if (p == end)
+			{
+				const char* fallback = "M3.2.0,M11.1.0";
+				const char* last = fallback + std::strlen(fallback);
+
+				return readDate(fallback, last, rule.m_start) && *fallback++ == ',' && readDate(fallback, last, rule.m_end);
+			}
+
+			return *p == ',' && readDate(++p, end, rule.m_start) && p != end && *p == ',' && readDate(++p, end, rule.m_end) && p == end;
+		}
+
+		std::int64_t firstDay(int year, int month)
+		{
+			Timestamp date;
+			date.m_year = year;
+			date.m_month = month;
+
+			return toUniversal(date) / g_secondsPerDay;
+		}
+
+		bool isLeap(int year)
+		{
+			return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+		}
+
+		// Days since 1970-01-01 of date in year
+		std::int64_t dayOf(const RuleDate& date, int year)
+		{
+			if (date.m_kind == 'J')
+			{
+				// February 29th is never counted
+				return firstDay(year, 1) + date.m_day - 1 + (isLeap(year) && date.m_day >= 60 ? 1 : 0);
+			}
+			else if (date.m_kind == 'N')
+			{
+				return firstDay(year, 1) + date.m_day;
+			}
+
+			auto first = firstDay(year, date.m_month);
+			auto next = date.m_month == 12 ? firstDay(year + 1, 1) : firstDay(year, date.m_month + 1);
+
+			// 1970-01-01 was a Thursday
+			auto weekday = static_cast<int>((first + 4) % 7);
+			auto day = first + (date.m_day - weekday + 7) % 7 + (date.m_week - 1) * 7;
+
+			while (day >= next)
+			{
+				day -= 7;
+			}
+
+			return day;
+		}
+
+		std::uint32_t read32(const std::string& data, std::size_t offset)
+		{
+			std::uint32_t value = 0;
+
+			for (std::size_t i = 0; i < 4; ++i)
+			{
+				value = (value << 8) | static_cast<unsigned char>(data[offset + i]);
+			}
+
+			return value;
+		}
+
+		std::int64_t readTimeValue(const std::string& data, std::size_t offset, std::size_t size)
+		{
+			if (size == 4)
+			{
+				return static_cast<std::int32_t>(read32(data, offset));
+			}
+
+			return static_cast<std::int64_t>((static_cast<std::uint64_t>(read32(data, offset)) << 32) | read32(data, offset + 4));
+		}
+
+		int systemOffset(std::int64_t seconds)
+		{
+			return timestamp::toLocal(seconds).m_offset * 60;
+		}
+	}
+
+	const int TimeZone::LAST_YEAR;
+
+	TimeZone::TimeZone() = default;
+	TimeZone::~TimeZone() = default;
+
+	const TimeZone& TimeZone::local()
+	{
+		static const TimeZone zone = []()
+		{
+			TimeZone result;
+
+#ifndef _WIN32
+			const char* variable = std::getenv("TZ");
+			std::string name = variable ? variable : "";
+
+			if (!name.empty() && name[0] == ':')
+			{
+				name.erase(0, 1);
+			}
+
+			if (name.empty())
+			{
+				if (fromFile("/etc/localtime", result))
+				{
+					return result;
+				}
+			}
+			else if (fromFile(name[0] == '/' ? name : "/usr/share/zoneinfo/" + name, result) || fromRule(name, result))
+			{
+				return result;
+			}
+#endif
+			return fromSystem();
+		}();
+
+		return zone;
+	}
+
+	bool TimeZone::fromFile(const std::string& path, TimeZone& zone)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		const std::size_t header = 44;
+
+		if (data.size() < header || data.compare(0, 4, "TZif") != 0)
+		{
+			return false;
+		}
+
+		std::size_t position = 0, timeSize = 4;
+		bool footer = false;
+
+		auto counts = [&data](std::size_t at, std::size_t index)
+		{
+			return static_cast<std::size_t>(read32(data, at + 20 + index * 4));
+		};
+
+		auto bodySize = [&counts](std::size_t at, std::size_t size)
+		{
+			return counts(at, 3) * (size + 1) + counts(at, 4) * 6 + counts(at, 5) + counts(at, 2) * (size + 4) + counts(at, 1) + counts(at, 0);
+		};
+
+		// Version 2 and later repeat the data with 64-bit times, followed by a rule for later years
+		if (data[4] >= '2')
+		{
+			position = header + bodySize(0, 4);
+
+			if (data.size() < position + header || data.compare(position, 4, "TZif") != 0)
+			{
+				return false;
+			}
+
+			timeSize = 8;
+			footer = true;
+		}
+
+		std::size_t count = counts(position, 3), types = counts(position, 4);
+		std::size_t end = position + header + bodySize(position, timeSize);
+
+		if (data.size() < end || types == 0)
+		{
+			return false;
+		}
+
+		std::size_t times = position + header;
+		std::size_t indexes = times + count * timeSize;
+		std::size_t infos = indexes + count;
+
+		auto offsetOf = [&data, infos](std::size_t type)
+		{
+			return static_cast<int>(static_cast<std::int32_t>(read32(data, infos + type * 6)));
+		};
+
+		TimeZone result;
+		result.m_initial = offsetOf(0);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			auto type = static_cast<unsigned char>(data[indexes + i]);
+
+			if (type >= types)
+			{
+				return false;
+			}
+
+			auto offset = offsetOf(type);
+
+			if (offset != (result.m_transitions.empty() ? result.m_initial : result.m_transitions.back().m_offset))
+			{
+				result.m_transitions.push_back({ readTimeValue(data, times + i * timeSize, timeSize), offset });
+			}
+		}
+
+		if (footer && end < data.size() && data[end] == '\n')
+		{
+			auto last = data.find('\n', end + 1);
+
+			if (last != std::string::npos && last > end + 1)
+			{
+				result.extend(data.substr(end + 1, last - end - 1));
+			}
+		}
+
+		zone = std::move(result);
+
+		return true;
+	}
+
+	bool TimeZone::fromRule(const std::string& rule, TimeZone& zone)
+	{
+		TimeZone result;
+
+		if (!result.extend(rule))
+		{
+			return false;
+		}
+
+		zone = std::move(result);
+
+		return true;
+	}
+
+	TimeZone TimeZone::fromSystem()
+	{
+		TimeZone result;
+
+		Timestamp date;
+		auto begin = toUniversal(date);
+
+		date.m_year = LAST_YEAR + 1;
+		auto end = toUniversal(date);
+
+		result.m_initial = systemOffset(begin);
+
+		int current = result.m_initial;
+
+		// Changes are months apart, so a day is found first and then its second
+		for (auto day = begin; day < end; day += g_secondsPerDay)
+		{
+			auto next = systemOffset(day + g_secondsPerDay);
+
+			if (next != current)
+			{
+				auto low = day, high = day + g_secondsPerDay;
+
+				while (high - low > 1)
+				{
+					auto middle = low + (high - low) / 2;
+
+					(systemOffset(middle) == current ? low : high) = middle;
+				}
+
+				result.m_transitions.push_back({ high, next });
+				current = next;
+			}
+		}
+
+		return result;
+	}
+
+	int TimeZone::offset(std::int64_t seconds) const
+	{
+		auto it = std::upper_bound(m_transitions.begin(), m_transitions.end(), seconds, [](std::int64_t value, const Transition& transition)
+		{
+			return value < transition.m_at;
+		});
+
+		return it == m_transitions.begin() ? m_initial : (it - 1)->m_offset;
+	}
+
+	Timestamp TimeZone::toLocal(std::int64_t seconds) const
+	{
+		auto shift = offset(seconds);
+
+		auto result = fromUniversal(seconds + shift);
+		result.m_offset = shift / 60;
+
+		return result;
+	}
+
+	const std::vector<TimeZone::Transition>& TimeZone::transitions() const
+	{
+		return m_transitions;
+	}
+
+	bool TimeZone::extend(const std::string& text)
+	{
+		Rule rule;
+
+		if (!readRule(text, rule))
+		{
+			return false;
+		}
+
+		if (m_transitions.empty())
+		{
+			m_initial = rule.m_standard;
+		}
+
+		// The table already ends in the standard offset
+		if (!rule.m_hasDaylight)
+		{
+			return true;
+		}
+
+		int first = m_transitions.empty() ? 1970 : fromUniversal(m_transitions.back().m_at).m_year;
+
+		for (int year = first; year <= LAST_YEAR; ++year)
+		{
+			Transition start = { dayOf(rule.m_start, year) * g_secondsPerDay + rule.m_start.m_time - rule.m_standard, rule.m_daylight };
+			Transition end = { dayOf(rule.m_end, year) * g_secondsPerDay + rule.m_end.m_time - rule.m_daylight, rule.m_standard };
+
+			// Southern zones end daylight saving earlier in the year than they start it
+			if (end.m_at < start.m_at)
+			{
+				std::swap(start, end);
+
+				if (m_transitions.empty())
+				{
+					m_initial = rule.m_daylight;
+				}
+			}
+
+			for (auto& transition : { start, end })
+			{
+				if (!m_transitions.empty() && transition.m_at <= m_transitions.back().m_at)
+				{
+					continue;
+				}
+
+				if (transition.m_offset != (m_transitions.empty() ? m_initial : m_transitions.back().m_offset))
+				{
+					m_transitions.push_back(transition);
+				}
+			}
+		}
+
+		return true;
+	}
+}}}}
\ No newline at end of file
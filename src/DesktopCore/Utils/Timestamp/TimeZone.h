@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Timestamp.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace desktop { namespace core { namespace utils { namespace timestamp {
+
+	// Offsets of a time zone as a table of transitions, built once, so converting an instant is a
+	// binary search that is right on both sides of every daylight saving change, past or future.
+	class TimeZone
+	{
+	public:
+		struct Transition
+		{
+			std::int64_t	m_at;
+			// Seconds east of UTC from m_at on
+			int				m_offset;
+		};
+
+		static const int LAST_YEAR = 2100;
+
+		// The zone in TZ, or /etc/localtime, read from tzdata; sampled from the C library without it
+		static const TimeZone& local();
+
+		// TZif file, as found in /usr/share/zoneinfo. Rules in its footer are unrolled up to LAST_YEAR.
+		static bool fromFile(const std::string& path, TimeZone& zone);
+		// POSIX TZ rule, such as CET-1CEST,M3.5.0,M10.5.0/3
+		static bool fromRule(const std::string& rule, TimeZone& zone);
+		static TimeZone fromSystem();
+
+		TimeZone();
+		~TimeZone();
+
+		int offset(std::int64_t seconds) const;
+		Timestamp toLocal(std::int64_t seconds) const;
+
+		const std::vector<Transition>& transitions() const;
+	private:
+		bool extend(const std::string& rule);
+	private:
+		std::vector<Transition>		m_transitions;
+		int							m_initial = 0;
+	};
+}}}}
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include "Timestamp.h"
+
+namespace desktop { namespace core { namespace utils { namespace timestamp {
+
+	namespace
+	{
+		const std::int64_t g_secondsPerDay = 86400;
+
+		bool isDigit(char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		// Exactly count digits
+		bool readDigits(const char*& p, const char* end, int count, int& value)
+		{
+			if (end - p < count)
+			{
+				return false;
+			}
+
+			value = 0;
+
+			for (int i = 0; i < count; ++i, ++p)
+			{
+				if (!isDigit(*p))
+				{
+					return false;
+				}
+
+				value = value * 10 + (*p - '0');
+			}
+
+			return true;
+		}
+
+		bool expect(const char*& p, const char* end, char c)
+		{
+			if (p == end || *p != c)
+			{
+				return false;
+			}
+
+			++p;
+
+			return true;
+		}
+
+		void writeTwo(char*& p, int value)
+		{
+			*p++ = static_cast<char>('0' + value / 10);
+			*p++ = static_cast<char>('0' + value % 10);
+		}
+
+		bool isLeap(int year)
+		{
+			return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+		}
+
+		int daysInMonth(int year, int month)
+		{
+			static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+			return month == 2 && isLeap(year) ? 29 : days[month - 1];
+		}
+
+		// Proleptic Gregorian calendar, after Howard Hinnant's chrono-compatible algorithms
+		std::int64_t daysFromCivil(std::int64_t year, int month, int day)
+		{
+			year -= month <= 2;
+
+			const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+			const std::int64_t yearOfEra = year - era * 400;
+			const std::int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+			const std::int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+			return era * 146097 + dayOfEra - 719468;
+		}
+
+		void civilFromDays(std::int64_t days, Timestamp& result)
+		{
+			days += 719468;
+
+			const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+			const std::int64_t dayOfEra = days - era * 146097;
+			const std::int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+			const std::int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+			const std::int64_t shifted = (5 * dayOfYear + 2) / 153;
+
+			result.m_day = static_cast<int>(dayOfYear - (153 * shifted + 2) / 5 + 1);
+			result.m_month = static_cast<int>(shifted < 10 ? shifted + 3 : shifted - 9);
+			result.m_year = static_cast<int>(yearOfEra + era * 400 + (result.m_month <= 2));
+		}
+	}
+
+	bool parse(const char* text, std::size_t size, Timestamp& result)
+	{
+		const char* p = text;
+		const char* end = text + size;
+
+		Timestamp value;
+
+		bool negative = p != end && *p == '-';
+
+		if (negative)
+		{
+			++p;
+		}
+
+		int digits = 0;
+		value.m_year = 0;
+
+		while (p != end && isDigit(*p) && digits < 9)
+		{
+			value.m_year = value.m_year * 10 + (*p++ - '0');
+			++digits;
+		}
+
+		if (digits < 4)
+		{
+			return false;
+		}
+
+		if (negative)
+		{
+			value.m_year = -value.m_year;
+		}
+
+		if (!expect(p, end, '-') || !readDigits(p, end, 2, value.m_month) ||
+			!expect(p, end, '-') || !readDigits(p, end, 2, value.m_day) ||
+			!expect(p, end, 'T') || !readDigits(p, end, 2, value.m_hour) ||
+			!expect(p, end, ':') || !readDigits(p, end, 2, value.m_minute) ||
+			!expect(p, end, ':') || !readDigits(p, end, 2, value.m_second))
+		{
+			return false;
+		}
+
+		if (p != end && *p == '.')
+		{
+			++p;
+
+			if (p == end || !isDigit(*p))
+			{
+				return false;
+			}
+
+			while (p != end && isDigit(*p))
+			{
+				++p;
+			}
+		}
+
+		value.m_offset = 0;
+
+		if (p != end && *p == 'Z')
+		{
+			++p;
+		}
+		else if (p != end && (*p == '+' || *p == '-'))
+		{
+			int sign = *p++ == '-' ? -1 : 1;
+			int hours, minutes;
+
+			if (!readDigits(p, end, 2, hours) || !expect(p, end, ':') || !readDigits(p, end, 2, minutes) || hours > 23 || minutes > 59)
+			{
+				return false;
+			}
+
+			value.m_offset = sign * (hours * 60 + minutes);
+		}
+
+		if (p != end || value.m_month < 1 || value.m_month > 12 || value.m_day < 1 || value.m_day > daysInMonth(value.m_year, value.m_month) ||
+			value.m_hour > 23 || value.m_minute > 59 || value.m_second > 60)
+		{
+			return false;
+		}
+
+		result = value;
+
+		return true;
+	}
+
+	bool parse(const std::string& text, Timestamp& result)
+	{
+		return parse(text.data(), text.size(), result);
+	}
+
+	std::size_t format(const Timestamp& timestamp, char* out)
+	{
+		char* p = out;
+
+		std::int64_t year = timestamp.m_year;
+
+		if (year < 0)
+		{
+			*p++ = '-';
+			year = -year;
+		}
+
+		char reversed[12];
+		int count = 0;
+
+		do
+		{
+			reversed[count++] = static_cast<char>('0' + year % 10);
+			year /= 10;
+		}
+		while (year > 0);
+
+		while (count < 4)
+		{
+			reversed[count++] = '0';
+		}
+
+		while (count > 0)
+		{
+			*p++ = reversed[--count];
+		}
+
+		*p++ = '-';
+		writeTwo(p, timestamp.m_month);
+		*p++ = '-';
+		writeTwo(p, timestamp.m_day);
+		*p++ = 'T';
+		writeTwo(p, timestamp.m_hour);
+		*p++ = ':';
+		writeTwo(p, timestamp.m_minute);
+		*p++ = ':';
+		writeTwo(p, timestamp.m_second);
+
+		int offset = timestamp.m_offset;
+
+		*p++ = offset < 0 ? '-' : '+';
+
+		if (offset < 0)
+		{
+			offset = -offset;
+		}
+
+		writeTwo(p, offset / 60);
+		*p++ = ':';
+		writeTwo(p, offset % 60);
+
+		return static_cast<std::size_t>(p - out);
+	}
+
+	std::string toString(const Timestamp& timestamp)
+	{
+		char buffer[MAX_LENGTH];
+
+		return std::string(buffer, format(timestamp, buffer));
+	}
+
+	std::int64_t toUniversal(const Timestamp& timestamp)
+	{
+		return daysFromCivil(timestamp.m_year, timestamp.m_month, timestamp.m_day) * g_secondsPerDay +
+			timestamp.m_hour * 3600 + timestamp.m_minute * 60 + timestamp.m_second - timestamp.m_offset * 60;
+	}
+
+	Timestamp fromUniversal(std::int64_t seconds, int offset)
+	{
+		Timestamp result;
+
+		std::int64_t local = seconds + offset * 60;
+		std::int64_t days = local / g_secondsPerDay;
+		std::int64_t rest = local % g_secondsPerDay;
+
+		if (rest < 0)
+		{
+			rest += g_secondsPerDay;
+			--days;
+		}
+
+		civilFromDays(days, result);
+
+		result.m_hour = static_cast<int>(rest / 3600);
+		result.m_minute = static_cast<int>(rest % 3600 / 60);
+		result.m_second = static_cast<int>(rest % 60);
+		result.m_offset = offset;
+
+		return result;
+	}
+
+	Timestamp fromTm(const std::tm& tm, int offset)
+	{
+		Timestamp result;
+
+		result.m_year = tm.tm_year + 1900;
+		result.m_month = tm.tm_mon + 1;
+		result.m_day = tm.tm_mday;
+		result.m_hour = tm.tm_hour;
+		result.m_minute = tm.tm_min;
+		result.m_second = tm.tm_sec;
+		result.m_offset = offset;
+
+		return result;
+	}
+
+	Timestamp toLocal(std::int64_t seconds)
+	{
+		std::time_t time = static_cast<std::time_t>(seconds);
+		std::tm tm;
+
+#ifdef _WIN32
+		if (localtime_s(&tm, &time) != 0)
+#else
+		if (localtime_r(&time, &tm) == nullptr)
+#endif
+		{
+			return fromUniversal(seconds);
+		}
+
+		auto result = fromTm(tm);
+
+		// The civil fields read as UTC are ahead of the instant by the offset
+		result.m_offset = static_cast<int>((toUniversal(result) - seconds) / 60);
+
+		return result;
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace desktop { namespace core { namespace utils { namespace timestamp {
+
+	// Civil time of an ISO-8601 timestamp such as 2019-04-20T17:38:24+00:00, with its offset from
+	// UTC in minutes. Parsing and formatting work on the caller's buffers and never allocate, so
+	// they can run once per clip or snapshot without going through streams and locales.
+	struct Timestamp
+	{
+		int m_year = 1970;
+		int m_month = 1;
+		int m_day = 1;
+		int m_hour = 0;
+		int m_minute = 0;
+		int m_second = 0;
+		int m_offset = 0;
+	};
+
+	// Longest text written by format, for a signed year of nine digits
+	const std::size_t MAX_LENGTH = 32;
+
+	// Accepts yyyy-mm-ddThh:mm:ss, a fraction that is dropped, and Z, +hh:mm, -hh:mm or no zone.
+	// The year may be negative, like the -999999999 used when nothing was synced yet.
+	bool parse(const char* text, std::size_t size, Timestamp& result);
+	bool parse(const std::string& text, Timestamp& result);
+
+	// Writes yyyy-mm-ddThh:mm:ss+hh:mm without terminator and returns its length
+	std::size_t format(const Timestamp& timestamp, char* out);
+	std::string toString(const Timestamp& timestamp);
+
+	// Seconds since 1970-01-01T00:00:00Z
+	std::int64_t toUniversal(const Timestamp& timestamp);
+	Timestamp fromUniversal(std::int64_t seconds, int offset = 0);
+	Timestamp fromTm(const std::tm& tm, int offset = 0);
+
+	// Civil time in the local time zone, with the offset in effect at that instant
+	Timestamp toLocal(std::int64_t seconds);
+}}}}
\ No newline at end of file
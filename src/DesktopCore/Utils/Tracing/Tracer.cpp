@@ -0,0 +1,132 @@
+#include "Tracer.h"
+
+#include <sstream>
+
+namespace desktop { namespace core { namespace utils { namespace tracing {
+
+	namespace
+	{
+		// Rings of threads that have exited are kept until this many more have exited
+		const std::size_t g_retiredLimit = 16;
+	}
+
+	Tracer& Tracer::get()
+	{
+		// Leaked so that threads exiting after main can still retire their ring
+		static Tracer* S = new Tracer();
+		return *S;
+	}
+
+	Tracer::Tracer()
+	: m_origin(std::chrono::steady_clock::now())
+	{
+
+	}
+
+	Tracer::Holder::~Holder()
+	{
+		if (m_buffer)
+		{
+			Tracer::get().retire(m_buffer);
+		}
+	}
+
+	Tracer::Buffer& Tracer::local()
+	{
+		thread_local Holder t_holder;
+
+		if (!t_holder.m_buffer)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			t_holder.m_buffer = std::make_shared<Buffer>(++m_nextThread);
+			m_buffers.push_back(t_holder.m_buffer);
+		}
+
+		return *t_holder.m_buffer;
+	}
+
+	void Tracer::retire(const std::shared_ptr<Buffer>& buffer)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it)
+		{
+			if (*it == buffer)
+			{
+				m_buffers.erase(it);
+				break;
+			}
+		}
+
+		m_retired.push_back(buffer);
+
+		if (m_retired.size() > g_retiredLimit)
+		{
+			m_retired.erase(m_retired.begin());
+		}
+	}
+
+	void Tracer::record(const char* category, const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		auto& buffer = local();
+
+		Event event;
+		event.m_category = category;
+		event.m_name = name;
+		event.m_start = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(start - m_origin).count());
+		event.m_duration = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+
+		std::unique_lock<std::mutex> lock(buffer.m_mutex);
+
+		buffer.m_events[buffer.m_next % CAPACITY] = event;
+		++buffer.m_next;
+	}
+
+	std::string Tracer::dump() const
+	{
+		std::vector<std::shared_ptr<Buffer>> buffers;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			buffers = m_retired;
+			buffers.insert(buffers.end(), m_buffers.begin(), m_buffers.end());
+		}
+
+		std::stringstream ss;
+		ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		bool first = true;
+
+		for (auto& buffer : buffers)
+		{
+			std::vector<Event> events;
+
+			{
+				std::unique_lock<std::mutex> lock(buffer->m_mutex);
+
+				auto begin = buffer->m_next > CAPACITY ? buffer->m_next - CAPACITY : 0;
+
+				for (auto i = begin; i < buffer->m_next; ++i)
+				{
+					events.push_back(buffer->m_events[i % CAPACITY]);
+				}
+			}
+
+			for (auto& event : events)
+			{
+				ss << (first ? "" : ",")
+					<< "{\"name\":\"" << event.m_name << "\",\"cat\":\"" << event.m_category << "\",\"ph\":\"X\""
+					<< ",\"ts\":" << event.m_start << ",\"dur\":" << event.m_duration
+					<< ",\"pid\":1,\"tid\":" << buffer->m_thread << "}";
+
+				first = false;
+			}
+		}
+
+		ss << "]}";
+
+		return ss.str();
+	}
+}}}}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Build with BLING_TRACING=0 to compile every BLING_TRACE_SPAN out
+#ifndef BLING_TRACING
+#define BLING_TRACING 1
+#endif
+
+namespace desktop { namespace core { namespace utils { namespace tracing {
+
+	// Scoped spans kept in a fixed ring per thread and dumped in the Chrome trace event
+	// format, which about:tracing and Perfetto open. Recording a span reads the clock twice
+	// and takes the lock of its own thread, which only a dump ever contends for.
+	class Tracer
+	{
+	public:
+		static const std::size_t CAPACITY = 4096;
+
+		// Category and name must be string literals, they are kept as pointers
+		struct Event
+		{
+			const char*			m_category;
+			const char*			m_name;
+			unsigned long long	m_start;
+			unsigned long long	m_duration;
+		};
+
+		static Tracer& get();
+
+		void record(const char* category, const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+		// Events of every thread still in its ring, as a JSON object
+		std::string dump() const;
+	private:
+		struct Buffer
+		{
+			explicit Buffer(unsigned int thread) : m_thread(thread) {}
+
+			const unsigned int				m_thread;
+			std::mutex						m_mutex;
+			std::array<Event, CAPACITY>		m_events;
+			unsigned long long				m_next = 0;
+		};
+
+		struct Holder
+		{
+			~Holder();
+
+			std::shared_ptr<Buffer>	m_buffer;
+		};
+
+		Tracer();
+		Tracer(const Tracer&) = delete;
+		Tracer& operator=(const Tracer&) = delete;
+
+		Buffer& local();
+		void retire(const std::shared_ptr<Buffer>& buffer);
+	private:
+		const std::chrono::steady_clock::time_point	m_origin;
+		mutable std::mutex							m_mutex;
+		std::vector<std::shared_ptr<Buffer>>		m_buffers;
+		std::vector<std::shared_ptr<Buffer>>		m_retired;
+		unsigned int								m_nextThread = 0;
+	};
+
+	class Span
+	{
+	public:
+		Span(const char* category, const char* name)
+		: m_category(category)
+		, m_name(name)
+		, m_start(std::chrono::steady_clock::now())
+		{
+
+		}
+
+		~Span()
+		{
+			Tracer::get().record(m_category, m_name, m_start, std::chrono::steady_clock::now());
+		}
+
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+	private:
+		const char*								m_category;
+		const char*								m_name;
+		std::chrono::steady_clock::time_point	m_start;
+	};
+}}}}
+
+#if BLING_TRACING
+#define BLING_TRACE_CONCAT_(a, b) a##b
+#define BLING_TRACE_CONCAT(a, b) BLING_TRACE_CONCAT_(a, b)
+#define BLING_TRACE_SPAN(category, name) ::desktop::core::utils::tracing::Span BLING_TRACE_CONCAT(bling_span_, __LINE__)(category, name)
+#else
+#define BLING_TRACE_SPAN(category, name) ((void)0)
+#endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "DesktopCore/DesktopCore.h"
+#include "DesktopCore/Network/Agents/CredentialsAgent.h"
+#include "DesktopCore/Network/Agents/FileServerAgent.h"
+#include "DesktopCore/Blink/Agents/SyncVideoAgent.h"
+#include "DesktopCore/Blink/Agents/SyncThumbnailAgent.h"
+#include "DesktopCore/Blink/Agents/LiveViewAgent.h"
+#include "DesktopCore/System/Services/ApplicationDataService.h"
+#include "DesktopCore/System/Services/IniFileService.h"
+#include "DesktopCore/System/Services/SecretFileService.h"
+#include "DesktopCore/Utils/Logging/Logger.h"
+#include "DesktopCore/Utils/Runtime/StartupTimeline.h"
+
+#include <csignal>
+#include <pthread.h>
+
+// Headless DesktopCore: no browser, no viewer upgrade. Credentials come from the
+// credentials file or from POST /_credentials, which must carry the secret kept in
+// [Credentials] SecretFile. Runs until SIGINT or SIGTERM.
+int main()
+{
+	desktop::core::utils::runtime::StartupTimeline::get().mark("process");
+
+	// Blocked before any thread exists, so every thread inherits the mask and
+	// only the sigwait below ever sees them
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	{
+		desktop::core::DesktopCore core;
+
+		core.initialize();
+
+		// The file server and the credentials agent publish credentials, which are lost if the
+		// Blink agents have not subscribed yet
+		std::vector<std::string> credentialsUsers = {"SyncVideoAgent", "SyncThumbnailAgent"};
+
+		core.addAgents({
+			{"SyncVideoAgent", []() { return std::make_unique<desktop::core::agent::SyncVideoAgent>(); }},
+			{"SyncThumbnailAgent", []() { return std::make_unique<desktop::core::agent::SyncThumbnailAgent>(); }},
+			{"LiveViewAgent", []() { return std::make_unique<desktop::core::agent::LiveViewAgent>(); }},
+			{"FileServerAgent", []() -> std::unique_ptr<desktop::core::model::IAgent>
+				{
+					auto agent = std::make_unique<desktop::core::agent::FileServerAgent>();
+
+					auto documents = desktop::core::service::ApplicationDataService().getMyDocuments();
+					auto path = desktop::core::service::IniFileService().get<std::string>(documents + "Bling.ini", "Credentials", "SecretFile", documents + "credentials.secret");
+
+					std::string secret;
+
+					if (desktop::core::service::SecretFileService().read(path, secret))
+					{
+						agent->acceptCredentials(secret);
+					}
+					else
+					{
+						BLING_LOG_ERROR("Daemon", "POST /_credentials disabled, no usable secret in " << path);
+					}
+
+					return std::move(agent);
+				}, credentialsUsers},
+			{"CredentialsAgent", []() { return std::make_unique<desktop::core::agent::CredentialsAgent>(); }, credentialsUsers}
+		});
+
+		int signal = 0;
+		sigwait(&signals, &signal);
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "DesktopCore/System/Services/BinaryPatchService.h"
+#include "DesktopCore/System/Services/SignatureService.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+	std::string read(const boost::filesystem::path& path)
+	{
+		std::ifstream file(path.string(), std::ios::in | std::ios::binary);
+
+		if (!file.is_open())
+		{
+			throw std::runtime_error("cannot read " + path.string());
+		}
+
+		return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	}
+
+	void write(const boost::filesystem::path& path, const std::string& content)
+	{
+		std::ofstream file(path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!file.write(content.data(), content.size()))
+		{
+			throw std::runtime_error("cannot write " + path.string());
+		}
+	}
+}
+
+// Writes the assets UpgradeDesktopAgent reads from a release: update.json and a patch from each
+// older installer, named <version>.exe as the agent keeps them. The manifest is signed afterwards
+// with the private half of DesktopApp/update.pem:
+//   openssl dgst -sha256 -sign update-private.pem -out update.json.sig update.json
+int main(int argc, char* argv[])
+{
+	if (argc < 4)
+	{
+		std::cerr << "Usage: bling-release <version> <installer> <output folder> [<old version>.exe ...]" << std::endl;
+		return 2;
+	}
+
+	try
+	{
+		std::string version = argv[1];
+		boost::filesystem::path installer(argv[2]);
+		boost::filesystem::path output(argv[3]);
+
+		desktop::core::service::BinaryPatchService patchService;
+		desktop::core::service::SignatureService signatureService;
+
+		auto target = read(installer);
+		auto digest = signatureService.sha256(target);
+
+		boost::property_tree::ptree manifest, patches;
+
+		manifest.put("version", version);
+		manifest.put("installer", installer.filename().string());
+		manifest.put("sha256", digest);
+
+		boost::filesystem::create_directories(output);
+
+		for (int i = 4; i < argc; ++i)
+		{
+			boost::filesystem::path old(argv[i]);
+
+			auto from = old.stem().string();
+			auto source = read(old);
+			auto patch = patchService.diff(source, target);
+
+			// A patch the updater would reject must not be published
+			std::string result;
+
+			if (!patchService.apply(source, patch, result) || signatureService.sha256(result) != digest)
+			{
+				std::cerr << "Patch from " << from << " does not rebuild " << installer.filename().string() << std::endl;
+				return 1;
+			}
+
+			auto name = from + "-" + version + ".patch";
+
+			write(output / name, patch);
+
+			// Versions contain dots, which put would take for a path
+			patches.push_back(std::make_pair(from, boost::property_tree::ptree(name)));
+
+			std::cout << name << ": " << patch.size() << " bytes instead of " << target.size() << std::endl;
+		}
+
+		if (!patches.empty())
+		{
+			manifest.add_child("patches", patches);
+		}
+
+		boost::property_tree::json_parser::write_json((output / "update.json").string(), manifest);
+
+		std::cout << "update.json: " << version << ", sha256 " << digest << std::endl;
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "Test.h"
+
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Subscriber.h"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	namespace sup = desktop::core::utils::patterns;
+
+	constexpr sup::EventType CONTENTION_EVENT = sup::makeEventType("CONTENTION_EVENT");
+	struct ContentionEvent : public sup::Event
+	{
+		ContentionEvent()
+		{
+			m_name = CONTENTION_EVENT;
+		}
+
+		int m_value = 0;
+	};
+
+	const std::size_t PUBLISHES = 2000000;
+
+	// Every thread publishes PUBLISHES events at once; the time is per publish, over all threads
+	void contend(const std::string& label, unsigned int threads, std::atomic<unsigned long long>& delivered)
+	{
+		std::atomic<bool> go(false);
+		std::vector<std::thread> publishers;
+
+		delivered = 0;
+
+		for (unsigned int i = 0; i < threads; ++i)
+		{
+			publishers.emplace_back([&go]()
+			{
+				ContentionEvent evt;
+
+				while (!go)
+				{
+					std::this_thread::yield();
+				}
+
+				for (std::size_t n = 0; n < PUBLISHES; ++n)
+				{
+					evt.m_value = static_cast<int>(n);
+					sup::Broker::get().publish(evt);
+				}
+			});
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		go = true;
+
+		for (auto& publisher : publishers)
+		{
+			publisher.join();
+		}
+
+		double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (PUBLISHES * threads);
+
+		std::stringstream text;
+		text << label << ", " << threads << " threads";
+
+		desktop::tests::report(text.str(), nanoseconds);
+
+		BLING_CHECK(delivered == 0 || delivered == PUBLISHES * threads);
+	}
+
+	void contend(const std::string& label, std::atomic<unsigned long long>& delivered)
+	{
+		for (unsigned int threads : {1u, 2u, 4u, 8u})
+		{
+			contend(label, threads, delivered);
+		}
+	}
+}
+
+// Broker::publish from several threads at once, which used to serialize on the subscription
+// mutex; the same event with no subscriber, a typed one and an untyped one
+BLING_BENCHMARK(BrokerPublishContention)
+{
+	std::atomic<unsigned long long> delivered(0);
+
+	contend("no subscriber", delivered);
+
+	{
+		sup::Subscriber subscriber;
+		subscriber.subscribe<ContentionEvent>("BrokerPublishContention", [&delivered](const ContentionEvent&)
+		{
+			delivered.fetch_add(1, std::memory_order_relaxed);
+		});
+
+		contend("typed subscriber", delivered);
+	}
+
+	{
+		sup::Subscriber subscriber;
+		subscriber.subscribe("BrokerPublishContention", [&delivered](const sup::Event&)
+		{
+			delivered.fetch_add(1, std::memory_order_relaxed);
+		}, CONTENTION_EVENT);
+
+		contend("untyped subscriber", delivered);
+	}
+}
\ No newline at end of file
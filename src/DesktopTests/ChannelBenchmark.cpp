@@ -0,0 +1,111 @@
+#include "Test.h"
+
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <boost/signals2/signal.hpp>
+
+namespace
+{
+	namespace sup = desktop::core::utils::patterns;
+
+	constexpr sup::EventType COMPARISON_EVENT = sup::makeEventType("COMPARISON_EVENT");
+	struct ComparisonEvent : public sup::Event
+	{
+		ComparisonEvent()
+		{
+			m_name = COMPARISON_EVENT;
+		}
+
+		int m_value = 0;
+	};
+
+	const std::size_t PUBLISHES = 10000000;
+}
+
+// A publisher only posts to an executor subscriber, even while that subscriber is busy with the previous event
+BLING_TEST(ChannelPublishDoesNotWaitForExecutor)
+{
+	auto& broker = sup::Broker::get();
+	broker.registerExecutor("ChannelTest", std::make_shared<sup::QueueExecutor>());
+
+	std::promise<void> started, release;
+	auto released = release.get_future().share();
+	std::atomic<int> calls{ 0 };
+
+	{
+		auto connection = sup::Channel<ComparisonEvent>::get().subscribe("ChannelTest", [&started, released, &calls](const ComparisonEvent&)
+		{
+			if (calls++ == 0)
+			{
+				started.set_value();
+				released.wait();
+			}
+		}, sup::DeliveryPolicy::executor("ChannelTest"));
+
+		broker.publish(ComparisonEvent());
+		started.get_future().wait();
+
+		auto second = std::async(std::launch::async, [&broker]()
+		{
+			broker.publish(ComparisonEvent());
+		});
+
+		BLING_CHECK(second.wait_for(std::chrono::seconds(1)) == std::future_status::ready);
+
+		release.set_value();
+	}
+
+	broker.unregisterExecutor("ChannelTest");
+}
+
+// One handler, published to through Broker into Channel<EventT>, against the signals2 signal
+// with a std::function slot and a static_cast that subscribers used before
+BLING_BENCHMARK(ChannelAgainstSignals2)
+{
+	long long sum = 0;
+
+	{
+		auto connection = sup::Channel<ComparisonEvent>::get().subscribe("ChannelAgainstSignals2", [&sum](const ComparisonEvent& evt)
+		{
+			sum += evt.m_value;
+		});
+
+		ComparisonEvent evt;
+
+		desktop::tests::measure("Broker::publish into Channel", PUBLISHES, [&evt](std::size_t i)
+		{
+			evt.m_value = static_cast<int>(i & 1);
+			sup::Broker::get().publish(evt);
+		});
+	}
+
+	long long expected = sum;
+	sum = 0;
+
+	{
+		boost::signals2::signal<void (const sup::Event&)> signal;
+
+		std::function<void (const sup::Event&)> callback = [&sum](const sup::Event& evt)
+		{
+			sum += static_cast<const ComparisonEvent&>(evt).m_value;
+		};
+
+		signal.connect(callback);
+
+		ComparisonEvent evt;
+
+		desktop::tests::measure("signals2 with std::function and static_cast", PUBLISHES, [&evt, &signal](std::size_t i)
+		{
+			evt.m_value = static_cast<int>(i & 1);
+			signal(evt);
+		});
+	}
+
+	BLING_CHECK(sum == expected);
+	BLING_CHECK(sum == static_cast<long long>(PUBLISHES / 2));
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "Test.h"
+
+#include "System/Services/DeltaFolderService.h"
+
+#include <ctime>
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+namespace
+{
+	using desktop::core::service::DeltaFolderService;
+
+	void write(const boost::filesystem::path& path, const std::string& content)
+	{
+		boost::filesystem::create_directories(path.parent_path());
+		std::ofstream(path.string(), std::ios::binary | std::ios::trunc) << content;
+	}
+}
+
+// An edit that keeps the size is hashed again, and a replace cut short between its renames is rolled back
+BLING_TEST(DeltaFolderRehashesAndRecovers)
+{
+	auto folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	auto output = folder / "Viewer";
+
+	DeltaFolderService service;
+
+	write(folder / "Input" / "index.html", "first");
+	BLING_CHECK(service.replace((folder / "Input").string(), output.string() + "/"));
+
+	auto before = service.load(output.string());
+
+	write(output / "index.html", "other");
+	boost::filesystem::last_write_time(output / "index.html", std::time(nullptr) + 10);
+
+	auto after = service.load(output.string());
+
+	BLING_CHECK(before["index.html"].first == after["index.html"].first);
+	BLING_CHECK(before["index.html"].second != after["index.html"].second);
+	BLING_CHECK(after == service.hash(output.string()));
+
+	boost::filesystem::rename(output, folder / "Viewer.old");
+
+	BLING_CHECK(service.recover(output.string() + "/"));
+	BLING_CHECK(boost::filesystem::exists(output / "index.html"));
+	BLING_CHECK(!boost::filesystem::exists(folder / "Viewer.old"));
+
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(folder, ec);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "Test.h"
+
+#include "System/Services/IniFileService.h"
+
+#include <fstream>
+#include <iterator>
+#include <boost/filesystem.hpp>
+
+// A write to a file that cannot be saved, here because a file is in the way of its folder, stays
+// pending and is saved once it can be
+BLING_TEST(IniFileCacheKeepsFailedWrites)
+{
+	auto folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	auto path = (folder / "Bling.ini").string();
+
+	std::ofstream(folder.string()) << "in the way";
+
+	desktop::core::service::IniFileService ini;
+
+	BLING_CHECK(ini.set<std::string>(path, "Test", "Value", "first"));
+	BLING_CHECK(!desktop::core::service::IniFileCache::get().flush());
+	BLING_CHECK(!boost::filesystem::exists(path));
+
+	BLING_CHECK(!ini.set<std::string>(path, "Test", "Other", "second"));
+	BLING_CHECK(ini.get<std::string>(path, "Test", "Value", "") == "first");
+
+	boost::filesystem::remove(folder);
+
+	BLING_CHECK(desktop::core::service::IniFileCache::get().flush());
+	BLING_CHECK(boost::filesystem::exists(path));
+	BLING_CHECK(ini.set<std::string>(path, "Test", "Value", "third"));
+	BLING_CHECK(desktop::core::service::IniFileCache::get().flush());
+
+	std::ifstream file(path);
+	std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	BLING_CHECK(content.find("Value=third") != std::string::npos);
+	BLING_CHECK(content.find("Other=second") != std::string::npos);
+
+	file.close();
+
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(folder, ec);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "Test.h"
+
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+#include "Utils/Patterns/PublisherSubscriber/Subscriber.h"
+
+#include <thread>
+
+namespace
+{
+	namespace sup = desktop::core::utils::patterns;
+
+	constexpr sup::EventType SLOW_EVENT = sup::makeEventType("SLOW_EVENT");
+	struct SlowEvent : public sup::Event
+	{
+		SlowEvent()
+		{
+			m_name = SLOW_EVENT;
+		}
+	};
+}
+
+// Slow handlers are reported by the name they subscribed with, not by the type of their lambda
+BLING_TEST(InstrumentationNamesSlowHandlers)
+{
+	auto& instrumentation = sup::Instrumentation::get();
+
+	instrumentation.setSampleRate(1);
+	instrumentation.setSlowThreshold(std::chrono::milliseconds(1));
+
+	{
+		sup::Subscriber subscriber;
+		subscriber.subscribe<SlowEvent>("InstrumentationTest", [](const SlowEvent&)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		});
+
+		sup::Broker::get().publish(SlowEvent());
+	}
+
+	instrumentation.setSampleRate(16);
+	instrumentation.setSlowThreshold(std::chrono::milliseconds(100));
+
+	auto snapshot = instrumentation.snapshot();
+
+	BLING_CHECK(!snapshot.m_recentSlow.empty());
+	BLING_CHECK(!snapshot.m_recentSlow.empty() && snapshot.m_recentSlow.back().m_handler == "InstrumentationTest");
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "Test.h"
+
+#include "Network/JournalCodecs.h"
+#include "Utils/Patterns/PublisherSubscriber/Broker.h"
+
+#include <boost/filesystem.hpp>
+
+namespace
+{
+	namespace sup = desktop::core::utils::patterns;
+	namespace events = desktop::core::events;
+
+	void login(const std::string& token)
+	{
+		sup::Broker::get().publish(events::CredentialsEvent(std::make_shared<const desktop::core::model::Credentials>("rest-prod.immedia-semi.com", "443", token, "1234")));
+	}
+
+	std::vector<std::string> replay()
+	{
+		std::vector<std::string> tokens;
+
+		sup::Journal::get().replay<events::CredentialsEvent>([&tokens](const events::CredentialsEvent& evt)
+		{
+			tokens.push_back(evt.m_credentials->m_token);
+		});
+
+		return tokens;
+	}
+}
+
+// The last login survives a restart and is replayed to every agent that starts, as often as they start
+BLING_TEST(JournalReplaysLastLogin)
+{
+	auto folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	auto path = (folder / "events.log").string();
+
+	auto& journal = sup::Journal::get();
+
+	BLING_CHECK(journal.open(path));
+	journal.enable<events::CredentialsEvent>(sup::Journal::Options(true, 1));
+
+#ifndef _WIN32
+	// The records hold the token; boost does not read ACLs, so only checked on POSIX
+	BLING_CHECK((boost::filesystem::status(path).permissions() & (boost::filesystem::group_all | boost::filesystem::others_all)) == 0);
+#endif
+
+	login("first");
+	login("second");
+	login("second");
+
+	journal.close();
+
+	BLING_CHECK(journal.open(path));
+	journal.enable<events::CredentialsEvent>(sup::Journal::Options(true, 1));
+
+	BLING_CHECK(replay() == std::vector<std::string>({"second"}));
+	BLING_CHECK(replay() == std::vector<std::string>({"second"}));
+
+	journal.close();
+
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(folder, ec);
+}
\ No newline at end of file
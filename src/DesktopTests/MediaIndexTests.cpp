@@ -0,0 +1,81 @@
+#include "Test.h"
+
+#include "Blink/Services/MediaIndex.h"
+#include "Network/Services/CredentialsStore.h"
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+namespace
+{
+	using desktop::core::service::MediaIndex;
+
+	std::string clip(const std::string& name)
+	{
+		return "https://rest-prod.immedia-semi.com/api/v2/accounts/1/media/clip/" + name + ".mp4";
+	}
+
+	std::string save(const std::string& path)
+	{
+		std::ofstream(path, std::ios::binary) << std::string(100, 'x');
+		return path;
+	}
+}
+
+// Played copies stay under the limit, least recently played first, and a synced clip replaces its copy
+BLING_TEST(MediaIndexEvictsLeastRecentlyPlayed)
+{
+	auto folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	auto index = (folder / "media.index").string();
+	auto cache = (folder / "Cache/").string();
+
+	auto& media = MediaIndex::get();
+	desktop::core::service::CredentialsStore::get().update("rest-prod.immedia-semi.com", "443", "token", "1");
+
+	BLING_CHECK(media.open(index, cache, 250));
+	boost::filesystem::create_directories(cache);
+
+	media.add(clip("a"), save(media.cachePath(clip("a"))));
+	media.add(clip("b"), save(media.cachePath(clip("b"))));
+	BLING_CHECK(!media.find(clip("a")).empty());
+
+	auto evicted = media.cachePath(clip("b"));
+	media.add(clip("c"), save(media.cachePath(clip("c"))));
+
+	BLING_CHECK(media.find(clip("b")).empty());
+	BLING_CHECK(!boost::filesystem::exists(evicted));
+	BLING_CHECK(!media.find(clip("a")).empty());
+	BLING_CHECK(!media.find(clip("c")).empty());
+
+	auto copy = media.cachePath(clip("c"));
+	auto synced = save((folder / "c.mp4").string());
+	media.add(clip("c"), synced);
+
+	BLING_CHECK(media.find(clip("c")) == synced);
+	BLING_CHECK(!boost::filesystem::exists(copy));
+
+	// Copies the index does not list, like a download cut short, are deleted on the next start
+	auto partial = save(media.cachePath(clip("d")) + ".1.partial");
+
+	BLING_CHECK(media.open(index, cache, 250));
+	BLING_CHECK(!boost::filesystem::exists(partial));
+	BLING_CHECK(media.find(clip("a")) == media.cachePath(clip("a")));
+	BLING_CHECK(media.find(clip("b")).empty());
+	BLING_CHECK(media.find(clip("c")) == synced);
+
+	// Pages of other hosts neither get a clip from disk nor put one in the cache
+	auto other = "https://example.com/api/v2/accounts/1/media/clip/a.mp4";
+
+	BLING_CHECK(media.find(other).empty());
+	BLING_CHECK(media.cachePath(other).empty());
+	BLING_CHECK(media.find("http://rest-prod.immedia-semi.com/api/v2/accounts/1/media/clip/a.mp4").empty());
+	BLING_CHECK(media.find("/api/v2/accounts/1/media/clip/a.mp4") == media.cachePath(clip("a")));
+
+	BLING_CHECK(media.open(index, cache, 0));
+	BLING_CHECK(media.cachePath(clip("e")).empty());
+	BLING_CHECK(media.find(clip("a")).empty());
+	BLING_CHECK(media.find(clip("c")) == synced);
+
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(folder, ec);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace desktop { namespace tests {
+
+	// Tests run by default; benchmarks only with --bench, as they take seconds and print timings
+	struct Case
+	{
+		const char*				m_name;
+		std::function<void ()>	m_run;
+		bool					m_benchmark;
+	};
+
+	std::vector<Case>& cases();
+
+	struct Registration
+	{
+		Registration(const char* name, std::function<void ()> run, bool benchmark);
+	};
+
+	void fail(const char* file, int line, const std::string& expression);
+	void report(const std::string& label, double nanoseconds);
+
+	// Runs the body iterations times and prints the time per iteration
+	template<typename BodyT>
+	double measure(const std::string& label, std::size_t iterations, BodyT body)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (std::size_t i = 0; i < iterations; ++i)
+		{
+			body(i);
+		}
+
+		double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+		report(label, nanoseconds);
+
+		return nanoseconds;
+	}
+
+	// Keeps the optimizer from dropping a result nobody reads
+	void consume(const void* value);
+
+	// Calls to operator new so far, on every thread
+	std::size_t allocations();
+}}
+
+#define BLING_TEST(name) \
+	static void name(); \
+	static desktop::tests::Registration name##Registration(#name, &name, false); \
+	static void name()
+
+#define BLING_BENCHMARK(name) \
+	static void name(); \
+	static desktop::tests::Registration name##Registration(#name, &name, true); \
+	static void name()
+
+#define BLING_CHECK(expression) do { if (!(expression)) { desktop::tests::fail(__FILE__, __LINE__, #expression); } } while (false)
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "Test.h"
+
+#include "Utils/Timestamp/TimeZone.h"
+#include "System/Services/TimeZoneService.h"
+
+#include <boost/filesystem.hpp>
+
+namespace
+{
+	namespace ts = desktop::core::utils::timestamp;
+
+	std::int64_t at(const char* text)
+	{
+		ts::Timestamp value;
+		ts::parse(text, value);
+
+		return ts::toUniversal(value);
+	}
+
+	// The second before a transition still has the old offset and the transition itself the new one
+	bool changes(const ts::TimeZone& zone, const char* universal, const char* before, const char* after)
+	{
+		auto seconds = at(universal);
+
+		return ts::toString(zone.toLocal(seconds - 1)) == before && ts::toString(zone.toLocal(seconds)) == after;
+	}
+}
+
+BLING_TEST(TimeZoneRuleTransitions)
+{
+	ts::TimeZone europe;
+	BLING_CHECK(ts::TimeZone::fromRule("CET-1CEST,M3.5.0,M10.5.0/3", europe));
+	BLING_CHECK(changes(europe, "2019-03-31T01:00:00Z", "2019-03-31T01:59:59+01:00", "2019-03-31T03:00:00+02:00"));
+	BLING_CHECK(changes(europe, "2019-10-27T01:00:00Z", "2019-10-27T02:59:59+02:00", "2019-10-27T02:00:00+01:00"));
+	BLING_CHECK(changes(europe, "2099-10-25T01:00:00Z", "2099-10-25T02:59:59+02:00", "2099-10-25T02:00:00+01:00"));
+
+	ts::TimeZone america;
+	BLING_CHECK(ts::TimeZone::fromRule("EST5EDT,M3.2.0,M11.1.0", america));
+	BLING_CHECK(changes(america, "2019-03-10T07:00:00Z", "2019-03-10T01:59:59-05:00", "2019-03-10T03:00:00-04:00"));
+	BLING_CHECK(changes(america, "2019-11-03T06:00:00Z", "2019-11-03T01:59:59-04:00", "2019-11-03T01:00:00-05:00"));
+
+	// Southern hemisphere, where summer time spans the new year
+	ts::TimeZone australia;
+	BLING_CHECK(ts::TimeZone::fromRule("AEST-10AEDT,M10.1.0,M4.1.0/3", australia));
+	BLING_CHECK(changes(australia, "2019-04-06T16:00:00Z", "2019-04-07T02:59:59+11:00", "2019-04-07T02:00:00+10:00"));
+	BLING_CHECK(changes(australia, "2019-10-05T16:00:00Z", "2019-10-06T01:59:59+10:00", "2019-10-06T03:00:00+11:00"));
+	BLING_CHECK(australia.offset(at("2020-01-01T00:00:00Z")) == 11 * 3600);
+
+	ts::TimeZone newfoundland;
+	BLING_CHECK(ts::TimeZone::fromRule("NST3:30NDT,M3.2.0,M11.1.0", newfoundland));
+	BLING_CHECK(changes(newfoundland, "2019-03-10T05:30:00Z", "2019-03-10T01:59:59-03:30", "2019-03-10T03:00:00-02:30"));
+
+	ts::TimeZone utc;
+	BLING_CHECK(ts::TimeZone::fromRule("UTC0", utc));
+	BLING_CHECK(utc.transitions().empty());
+	BLING_CHECK(ts::toString(utc.toLocal(at("2019-04-20T17:38:24Z"))) == "2019-04-20T17:38:24+00:00");
+
+	BLING_CHECK(!ts::TimeZone::fromRule("", utc));
+}
+
+// Same transitions read from tzdata, where it is installed
+BLING_TEST(TimeZoneFileTransitions)
+{
+	const std::string path = "/usr/share/zoneinfo/Europe/Madrid";
+
+	if (!boost::filesystem::exists(path))
+	{
+		return;
+	}
+
+	ts::TimeZone madrid;
+	BLING_CHECK(ts::TimeZone::fromFile(path, madrid));
+	BLING_CHECK(changes(madrid, "2019-03-31T01:00:00Z", "2019-03-31T01:59:59+01:00", "2019-03-31T03:00:00+02:00"));
+	BLING_CHECK(changes(madrid, "2099-03-29T01:00:00Z", "2099-03-29T01:59:59+01:00", "2099-03-29T03:00:00+02:00"));
+	BLING_CHECK(changes(madrid, "2099-10-25T01:00:00Z", "2099-10-25T02:59:59+02:00", "2099-10-25T02:00:00+01:00"));
+}
+
+// Clip file names carry this suffix, so it must stay the current offset as UTC minus local
+BLING_TEST(TimeZoneServiceSuffix)
+{
+	const auto& zone = ts::TimeZone::local();
+
+	ts::Timestamp suffix;
+	suffix.m_offset = -zone.toLocal(std::time(nullptr)).m_offset;
+
+	auto expected = ts::toString(suffix).substr(19);
+
+	for (auto universal : {"2019-01-20T17:38:24+00:00", "2019-07-20T17:38:24+00:00"})
+	{
+		auto local = desktop::core::service::TimeZoneService().universalToLocal(universal);
+
+		BLING_CHECK(local.substr(19) == expected);
+
+		// The wall clock time uses the offset of the instant itself
+		auto wall = zone.toLocal(at(universal));
+		wall.m_offset = suffix.m_offset;
+
+		BLING_CHECK(local == ts::toString(wall));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "Test.h"
+
+#include "Utils/Timestamp/Timestamp.h"
+#include "System/Services/TimeZoneService.h"
+#include "System/Services/TimestampFolderService.h"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace
+{
+	namespace ts = desktop::core::utils::timestamp;
+
+	const std::size_t CALLS = 1000000;
+	const char* const SAMPLE = "2019-04-20T17:38:24+00:00";
+}
+
+BLING_TEST(TimestampRoundTrip)
+{
+	for (auto text : {"2019-04-20T17:38:24+00:00", "1970-01-01T00:00:00+00:00", "2000-02-29T23:59:59-03:30", "-999999999-01-01T00:00:00+00:00"})
+	{
+		ts::Timestamp value;
+
+		BLING_CHECK(ts::parse(text, value));
+		BLING_CHECK(ts::toString(value) == text);
+	}
+
+	ts::Timestamp value;
+
+	BLING_CHECK(ts::parse("2019-04-20T17:38:24.123Z", value));
+	BLING_CHECK(ts::toString(value) == "2019-04-20T17:38:24+00:00");
+	BLING_CHECK(ts::toUniversal(value) == 1555781904);
+	BLING_CHECK(ts::toString(ts::fromUniversal(1555781904, 120)) == "2019-04-20T19:38:24+02:00");
+
+	BLING_CHECK(!ts::parse("2019-04-20 17:38:24", value));
+	BLING_CHECK(!ts::parse("2019-13-20T17:38:24Z", value));
+	BLING_CHECK(!ts::parse("", value));
+}
+
+BLING_TEST(TimestampDoesNotAllocate)
+{
+	char text[ts::MAX_LENGTH];
+	ts::Timestamp value;
+	std::size_t length = 0;
+
+	auto before = desktop::tests::allocations();
+
+	for (int i = 0; i < 100; ++i)
+	{
+		ts::parse(SAMPLE, std::strlen(SAMPLE), value);
+		value = ts::fromUniversal(ts::toUniversal(value) + i, 60);
+		length = ts::format(value, text);
+	}
+
+	BLING_CHECK(desktop::tests::allocations() == before);
+	BLING_CHECK(std::string(text, length) == "2019-04-20T18:40:03+01:00");
+}
+
+// The hand-written parser and formatter against the locale facet and setw streams they replaced,
+// and the services that clips and snapshots go through
+BLING_BENCHMARK(TimestampParseAndFormat)
+{
+	ts::Timestamp value;
+	char text[ts::MAX_LENGTH];
+
+	desktop::tests::measure("parse", CALLS, [&value](std::size_t)
+	{
+		ts::parse(SAMPLE, 25, value);
+		desktop::tests::consume(&value);
+	});
+
+	desktop::tests::measure("parse with a time_input_facet, as before", CALLS / 100, [](std::size_t)
+	{
+		const std::locale loc = std::locale(std::locale::classic(), new boost::posix_time::time_input_facet("%Y-%m-%dT%H:%M:%S+00:00"));
+		std::istringstream is(SAMPLE);
+		is.imbue(loc);
+
+		boost::posix_time::ptime universal;
+		is >> universal;
+
+		desktop::tests::consume(&universal);
+	});
+
+	desktop::tests::measure("format", CALLS, [&value, &text](std::size_t i)
+	{
+		value.m_second = static_cast<int>(i % 60);
+		ts::format(value, text);
+		desktop::tests::consume(text);
+	});
+
+	desktop::tests::measure("format with setw and setfill, as before", CALLS / 10, [&value](std::size_t i)
+	{
+		std::stringstream ss;
+		ss << value.m_year << "-" << std::setw(2) << std::setfill('0') << value.m_month << "-" << std::setw(2) << std::setfill('0') << value.m_day
+			<< "T" << std::setw(2) << std::setfill('0') << value.m_hour << ":" << std::setw(2) << std::setfill('0') << value.m_minute
+			<< ":" << std::setw(2) << std::setfill('0') << (i % 60) << "+00:00";
+
+		desktop::tests::consume(ss.str().c_str());
+	});
+
+	desktop::core::service::TimeZoneService timeZone;
+	desktop::core::service::TimestampFolderService folder;
+
+	desktop::tests::measure("TimeZoneService::universalToLocal", CALLS / 10, [&timeZone](std::size_t)
+	{
+		desktop::tests::consume(timeZone.universalToLocal(SAMPLE).c_str());
+	});
+
+	desktop::tests::measure("TimestampFolderService::get", CALLS / 10, [&folder](std::size_t)
+	{
+		desktop::tests::consume(folder.get(SAMPLE).c_str());
+	});
+}
\ No newline at end of file
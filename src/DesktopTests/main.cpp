@@ -0,0 +1,134 @@
+#include "Test.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+
+namespace desktop { namespace tests {
+
+	namespace
+	{
+		std::size_t g_failures = 0;
+		std::atomic<const void*> g_sink(nullptr);
+		std::atomic<std::size_t> g_allocations(0);
+	}
+
+	std::vector<Case>& cases()
+	{
+		static std::vector<Case> S;
+		return S;
+	}
+
+	Registration::Registration(const char* name, std::function<void ()> run, bool benchmark)
+	{
+		cases().push_back({name, std::move(run), benchmark});
+	}
+
+	void fail(const char* file, int line, const std::string& expression)
+	{
+		++g_failures;
+
+		std::cout << "    " << file << "(" << line << "): failed " << expression << std::endl;
+	}
+
+	void report(const std::string& label, double nanoseconds)
+	{
+		char text[32];
+		std::snprintf(text, sizeof(text), "%10.1f ns", nanoseconds);
+
+		std::cout << "    " << text << "  " << label << std::endl;
+	}
+
+	void consume(const void* value)
+	{
+		g_sink.store(value, std::memory_order_relaxed);
+	}
+
+	std::size_t allocations()
+	{
+		return g_allocations.load();
+	}
+}}
+
+// Counted so tests can check that a code path does not allocate
+void* operator new(std::size_t size)
+{
+	desktop::tests::g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* memory = std::malloc(size == 0 ? 1 : size))
+	{
+		return memory;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+// bling-tests [--bench] [filter]: runs the tests, or the benchmarks, whose name contains filter.
+// Exits with 1 when a check failed.
+int main(int argc, char* argv[])
+{
+	using namespace desktop::tests;
+
+	bool benchmark = false;
+	const char* filter = "";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--bench") == 0)
+		{
+			benchmark = true;
+		}
+		else
+		{
+			filter = argv[i];
+		}
+	}
+
+	std::size_t run = 0;
+
+	for (const auto& test : cases())
+	{
+		if (test.m_benchmark != benchmark || std::strstr(test.m_name, filter) == nullptr)
+		{
+			continue;
+		}
+
+		auto failures = g_failures;
+
+		std::cout << test.m_name << std::endl;
+
+		try
+		{
+			test.m_run();
+		}
+		catch (const std::exception& e)
+		{
+			fail(test.m_name, 0, std::string("threw ") + e.what());
+		}
+
+		if (g_failures != failures)
+		{
+			std::cout << "  FAILED" << std::endl;
+		}
+
+		++run;
+	}
+
+	std::cout << run << (benchmark ? " benchmarks, " : " tests, ") << g_failures << " failed checks" << std::endl;
+
+	return g_failures == 0 ? 0 : 1;
+}
\ No newline at end of file